@@ -21,6 +21,7 @@
  * \ingroup mantaflow
  */
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -35,7 +36,9 @@
 #include "smoke_script.h"
 
 #include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
 #include "BLI_path_util.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_fluid_types.h"
@@ -66,6 +69,9 @@ MANTA::MANTA(int *res, FluidModifierData *fmd)
   FluidDomainSettings *fds = fmd->domain;
   fds->fluid = this;
 
+  mPrefetchPool = nullptr;
+  mPrefetchPending = 0;
+
   mUsingLiquid = (fds->type == FLUID_DOMAIN_TYPE_LIQUID);
   mUsingSmoke = (fds->type == FLUID_DOMAIN_TYPE_GAS);
   mUsingNoise = (fds->flags & FLUID_DOMAIN_USE_NOISE) && mUsingSmoke;
@@ -560,6 +566,11 @@ MANTA::~MANTA()
     cout << "~FLUID: " << mCurrentID << " with res(" << mResX << ", " << mResY << ", " << mResZ
          << ")" << endl;
 
+  if (mPrefetchPool) {
+    BLI_task_pool_cancel(mPrefetchPool);
+    BLI_task_pool_free(mPrefetchPool);
+  }
+
   /* Destruction string for Python. */
   string tmpString = "";
   vector<string> pythonCommands;
@@ -1275,6 +1286,8 @@ bool MANTA::readData(FluidModifierData *fmd, int framenr, bool resumable)
        << ", '" << volume_format << "', " << resumable_cache << ")";
     pythonCommands.push_back(ss.str());
     result &= runPythonString(pythonCommands);
+    if (result && !resumable)
+      prefetchFrames(fmd, FLUID_DOMAIN_DIR_DATA, framenr);
     return (mSmokeFromFile = result);
   }
   if (mUsingLiquid) {
@@ -1283,6 +1296,8 @@ bool MANTA::readData(FluidModifierData *fmd, int framenr, bool resumable)
        << ", '" << volume_format << "', " << resumable_cache << ")";
     pythonCommands.push_back(ss.str());
     result &= runPythonString(pythonCommands);
+    if (result && !resumable)
+      prefetchFrames(fmd, FLUID_DOMAIN_DIR_DATA, framenr);
     return (mFlipFromFile = result);
   }
   return result;
@@ -1317,7 +1332,10 @@ bool MANTA::readNoise(FluidModifierData *fmd, int framenr, bool resumable)
      << ", '" << volume_format << "', " << resumable_cache << ")";
   pythonCommands.push_back(ss.str());
 
-  return (mNoiseFromFile = runPythonString(pythonCommands));
+  mNoiseFromFile = runPythonString(pythonCommands);
+  if (mNoiseFromFile && !resumable)
+    prefetchFrames(fmd, FLUID_DOMAIN_DIR_NOISE, framenr);
+  return mNoiseFromFile;
 }
 
 bool MANTA::readMesh(FluidModifierData *fmd, int framenr)
@@ -1352,7 +1370,10 @@ bool MANTA::readMesh(FluidModifierData *fmd, int framenr)
     pythonCommands.push_back(ss.str());
   }
 
-  return (mMeshFromFile = runPythonString(pythonCommands));
+  mMeshFromFile = runPythonString(pythonCommands);
+  if (mMeshFromFile)
+    prefetchFrames(fmd, FLUID_DOMAIN_DIR_MESH, framenr);
+  return mMeshFromFile;
 }
 
 bool MANTA::readParticles(FluidModifierData *fmd, int framenr, bool resumable)
@@ -1386,7 +1407,10 @@ bool MANTA::readParticles(FluidModifierData *fmd, int framenr, bool resumable)
      << ", '" << volume_format << "', " << resumable_cache << ")";
   pythonCommands.push_back(ss.str());
 
-  return (mParticlesFromFile = runPythonString(pythonCommands));
+  mParticlesFromFile = runPythonString(pythonCommands);
+  if (mParticlesFromFile && !resumable)
+    prefetchFrames(fmd, FLUID_DOMAIN_DIR_PARTICLES, framenr);
+  return mParticlesFromFile;
 }
 
 bool MANTA::readGuiding(FluidModifierData *fmd, int framenr, bool sourceDomain)
@@ -2274,3 +2298,94 @@ string MANTA::getFile(
   BLI_path_frame(targetFile, framenr, 0);
   return targetFile;
 }
+
+/* Number of frames after a loaded one whose cache files are read in the background. */
+#define FLUID_PREFETCH_FRAMES 2
+
+struct FluidPrefetchTask {
+  string file;
+  atomic<int> *pending;
+};
+
+static void fluid_prefetch_task(TaskPool *__restrict pool, void *taskdata)
+{
+  const FluidPrefetchTask *task = (const FluidPrefetchTask *)taskdata;
+
+  FILE *fp = BLI_fopen(task->file.c_str(), "rb");
+  if (!fp)
+    return;
+
+  /* Reading the file is enough for the OS to keep it in its file cache. The actual load
+   * decompresses it from memory then, instead of waiting on the storage. */
+  vector<char> buffer(1 << 20);
+  while (!BLI_task_pool_current_canceled(pool) &&
+         fread(buffer.data(), 1, buffer.size(), fp) == buffer.size()) {
+  }
+  fclose(fp);
+}
+
+static void fluid_prefetch_task_free(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  FluidPrefetchTask *task = (FluidPrefetchTask *)taskdata;
+  (*task->pending)--;
+  delete task;
+}
+
+void MANTA::prefetchFrames(FluidModifierData *fmd, string subdirectory, int framenr)
+{
+  FluidDomainSettings *fds = fmd->domain;
+  const int frame_last = std::min(framenr + FLUID_PREFETCH_FRAMES, fds->cache_frame_end);
+
+  if (framenr < 0 || framenr >= frame_last)
+    return;
+
+  /* Drop requests while files of a previous one are still being read. */
+  if (mPrefetchPending > 0)
+    return;
+
+  /* The names of the files per frame are looked up once from the directory contents, using the
+   * frame that was just loaded. All frames of a cache use the same names. */
+  string directory = getDirectory(fmd, subdirectory);
+  auto names = mPrefetchNames.find(directory);
+  if (names == mPrefetchNames.end()) {
+    vector<pair<string, string>> frame_names;
+    char frame_suffix[FILE_MAX] = "_####.";
+    BLI_path_frame(frame_suffix, framenr, 0);
+
+    struct direntry *filelist;
+    const unsigned int totfile = BLI_filelist_dir_contents(directory.c_str(), &filelist);
+    for (unsigned int i = 0; i < totfile; i++) {
+      const string relname = filelist[i].relname;
+      const size_t pos = relname.rfind(frame_suffix);
+      if (pos == string::npos || pos == 0)
+        continue;
+      /* Extension including the leading dot. */
+      const size_t ext = pos + strlen(frame_suffix) - 1;
+      frame_names.emplace_back(relname.substr(0, pos), relname.substr(ext));
+    }
+    BLI_filelist_free(filelist, totfile);
+
+    names = mPrefetchNames.emplace(directory, frame_names).first;
+  }
+
+  if (names->second.empty())
+    return;
+
+  if (!mPrefetchPool)
+    mPrefetchPool = BLI_task_pool_create_background(this, TASK_PRIORITY_LOW);
+
+  /* One task per file, so reads from network storage overlap. */
+  for (int frame = framenr + 1; frame <= frame_last; frame++) {
+    for (const pair<string, string> &name : names->second) {
+      FluidPrefetchTask *task = new FluidPrefetchTask;
+      task->file = getFile(fmd, subdirectory, name.first, name.second, frame);
+      task->pending = &mPrefetchPending;
+      mPrefetchPending++;
+      BLI_task_pool_push(mPrefetchPool, fluid_prefetch_task, task, true, fluid_prefetch_task_free);
+    }
+  }
+
+  if (with_debug)
+    cout << "Fluid: Prefetching " << names->second.size() << " files per frame in " << directory
+         << endl;
+}
@@ -28,9 +28,11 @@
 #include <cassert>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 using std::atomic;
+using std::pair;
 using std::string;
 using std::unordered_map;
 using std::vector;
@@ -886,6 +888,14 @@ struct MANTA {
                  string fname,
                  string extension,
                  int framenr);
+
+  /* Background reading of the cache files of upcoming frames, so they are in the OS file cache
+   * by the time the frames are loaded. */
+  struct TaskPool *mPrefetchPool;
+  atomic<int> mPrefetchPending;
+  /* Name and extension of the files per frame in each cache subdirectory. */
+  unordered_map<string, vector<pair<string, string>>> mPrefetchNames;
+  void prefetchFrames(struct FluidModifierData *fmd, string subdirectory, int framenr);
 };
 
 #endif
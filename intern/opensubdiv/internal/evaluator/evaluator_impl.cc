@@ -33,6 +33,9 @@
 #include <opensubdiv/osd/cpuVertexBuffer.h>
 #include <opensubdiv/osd/mesh.h>
 #include <opensubdiv/osd/types.h>
+#ifdef OPENSUBDIV_HAS_TBB
+#  include <opensubdiv/osd/tbbEvaluator.h>
+#endif
 #include <opensubdiv/version.h>
 
 #include "MEM_guardedalloc.h"
@@ -52,6 +55,9 @@ using OpenSubdiv::Osd::CpuEvaluator;
 using OpenSubdiv::Osd::CpuPatchTable;
 using OpenSubdiv::Osd::CpuVertexBuffer;
 using OpenSubdiv::Osd::PatchCoord;
+#ifdef OPENSUBDIV_HAS_TBB
+using OpenSubdiv::Osd::TbbEvaluator;
+#endif
 
 namespace blender {
 namespace opensubdiv {
@@ -551,6 +557,29 @@ void convertPatchCoordsToArray(const OpenSubdiv_PatchCoord *patch_coords,
   }
 }
 
+// CPU evaluator which evaluates stencils from multiple threads when possible.
+//
+// Stencils are evaluated for all refined vertices at once when coarse positions change, which is
+// worth threading. Patches are evaluated for a few coordinates at a time from code which is
+// already threaded on Blender side, so they keep using the regular CPU evaluator.
+class BlenderCpuEvaluator : public CpuEvaluator {
+#ifdef OPENSUBDIV_HAS_TBB
+ public:
+  template<typename SRC_BUFFER, typename DST_BUFFER, typename STENCIL_TABLE>
+  static bool EvalStencils(SRC_BUFFER *src_buffer,
+                           const BufferDescriptor &src_desc,
+                           DST_BUFFER *dst_buffer,
+                           const BufferDescriptor &dst_desc,
+                           const STENCIL_TABLE *stencil_table,
+                           const BlenderCpuEvaluator * /*instance*/ = NULL,
+                           void * /*device_context*/ = NULL)
+  {
+    return TbbEvaluator::EvalStencils(
+        src_buffer, src_desc, dst_buffer, dst_desc, stencil_table);
+  }
+#endif
+};
+
 }  // namespace
 
 // Note: Define as a class instead of typedcef to make it possible
@@ -559,7 +588,7 @@ class CpuEvalOutput : public VolatileEvalOutput<CpuVertexBuffer,
                                                 CpuVertexBuffer,
                                                 StencilTable,
                                                 CpuPatchTable,
-                                                CpuEvaluator> {
+                                                BlenderCpuEvaluator> {
  public:
   CpuEvalOutput(const StencilTable *vertex_stencils,
                 const StencilTable *varying_stencils,
@@ -571,7 +600,7 @@ class CpuEvalOutput : public VolatileEvalOutput<CpuVertexBuffer,
                            CpuVertexBuffer,
                            StencilTable,
                            CpuPatchTable,
-                           CpuEvaluator>(vertex_stencils,
+                           BlenderCpuEvaluator>(vertex_stencils,
                                          varying_stencils,
                                          all_face_varying_stencils,
                                          face_varying_width,
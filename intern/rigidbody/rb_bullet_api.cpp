@@ -53,6 +53,8 @@
 #include <errno.h>
 #include <stdio.h>
 
+#include <functional>
+
 #include "RBI_api.h"
 
 #include "btBulletDynamicsCommon.h"
@@ -67,12 +69,31 @@
 #include "BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h"
 #include "BulletCollision/Gimpact/btGImpactShape.h"
 
+#ifdef WITH_BULLET_THREADS
+#  include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#  include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#  include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#  include "LinearMath/btThreads.h"
+
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+
+#  include <tbb/blocked_range.h>
+#  include <tbb/global_control.h>
+#  include <tbb/parallel_for.h>
+#  include <tbb/parallel_reduce.h>
+#  include <tbb/task_arena.h>
+#endif
+
 struct rbDynamicsWorld {
   btDiscreteDynamicsWorld *dynamicsWorld;
   btDefaultCollisionConfiguration *collisionConfiguration;
   btDispatcher *dispatcher;
   btBroadphaseInterface *pairCache;
   btConstraintSolver *constraintSolver;
+  /* Solver for large islands in the multi-threaded world, NULL otherwise. */
+  btConstraintSolver *constraintSolverMt;
   btOverlapFilterCallback *filterCallback;
 };
 struct rbRigidBody {
@@ -131,6 +152,145 @@ static inline void copy_quat_btquat(float quat[4], const btQuaternion &btquat)
   quat[3] = btquat.getZ();
 }
 
+#ifdef WITH_BULLET_THREADS
+/* Runs Bullet's parallel loops with TBB, sharing the worker threads of the rest of Blender.
+ *
+ * Bullet sizes its per-thread storage by #getNumThreads and indexes it with
+ * btGetCurrentThreadIndex(), which hands every thread that asks a permanent index from a global
+ * counter and wraps back to 1 once BT_MAX_THREAD_COUNT threads asked. Indexes are never given
+ * back, so only a fixed set of threads may call into Bullet: the world thread below and the TBB
+ * workers, which live as long as the process. */
+struct rbTaskScheduler : public btITaskScheduler {
+  tbb::task_arena arena;
+
+  rbTaskScheduler() : btITaskScheduler("TBB"), arena(BT_MAX_THREAD_COUNT - 1)
+  {
+  }
+
+  virtual int getMaxNumThreads() const
+  {
+    return BT_MAX_THREAD_COUNT - 1;
+  }
+  virtual int getNumThreads() const
+  {
+    return BT_MAX_THREAD_COUNT - 1;
+  }
+  virtual void setNumThreads(int /*numThreads*/)
+  {
+  }
+
+  virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody &body)
+  {
+    arena.execute([&]() {
+      tbb::parallel_for(tbb::blocked_range<int>(iBegin, iEnd, grainSize),
+                        [&](const tbb::blocked_range<int> &range) {
+                          body.forLoop(range.begin(), range.end());
+                        });
+    });
+  }
+
+  virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody &body)
+  {
+    btScalar sum = btScalar(0);
+    arena.execute([&]() {
+      sum = tbb::parallel_reduce(
+          tbb::blocked_range<int>(iBegin, iEnd, grainSize),
+          btScalar(0),
+          [&](const tbb::blocked_range<int> &range, btScalar partial_sum) {
+            return partial_sum + body.sumLoop(range.begin(), range.end());
+          },
+          [](btScalar a, btScalar b) { return a + b; });
+    });
+    return sum;
+  }
+};
+
+/* A thread that lives as long as the process and makes all Bullet calls that can ask for a
+ * thread index, like stepping and sweep tests. Callers from any thread, e.g. bake jobs, wait for
+ * it. It's the arena's master in the parallel loops, so it also makes progress without workers. */
+class rbWorldThread {
+  std::mutex call_mutex_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  const std::function<void()> *job_ = NULL;
+  bool job_done_ = false;
+
+  void loop()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      cond_.wait(lock, [this]() { return job_ != NULL && !job_done_; });
+      const std::function<void()> *job = job_;
+      lock.unlock();
+      (*job)();
+      lock.lock();
+      job_done_ = true;
+      cond_.notify_all();
+    }
+  }
+
+ public:
+  rbWorldThread()
+  {
+    /* Never joined, the thread waits for work until the process exits. */
+    std::thread(&rbWorldThread::loop, this).detach();
+  }
+
+  void run(const std::function<void()> &job)
+  {
+    std::lock_guard<std::mutex> call_lock(call_mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_ = &job;
+    job_done_ = false;
+    cond_.notify_all();
+    cond_.wait(lock, [this]() { return job_done_; });
+    job_ = NULL;
+  }
+};
+
+/* Set when the threaded worlds are used, NULL otherwise. */
+static rbWorldThread *rb_world_thread = NULL;
+
+/* Install the scheduler once. The worlds stay single threaded when the TBB workers and the world
+ * thread could need more indexes than Bullet has, or when Bullet doesn't accept the scheduler:
+ * it has to be installed by the first thread asking for an index. */
+static bool rb_threads_available()
+{
+  static std::once_flag init_flag;
+
+  std::call_once(init_flag, []() {
+    /* The workers, plus the world thread in place of the thread that starts the parallelism. */
+    const size_t max_threads = tbb::global_control::active_value(
+        tbb::global_control::max_allowed_parallelism);
+    if (max_threads > BT_MAX_THREAD_COUNT - 1) {
+      return;
+    }
+
+    rbTaskScheduler *scheduler = new rbTaskScheduler();
+    rbWorldThread *world_thread = new rbWorldThread();
+    world_thread->run([scheduler]() { btSetTaskScheduler(scheduler); });
+
+    if (btGetTaskScheduler() == scheduler) {
+      rb_world_thread = world_thread;
+    }
+  });
+
+  return rb_world_thread != NULL;
+}
+#endif
+
+/* Make a call that can ask Bullet for a thread index, see #rbWorldThread. */
+static void rb_world_call(const std::function<void()> &fn)
+{
+#ifdef WITH_BULLET_THREADS
+  if (rb_world_thread) {
+    rb_world_thread->run(fn);
+    return;
+  }
+#endif
+  fn();
+}
+
 /* ********************************** */
 /* Dynamics World Methods */
 
@@ -140,10 +300,22 @@ rbDynamicsWorld *RB_dworld_new(const float gravity[3])
 {
   rbDynamicsWorld *world = new rbDynamicsWorld;
 
+#ifdef WITH_BULLET_THREADS
+  const bool use_threads = rb_threads_available();
+#endif
+
   /* collision detection/handling */
   world->collisionConfiguration = new btDefaultCollisionConfiguration();
 
-  world->dispatcher = new btCollisionDispatcher(world->collisionConfiguration);
+#ifdef WITH_BULLET_THREADS
+  if (use_threads) {
+    world->dispatcher = new btCollisionDispatcherMt(world->collisionConfiguration);
+  }
+  else
+#endif
+  {
+    world->dispatcher = new btCollisionDispatcher(world->collisionConfiguration);
+  }
   btGImpactCollisionAlgorithm::registerAlgorithm((btCollisionDispatcher *)world->dispatcher);
 
   world->pairCache = new btDbvtBroadphase();
@@ -151,12 +323,35 @@ rbDynamicsWorld *RB_dworld_new(const float gravity[3])
   world->filterCallback = new rbFilterCallback();
   world->pairCache->getOverlappingPairCache()->setOverlapFilterCallback(world->filterCallback);
 
-  /* constraint solving */
-  world->constraintSolver = new btSequentialImpulseConstraintSolver();
-
-  /* world */
-  world->dynamicsWorld = new btDiscreteDynamicsWorld(
-      world->dispatcher, world->pairCache, world->constraintSolver, world->collisionConfiguration);
+  world->constraintSolverMt = NULL;
+
+#ifdef WITH_BULLET_THREADS
+  if (use_threads) {
+    /* Islands are solved in parallel, each by a solver from the pool,
+     * big islands are split up by the parallel solver. */
+    btConstraintSolverPoolMt *solver_pool = new btConstraintSolverPoolMt(
+        btGetTaskScheduler()->getNumThreads());
+    world->constraintSolver = solver_pool;
+    world->constraintSolverMt = new btSequentialImpulseConstraintSolverMt();
+
+    world->dynamicsWorld = new btDiscreteDynamicsWorldMt(world->dispatcher,
+                                                         world->pairCache,
+                                                         solver_pool,
+                                                         world->constraintSolverMt,
+                                                         world->collisionConfiguration);
+  }
+  else
+#endif
+  {
+    /* constraint solving */
+    world->constraintSolver = new btSequentialImpulseConstraintSolver();
+
+    /* world */
+    world->dynamicsWorld = new btDiscreteDynamicsWorld(world->dispatcher,
+                                                       world->pairCache,
+                                                       world->constraintSolver,
+                                                       world->collisionConfiguration);
+  }
 
   RB_dworld_set_gravity(world, gravity);
 
@@ -167,6 +362,7 @@ void RB_dworld_delete(rbDynamicsWorld *world)
 {
   /* bullet doesn't like if we free these in a different order */
   delete world->dynamicsWorld;
+  delete world->constraintSolverMt;
   delete world->constraintSolver;
   delete world->pairCache;
   delete world->dispatcher;
@@ -211,7 +407,8 @@ void RB_dworld_step_simulation(rbDynamicsWorld *world,
                                int maxSubSteps,
                                float timeSubStep)
 {
-  world->dynamicsWorld->stepSimulation(timeStep, maxSubSteps, timeSubStep);
+  rb_world_call(
+      [&]() { world->dynamicsWorld->stepSimulation(timeStep, maxSubSteps, timeSubStep); });
 }
 
 /* Export -------------------------- */
@@ -292,8 +489,10 @@ void RB_world_convex_sweep_test(rbDynamicsWorld *world,
     rayToTrans.setRotation(obRot);
     rayToTrans.setOrigin(btVector3(loc_end[0], loc_end[1], loc_end[2]));
 
-    world->dynamicsWorld->convexSweepTest(
-        (btConvexShape *)collisionShape, rayFromTrans, rayToTrans, result, 0);
+    rb_world_call([&]() {
+      world->dynamicsWorld->convexSweepTest(
+          (btConvexShape *)collisionShape, rayFromTrans, rayToTrans, result, 0);
+    });
 
     if (result.hasHit()) {
       *r_hit = 1;
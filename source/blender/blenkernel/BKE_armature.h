@@ -399,6 +399,12 @@ void BKE_pose_constraints_evaluate(struct Depsgraph *depsgraph,
 
 void BKE_pose_bone_done(struct Depsgraph *depsgraph, struct Object *object, int pchan_index);
 
+void BKE_pose_eval_bones_batch(struct Depsgraph *depsgraph,
+                               struct Scene *scene,
+                               struct Object *object,
+                               const int *pchan_indices,
+                               int num_pchans);
+
 void BKE_pose_eval_bbone_segments(struct Depsgraph *depsgraph,
                                   struct Object *object,
                                   int pchan_index);
@@ -31,6 +31,7 @@ struct BoidSettings;
 struct BoidState;
 struct Object;
 struct ParticleData;
+struct ParticleGrid;
 struct ParticleSettings;
 struct ParticleSimulationData;
 struct RNG;
@@ -48,8 +49,18 @@ typedef struct BoidBrainData {
   float goal_priority;
 
   struct RNG *rng;
+
+  /* Neighbor grids of the own system and of each particle target, in target list order. */
+  struct ParticleGrid *grid;
+  struct ParticleGrid **target_grids;
+
+  /* Jump velocity decided by #boid_brain, only applied by #boid_body so the other boids of
+   * the step still see the previous velocity. */
+  float jump_vel[3];
+  bool do_jump;
 } BoidBrainData;
 
+bool boids_rules_thread_safe(const struct ParticleSettings *part);
 void boids_precalc_rules(struct ParticleSettings *part, float cfra);
 void boid_brain(BoidBrainData *bbd, int p, struct ParticleData *pa);
 void boid_body(BoidBrainData *bbd, struct ParticleData *pa);
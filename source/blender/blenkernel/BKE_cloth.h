@@ -67,6 +67,10 @@ typedef struct ClothSolverResult {
   int max_iterations, min_iterations;
   float avg_iterations;
   float max_error, min_error, avg_error;
+
+  /* Self-collision statistics of the substeps. */
+  int selfcol_builds, selfcol_reuses;
+  int selfcol_max_pairs, selfcol_max_contacts;
 } ClothSolverResult;
 
 /**
@@ -87,8 +91,7 @@ typedef struct Cloth {
   unsigned char old_solver_type; /* unused, only 1 solver here */
   unsigned char pad2;
   short pad3;
-  struct BVHTree *bvhtree;     /* collision tree for this cloth object */
-  struct BVHTree *bvhselftree; /* collision tree for this cloth object */
+  struct BVHTree *bvhtree; /* collision tree for this cloth object */
   struct MVertTri *tri;
   struct Implicit_Data *implicit; /* our implicit solver connects to this pointer */
   struct EdgeSet *edgeset;        /* used for selfcollisions */
@@ -97,6 +100,8 @@ typedef struct Cloth {
   float average_acceleration[3];  /* Moving average of overall acceleration. */
   struct MEdge *edges;            /* Used for hair collisions. */
   struct EdgeSet *sew_edge_graph; /* Sewing edges represented using a GHash */
+  /* Self-collision pairs kept between substeps. */
+  struct SelfCollisionCache *selfcol_cache;
 } Cloth;
 
 /**
@@ -231,6 +236,7 @@ int cloth_bvh_collision(struct Depsgraph *depsgraph,
                         struct ClothModifierData *clmd,
                         float step,
                         float dt);
+void cloth_selfcollision_cache_free(struct Cloth *cloth);
 
 ////////////////////////////////////////////////
 
@@ -251,7 +257,7 @@ void clothModifier_do(struct ClothModifierData *clmd,
 int cloth_uses_vgroup(struct ClothModifierData *clmd);
 
 // needed for collision.c
-void bvhtree_update_from_cloth(struct ClothModifierData *clmd, bool moving, bool self);
+void bvhtree_update_from_cloth(struct ClothModifierData *clmd, bool moving);
 
 // needed for button_object.c
 void cloth_clear_cache(struct Object *ob, struct ClothModifierData *clmd, float framenr);
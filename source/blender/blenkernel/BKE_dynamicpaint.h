@@ -28,6 +28,7 @@ extern "C" {
 
 struct Depsgraph;
 struct DynamicPaintCanvasSettings;
+struct DynamicPaintImageWriter;
 struct DynamicPaintModifierData;
 struct DynamicPaintRuntime;
 struct Object;
@@ -104,9 +105,12 @@ int dynamicPaint_calculateFrame(struct DynamicPaintSurface *surface,
                                 struct Scene *scene,
                                 struct Object *cObject,
                                 int frame);
+struct DynamicPaintImageWriter *dynamicPaint_imageWriter_new(void);
+void dynamicPaint_imageWriter_free(struct DynamicPaintImageWriter *writer);
 void dynamicPaint_outputSurfaceImage(struct DynamicPaintSurface *surface,
                                      char *filename,
-                                     short output_layer);
+                                     short output_layer,
+                                     struct DynamicPaintImageWriter *writer);
 
 /* PaintPoint state */
 #define DPAINT_PAINT_NONE -1
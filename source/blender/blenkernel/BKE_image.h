@@ -32,6 +32,7 @@ struct Depsgraph;
 struct ID;
 struct ImBuf;
 struct Image;
+struct MovieCacheStats;
 struct ImageFormatData;
 struct ImagePool;
 struct ImageTile;
@@ -360,6 +361,7 @@ void BKE_image_file_format_set(struct Image *image,
                                int ftype,
                                const struct ImbFormatOptions *options);
 bool BKE_image_has_loaded_ibuf(struct Image *image);
+void BKE_image_get_cache_stats(struct Image *image, struct MovieCacheStats *r_stats);
 struct ImBuf *BKE_image_get_ibuf_with_name(struct Image *image, const char *name);
 struct ImBuf *BKE_image_get_first_ibuf(struct Image *image);
 
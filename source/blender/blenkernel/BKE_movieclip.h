@@ -30,6 +30,7 @@ extern "C" {
 struct Depsgraph;
 struct ImBuf;
 struct Main;
+struct MovieCacheStats;
 struct MovieClip;
 struct MovieClipScopes;
 struct MovieClipUser;
@@ -109,6 +110,7 @@ struct ImBuf *BKE_movieclip_anim_ibuf_for_frame_no_lock(struct MovieClip *clip,
                                                         struct MovieClipUser *user);
 
 bool BKE_movieclip_has_cached_frame(struct MovieClip *clip, struct MovieClipUser *user);
+void BKE_movieclip_get_cache_stats(struct MovieClip *clip, struct MovieCacheStats *r_stats);
 bool BKE_movieclip_put_frame_if_possible(struct MovieClip *clip,
                                          struct MovieClipUser *user,
                                          struct ImBuf *ibuf);
@@ -48,6 +48,7 @@ struct BlendWriter;
 struct CustomData_MeshMasks;
 struct Depsgraph;
 struct EdgeHash;
+struct KDTreeNearest_3d;
 struct KDTree_3d;
 struct LatticeDeformData;
 struct LinkNode;
@@ -58,6 +59,7 @@ struct MVert;
 struct Main;
 struct ModifierData;
 struct Object;
+struct ParticleGrid;
 struct RNG;
 struct Scene;
 
@@ -102,7 +104,10 @@ typedef struct SPHData {
   ParticleSystem *psys[10];
   ParticleData *pa;
   float mass;
-  struct EdgeHash *eh;
+  /* Uniform grids over the particles of each system in `psys`, built once per step. */
+  struct ParticleGrid *grid[10];
+  /* Fluid springs of `psys[0]` indexed by particle, replaces an edge hash lookup. */
+  struct SPHSpringIndex *springs;
   float *gravity;
   float hfac;
   /* Average distance to neighbors (other particles in the support domain),
@@ -429,7 +434,7 @@ void psys_apply_child_modifiers(struct ParticleThreadContext *ctx,
                                 struct ParticleCacheKey *parent_keys,
                                 const float parent_orco[3]);
 
-void psys_sph_init(struct ParticleSimulationData *sim, struct SPHData *sphdata);
+void psys_sph_init(struct ParticleSimulationData *sim, struct SPHData *sphdata, float cfra);
 void psys_sph_finalize(struct SPHData *sphdata);
 void psys_sph_density(struct BVHTree *tree, struct SPHData *data, float co[3], float vars[2]);
 
@@ -466,7 +471,29 @@ void psys_apply_hair_lattice(struct Depsgraph *depsgraph,
 /* particle_system.c */
 struct ParticleSystem *psys_get_target_system(struct Object *ob, struct ParticleTarget *pt);
 void psys_count_keyed_targets(struct ParticleSimulationData *sim);
-void psys_update_particle_tree(struct ParticleSystem *psys, float cfra);
+
+/* Uniform grid neighbor queries over the particles alive at the start of a step. */
+typedef void (*ParticleGridRangeQueryFn)(void *userdata,
+                                         int index,
+                                         const float co[3],
+                                         float dist_sq);
+struct ParticleGrid *psys_grid_build(struct ParticleSystem *psys, float cfra, float cell_size);
+void psys_grid_free(struct ParticleGrid *grid);
+void psys_grid_range_query(const struct ParticleGrid *grid,
+                           const float co[3],
+                           float radius,
+                           ParticleGridRangeQueryFn callback,
+                           void *userdata);
+int psys_grid_find_nearest_n(const struct ParticleGrid *grid,
+                             const float co[3],
+                             float range,
+                             int index_exclude,
+                             struct KDTreeNearest_3d *r_nearest,
+                             int nearest_len_capacity,
+                             float (*len_sq_fn)(const float co_search[3],
+                                                const float co_test[3],
+                                                const void *user_data),
+                             const void *user_data);
 void psys_changed_type(struct Object *ob, struct ParticleSystem *psys);
 
 void psys_make_temp_pointcache(struct Object *ob, struct ParticleSystem *psys);
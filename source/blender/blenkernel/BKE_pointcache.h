@@ -67,9 +67,12 @@ extern "C" {
 /* high bits reserved for flags that need to be stored in file */
 #define PTCACHE_TYPEFLAG_COMPRESS (1 << 16)
 #define PTCACHE_TYPEFLAG_EXTRADATA (1 << 17)
+/* Compressed data was byte shuffled. Stored with the type bits, so versions that can't
+ * unshuffle see a different cache type and reject the file instead of misreading it. */
+#define PTCACHE_TYPEFLAG_SHUFFLE (1 << 15)
 
-#define PTCACHE_TYPEFLAG_TYPEMASK 0x0000FFFF
-#define PTCACHE_TYPEFLAG_FLAGMASK 0xFFFF0000
+#define PTCACHE_TYPEFLAG_TYPEMASK 0x00007FFF
+#define PTCACHE_TYPEFLAG_FLAGMASK 0xFFFF8000
 
 /* PTCache read return code */
 #define PTCACHE_READ_EXACT 1
@@ -27,20 +27,28 @@
 #include "MEM_guardedalloc.h"
 
 #include "DNA_cloth_types.h"
+#include "DNA_color_types.h"
+#include "DNA_curveprofile_types.h"
 #include "DNA_customdata_types.h"
+#include "DNA_genfile.h"
 #include "DNA_key_types.h"
 #include "DNA_material_types.h"
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_sdna_types.h"
 
 #include "BLI_array.h"
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_float2.hh"
+#include "BLI_hash_mm2a.h"
 #include "BLI_linklist.h"
+#include "BLI_map.hh"
 #include "BLI_math.h"
+#include "BLI_session_uuid.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "BLI_vector.hh"
@@ -967,6 +975,444 @@ static Mesh *modifier_modify_mesh_and_geometry_set(ModifierData *md,
   return mesh_output;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Modifier Stack Cache
+ *
+ * Modifiers with #eModifierFlag_CacheOutput keep a copy of their result in the evaluated
+ * object's runtime, keyed by a hash of everything that went into it: the input mesh, the
+ * result of the leading deform modifiers and the settings of every modifier up to and
+ * including the cached one. When the key still matches on the next evaluation, the stack
+ * continues from the cached mesh instead of running those modifiers again.
+ *
+ * Only self-contained modifiers can be part of a cached prefix: ones that don't depend on
+ * time, don't reference other data-blocks and have no side effects on other data.
+ * \{ */
+
+struct MeshModifierStackCacheEntry {
+  SessionUUID session_uuid;
+  uint64_t key;
+  Mesh *mesh;
+};
+
+struct MeshModifierStackCache {
+  blender::Vector<MeshModifierStackCacheEntry> entries;
+};
+
+/* Pointers are followed this many levels deep when hashing modifier settings. */
+#define MODIFIER_CACHE_POINTER_DEPTH 2
+
+/** 64 bit hash built from two differently seeded murmur hashes. */
+class ModifierStackHash {
+ private:
+  BLI_HashMurmur2A mm2_[2];
+
+ public:
+  ModifierStackHash()
+  {
+    BLI_hash_mm2a_init(&mm2_[0], 0);
+    BLI_hash_mm2a_init(&mm2_[1], 0x9e3779b9);
+  }
+
+  void add(const void *data, const size_t len)
+  {
+    BLI_hash_mm2a_add(&mm2_[0], (const unsigned char *)data, len);
+    BLI_hash_mm2a_add(&mm2_[1], (const unsigned char *)data, len);
+  }
+
+  template<typename T> void add_value(const T &value)
+  {
+    this->add(&value, sizeof(T));
+  }
+
+  uint64_t get() const
+  {
+    /* Finalize copies, so more data can still be added afterwards. */
+    BLI_HashMurmur2A mm2[2] = {mm2_[0], mm2_[1]};
+    return ((uint64_t)BLI_hash_mm2a_end(&mm2[0]) << 32) | BLI_hash_mm2a_end(&mm2[1]);
+  }
+};
+
+/**
+ * Pointer members of DNA structs used in modifier settings that own their data, with the
+ * number of elements they point to. DNA doesn't store array lengths, so only the data of these
+ * members can be hashed. Modifiers with any other pointer set are not cached, their address
+ * changes with every copy and can be reused by different data.
+ */
+struct ModifierStackCacheDNAArray {
+  const char *struct_name;
+  const char *member_name;
+  /**
+   * Number of elements of the member's type, null for runtime data derived from other members,
+   * which is not hashed.
+   */
+  int (*len)(const void *owner);
+};
+
+static const ModifierStackCacheDNAArray modifier_stack_cache_dna_arrays[] = {
+    {"CorrectiveSmoothModifierData",
+     "bind_coords",
+     [](const void *owner) {
+       /* `bind_coords_num` is -1 while binding. */
+       return (int)((const CorrectiveSmoothModifierData *)owner)->bind_coords_num * 3;
+     }},
+    {"CorrectiveSmoothModifierData", "delta_cache", nullptr},
+    {"LaplacianDeformModifierData",
+     "vertexco",
+     [](const void *owner) {
+       return ((const LaplacianDeformModifierData *)owner)->total_verts * 3;
+     }},
+    {"HookModifierData",
+     "indexar",
+     [](const void *owner) { return ((const HookModifierData *)owner)->totindex; }},
+    {"HookModifierData", "curfalloff", [](const void *UNUSED(owner)) { return 1; }},
+    {"WarpModifierData", "curfalloff", [](const void *UNUSED(owner)) { return 1; }},
+    {"WeightVGEditModifierData", "cmap_curve", [](const void *UNUSED(owner)) { return 1; }},
+    {"WeightVGProximityModifierData", "cmap_curve", [](const void *UNUSED(owner)) { return 1; }},
+    {"CurveMap",
+     "curve",
+     [](const void *owner) { return (int)((const CurveMap *)owner)->totpoint; }},
+    {"CurveMap", "table", nullptr},
+    {"CurveMap", "premultable", nullptr},
+    {"BevelModifierData", "custom_profile", [](const void *UNUSED(owner)) { return 1; }},
+    {"CurveProfile",
+     "path",
+     [](const void *owner) { return (int)((const CurveProfile *)owner)->path_len; }},
+    {"CurveProfile", "table", nullptr},
+    {"CurveProfile", "segments", nullptr},
+    {"CurveProfilePoint", "profile", nullptr},
+};
+
+static const ModifierStackCacheDNAArray *modifier_stack_cache_dna_array_find(
+    const char *struct_name, const char *member_name)
+{
+  /* Strip the pointer and array decoration from the DNA member name. */
+  const char *name_start = member_name + strspn(member_name, "*(");
+  const size_t name_len = strcspn(name_start, ")[");
+
+  for (const ModifierStackCacheDNAArray &array : modifier_stack_cache_dna_arrays) {
+    if (STREQ(array.struct_name, struct_name) && strlen(array.member_name) == name_len &&
+        STREQLEN(array.member_name, name_start, name_len)) {
+      return &array;
+    }
+  }
+  return nullptr;
+}
+
+static bool modifier_stack_cache_hash_dna_pointer(ModifierStackHash &hash,
+                                                  const SDNA *sdna,
+                                                  const short type,
+                                                  const void *pointee,
+                                                  const int len,
+                                                  const int depth);
+
+/**
+ * Hash the members of a DNA struct. Only the data of the pointers listed in
+ * #modifier_stack_cache_dna_arrays is hashed, these are copied along with the modifier so their
+ * address changes every time the evaluated object is copied.
+ * Returns false when the struct has any other pointer set, so it can't be hashed.
+ */
+static bool modifier_stack_cache_hash_dna_struct(ModifierStackHash &hash,
+                                                 const SDNA *sdna,
+                                                 const int struct_nr,
+                                                 const char *data,
+                                                 const int first_member,
+                                                 const int depth)
+{
+  const SDNA_Struct *struct_info = sdna->structs[struct_nr];
+  const char *struct_name = sdna->types[struct_info->type];
+  int offset = 0;
+
+  for (int i = 0; i < struct_info->members_len; i++) {
+    const SDNA_StructMember *member = &struct_info->members[i];
+    const char *member_data = data + offset;
+    const int member_size = DNA_elem_size_nr(sdna, member->type, member->name);
+    offset += member_size;
+
+    if (i < first_member) {
+      continue;
+    }
+
+    const char *name = sdna->names[member->name];
+    const int array_len = sdna->names_array_len[member->name];
+    const ModifierStackCacheDNAArray *owned_array = modifier_stack_cache_dna_array_find(
+        struct_name, name);
+
+    if (owned_array != nullptr && owned_array->len == nullptr) {
+      /* Derived runtime data. */
+      continue;
+    }
+
+    /* Pointers to arrays (`(*name)[3]`) are stored like function pointers (`(*name)()`). */
+    if (ELEM(name[0], '*', '(')) {
+      for (int j = 0; j < array_len; j++) {
+        const void *pointee = ((const void *const *)member_data)[j];
+        hash.add_value(pointee != nullptr);
+        if (pointee == nullptr) {
+          continue;
+        }
+        if (owned_array == nullptr || array_len != 1 || depth >= MODIFIER_CACHE_POINTER_DEPTH) {
+          return false;
+        }
+        if (!modifier_stack_cache_hash_dna_pointer(
+                hash, sdna, member->type, pointee, max_ii(owned_array->len(data), 0), depth + 1)) {
+          return false;
+        }
+      }
+      continue;
+    }
+
+    const int member_struct_nr = DNA_struct_find_nr(sdna, sdna->types[member->type]);
+    if (member_struct_nr != -1) {
+      const int type_size = sdna->types_size[member->type];
+      for (int j = 0; j < array_len; j++) {
+        if (!modifier_stack_cache_hash_dna_struct(
+                hash, sdna, member_struct_nr, member_data + j * type_size, 0, depth)) {
+          return false;
+        }
+      }
+    }
+    else {
+      hash.add(member_data, member_size);
+    }
+  }
+  return true;
+}
+
+/** Hash `len` elements of DNA type `type` owned by a modifier. */
+static bool modifier_stack_cache_hash_dna_pointer(ModifierStackHash &hash,
+                                                  const SDNA *sdna,
+                                                  const short type,
+                                                  const void *pointee,
+                                                  const int len,
+                                                  const int depth)
+{
+  const int type_size = sdna->types_size[type];
+  hash.add_value(len);
+
+  const int struct_nr = DNA_struct_find_nr(sdna, sdna->types[type]);
+  if (struct_nr == -1) {
+    hash.add(pointee, (size_t)type_size * len);
+    return true;
+  }
+
+  for (int i = 0; i < len; i++) {
+    if (!modifier_stack_cache_hash_dna_struct(
+            hash, sdna, struct_nr, (const char *)pointee + (size_t)i * type_size, 0, depth)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Hash the state the non-leading part of the modifier stack starts from.
+ * Returns false if the cache can not be used for this input.
+ */
+static bool modifier_stack_cache_hash_input(ModifierStackHash &hash,
+                                            const Scene *scene,
+                                            const Object *ob,
+                                            const Mesh *mesh_input,
+                                            const float (*deformed_verts)[3],
+                                            const int num_deformed_verts,
+                                            const CustomData_MeshMasks *dataMask,
+                                            const int required_mode,
+                                            const bool need_mapping)
+{
+  hash.add_value(required_mode);
+  hash.add_value(need_mapping);
+  hash.add_value(*dataMask);
+
+  /* Subdivision levels can be limited by the scene. */
+  hash.add_value(scene->r.mode & R_SIMPLIFY);
+  hash.add_value(scene->r.simplify_subsurf);
+  hash.add_value(scene->r.simplify_subsurf_render);
+
+  /* Modifiers look up vertex groups by name and clamp material indices. */
+  LISTBASE_FOREACH (const bDeformGroup *, defgroup, &ob->defbase) {
+    hash.add(defgroup->name, strlen(defgroup->name) + 1);
+  }
+  hash.add_value(ob->totcol);
+
+  /* Any change to the input mesh goes through a copy-on-write update, which gives the mesh a
+   * new stamp. Hashing the mesh data itself would cost about as much as the modifiers saved. */
+  if (mesh_input->runtime.data_stamp == 0) {
+    return false;
+  }
+  hash.add_value(mesh_input->runtime.data_stamp);
+
+  hash.add_value(deformed_verts != nullptr);
+  if (deformed_verts) {
+    hash.add(deformed_verts, sizeof(*deformed_verts) * num_deformed_verts);
+  }
+  return true;
+}
+
+static void modifier_stack_cache_id_walk(void *userData,
+                                         Object *UNUSED(ob),
+                                         ID **idpoin,
+                                         int UNUSED(cb_flag))
+{
+  if (*idpoin != nullptr) {
+    *(bool *)userData = true;
+  }
+}
+
+static bool modifier_stack_cache_supports(ModifierData *md, Object *ob)
+{
+  const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
+
+  /* Modifiers that write to other data as a side effect of their evaluation. */
+  if (ELEM(md->type,
+           eModifierType_ParticleSystem,
+           eModifierType_Collision,
+           eModifierType_Surface,
+           eModifierType_Cloth,
+           eModifierType_Softbody,
+           eModifierType_DynamicPaint,
+           eModifierType_Fluid,
+           eModifierType_Nodes)) {
+    return false;
+  }
+
+  if (mti->dependsOnTime && mti->dependsOnTime(md)) {
+    return false;
+  }
+
+  bool has_id_dependency = false;
+  if (mti->foreachIDLink) {
+    mti->foreachIDLink(md, ob, modifier_stack_cache_id_walk, &has_id_dependency);
+  }
+  return !has_id_dependency;
+}
+
+/**
+ * Compute the cache key of every modifier with cached output, walking the stack the same way
+ * #mesh_calc_modifiers does. Stops at the first modifier that can't be part of a cached prefix.
+ */
+static void modifier_stack_cache_calc_keys(ModifierStackHash hash,
+                                           Scene *scene,
+                                           Object *ob,
+                                           ModifierData *md,
+                                           const CDMaskLink *md_datamask,
+                                           const int required_mode,
+                                           const bool need_mapping,
+                                           blender::Map<const ModifierData *, uint64_t> &r_keys)
+{
+  const SDNA *sdna = DNA_sdna_current_get();
+
+  for (; md; md = md->next, md_datamask = md_datamask->next) {
+    const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
+
+    if (!BKE_modifier_is_enabled(scene, md, required_mode)) {
+      continue;
+    }
+    if (need_mapping && !BKE_modifier_supports_mapping(md)) {
+      continue;
+    }
+    if (!modifier_stack_cache_supports(md, ob)) {
+      return;
+    }
+
+    const int struct_nr = DNA_struct_find_nr(sdna, mti->structName);
+    if (struct_nr == -1) {
+      return;
+    }
+
+    hash.add_value(md->type);
+    hash.add_value(md_datamask->mask);
+    /* Skip the #ModifierData header, it only holds names, UI and runtime data. */
+    if (!modifier_stack_cache_hash_dna_struct(hash, sdna, struct_nr, (const char *)md, 1, 0)) {
+      return;
+    }
+
+    if ((md->flag & eModifierFlag_CacheOutput) && mti->type != eModifierTypeType_OnlyDeform) {
+      r_keys.add(md, hash.get());
+    }
+  }
+}
+
+static Mesh *modifier_stack_cache_find(const Object *ob,
+                                       const ModifierData *md,
+                                       const uint64_t key)
+{
+  const MeshModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+  if (cache == nullptr) {
+    return nullptr;
+  }
+  for (const MeshModifierStackCacheEntry &entry : cache->entries) {
+    if (entry.key == key && BLI_session_uuid_is_equal(&entry.session_uuid, &md->session_uuid)) {
+      return entry.mesh;
+    }
+  }
+  return nullptr;
+}
+
+static void modifier_stack_cache_store(Object *ob,
+                                       const ModifierData *md,
+                                       const uint64_t key,
+                                       Mesh *mesh)
+{
+  if (ob->runtime.modifier_stack_cache == nullptr) {
+    ob->runtime.modifier_stack_cache = new MeshModifierStackCache();
+  }
+  MeshModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+
+  Mesh *mesh_copy = BKE_mesh_copy_for_eval(mesh, false);
+  for (MeshModifierStackCacheEntry &entry : cache->entries) {
+    if (BLI_session_uuid_is_equal(&entry.session_uuid, &md->session_uuid)) {
+      BKE_id_free(nullptr, entry.mesh);
+      entry.key = key;
+      entry.mesh = mesh_copy;
+      return;
+    }
+  }
+  cache->entries.append({md->session_uuid, key, mesh_copy});
+}
+
+/* Remove entries of modifiers which don't cache their output anymore. */
+static void modifier_stack_cache_prune(Object *ob,
+                                       const blender::Map<const ModifierData *, uint64_t> &keys)
+{
+  MeshModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+  if (cache == nullptr) {
+    return;
+  }
+
+  for (int i = cache->entries.size() - 1; i >= 0; i--) {
+    const MeshModifierStackCacheEntry &entry = cache->entries[i];
+    bool is_used = false;
+    for (const ModifierData *md : keys.keys()) {
+      if (BLI_session_uuid_is_equal(&entry.session_uuid, &md->session_uuid)) {
+        is_used = true;
+        break;
+      }
+    }
+    if (!is_used) {
+      BKE_id_free(nullptr, entry.mesh);
+      cache->entries.remove_and_reorder(i);
+    }
+  }
+
+  if (cache->entries.is_empty()) {
+    BKE_object_modifier_stack_cache_free(ob);
+  }
+}
+
+void BKE_object_modifier_stack_cache_free(Object *ob)
+{
+  MeshModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+  if (cache == nullptr) {
+    return;
+  }
+  for (MeshModifierStackCacheEntry &entry : cache->entries) {
+    BKE_id_free(nullptr, entry.mesh);
+  }
+  delete cache;
+  ob->runtime.modifier_stack_cache = nullptr;
+}
+
+/** \} */
+
 static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
                                 Scene *scene,
                                 Object *ob,
@@ -1118,6 +1564,68 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
 
   /* Apply all remaining constructive and deforming modifiers. */
   bool have_non_onlydeform_modifiers_appled = false;
+
+  /* Continue from the furthest cached modifier result that is still valid. */
+  ModifierData *md_stack_first = md;
+  blender::Map<const ModifierData *, uint64_t> stack_cache_keys;
+  bool use_stack_cache = use_cache && useDeform == 1 && index == -1 && !sculpt_mode &&
+                         (ob->id.tag & LIB_TAG_COPIED_ON_WRITE);
+  if (use_stack_cache) {
+    /* Hashing the input is not free, only do it when there is something to cache. */
+    use_stack_cache = false;
+    for (ModifierData *md_iter = md; md_iter; md_iter = md_iter->next) {
+      use_stack_cache |= (md_iter->flag & eModifierFlag_CacheOutput) != 0;
+    }
+    if (!use_stack_cache) {
+      BKE_object_modifier_stack_cache_free(ob);
+    }
+  }
+  if (use_stack_cache) {
+    ModifierStackHash stack_hash;
+    if (modifier_stack_cache_hash_input(stack_hash,
+                                        scene,
+                                        ob,
+                                        mesh_input,
+                                        deformed_verts,
+                                        num_deformed_verts,
+                                        dataMask,
+                                        required_mode,
+                                        need_mapping)) {
+      modifier_stack_cache_calc_keys(
+          stack_hash, scene, ob, md, md_datamask, required_mode, need_mapping, stack_cache_keys);
+    }
+    modifier_stack_cache_prune(ob, stack_cache_keys);
+
+    ModifierData *md_cached = nullptr;
+    Mesh *mesh_cached = nullptr;
+    for (ModifierData *md_iter = md; md_iter; md_iter = md_iter->next) {
+      const uint64_t *key = stack_cache_keys.lookup_ptr(md_iter);
+      Mesh *mesh_iter = key ? modifier_stack_cache_find(ob, md_iter, *key) : nullptr;
+      if (mesh_iter) {
+        md_cached = md_iter;
+        mesh_cached = mesh_iter;
+      }
+    }
+
+    if (md_cached) {
+      if (mesh_final) {
+        BLI_assert(mesh_final != mesh_input);
+        BKE_id_free(nullptr, mesh_final);
+      }
+      mesh_final = BKE_mesh_copy_for_eval(mesh_cached, false);
+      MEM_SAFE_FREE(deformed_verts);
+      have_non_onlydeform_modifiers_appled = true;
+      isPrevDeform = false;
+
+      while (md != md_cached) {
+        md = md->next;
+        md_datamask = md_datamask->next;
+      }
+      md = md->next;
+      md_datamask = md_datamask->next;
+    }
+  }
+
   for (; md; md = md->next, md_datamask = md_datamask->next) {
     const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
 
@@ -1389,6 +1897,19 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
 
     isPrevDeform = (mti->type == eModifierTypeType_OnlyDeform);
 
+    /* Keep the result around if it can be reused by the next evaluation. */
+    const uint64_t *stack_cache_key = stack_cache_keys.lookup_ptr(md);
+    if (stack_cache_key && deformed_verts == nullptr && mesh_orco == nullptr &&
+        mesh_orco_cloth == nullptr) {
+      bool has_error = false;
+      for (ModifierData *md_iter = md_stack_first; md_iter != md->next; md_iter = md_iter->next) {
+        has_error |= (md_iter->error != nullptr);
+      }
+      if (!has_error) {
+        modifier_stack_cache_store(ob, md, *stack_cache_key, mesh_final);
+      }
+    }
+
     /* grab modifiers until index i */
     if ((index != -1) && (BLI_findindex(&ob->modifiers, md) >= index)) {
       break;
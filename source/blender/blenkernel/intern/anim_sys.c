@@ -376,16 +376,12 @@ static bool is_fcurve_evaluatable(FCurve *fcu)
   return true;
 }
 
-bool BKE_animsys_rna_path_resolve(PointerRNA *ptr,
-                                  /* typically 'fcu->rna_path', 'fcu->array_index' */
-                                  const char *rna_path,
-                                  const int array_index,
-                                  PathResolvedRNA *r_result)
+/* Resolve the property of an RNA path, without checking the array index. */
+static bool animsys_rna_path_resolve_property(PointerRNA *ptr,
+                                              const char *rna_path,
+                                              const int array_index,
+                                              PathResolvedRNA *r_result)
 {
-  if (rna_path == NULL) {
-    return false;
-  }
-
   const char *path = rna_path;
   if (!RNA_path_resolve_property(ptr, path, &r_result->ptr, &r_result->prop)) {
     /* failed to get path */
@@ -405,6 +401,15 @@ bool BKE_animsys_rna_path_resolve(PointerRNA *ptr,
     return false;
   }
 
+  return true;
+}
+
+/* Check the array index against the resolved property and store it in \a r_result. */
+static bool animsys_rna_path_resolve_array_index(const PointerRNA *ptr,
+                                                 const char *path,
+                                                 const int array_index,
+                                                 PathResolvedRNA *r_result)
+{
   int array_len = RNA_property_array_length(&r_result->ptr, r_result->prop);
   if (array_len && array_index >= array_len) {
     if (G.debug & G_DEBUG) {
@@ -422,6 +427,55 @@ bool BKE_animsys_rna_path_resolve(PointerRNA *ptr,
   return true;
 }
 
+bool BKE_animsys_rna_path_resolve(PointerRNA *ptr,
+                                  /* typically 'fcu->rna_path', 'fcu->array_index' */
+                                  const char *rna_path,
+                                  const int array_index,
+                                  PathResolvedRNA *r_result)
+{
+  if (rna_path == NULL) {
+    return false;
+  }
+  if (!animsys_rna_path_resolve_property(ptr, rna_path, array_index, r_result)) {
+    return false;
+  }
+  return animsys_rna_path_resolve_array_index(ptr, rna_path, array_index, r_result);
+}
+
+/**
+ * Last resolved RNA path, F-Curves animating the elements of an array property are usually
+ * stored next to each other and share the same path, which then only has to be resolved once.
+ */
+typedef struct AnimsysPathCache {
+  /* Path of the last resolved F-Curve, NULL when nothing is cached. */
+  const char *rna_path;
+  bool is_resolved;
+  PathResolvedRNA anim_rna;
+} AnimsysPathCache;
+
+static bool animsys_rna_path_resolve_cached(PointerRNA *ptr,
+                                            const char *rna_path,
+                                            const int array_index,
+                                            AnimsysPathCache *cache,
+                                            PathResolvedRNA *r_result)
+{
+  if (rna_path == NULL) {
+    return false;
+  }
+
+  if (cache->rna_path == NULL || !STREQ(cache->rna_path, rna_path)) {
+    cache->rna_path = rna_path;
+    cache->is_resolved = animsys_rna_path_resolve_property(
+        ptr, rna_path, array_index, &cache->anim_rna);
+  }
+  if (!cache->is_resolved) {
+    return false;
+  }
+
+  *r_result = cache->anim_rna;
+  return animsys_rna_path_resolve_array_index(ptr, rna_path, array_index, r_result);
+}
+
 /* less than 1.0 evaluates to false, use epsilon to avoid float error */
 #define ANIMSYS_FLOAT_AS_BOOL(value) ((value) > ((1.0f - FLT_EPSILON)))
 
@@ -577,10 +631,11 @@ static bool animsys_construct_orig_pointer_rna(const PointerRNA *ptr, PointerRNA
   return true;
 }
 
-static void animsys_write_orig_anim_rna(PointerRNA *ptr,
-                                        const char *rna_path,
-                                        int array_index,
-                                        float value)
+static void animsys_write_orig_anim_rna_cached(PointerRNA *ptr,
+                                               const char *rna_path,
+                                               int array_index,
+                                               float value,
+                                               AnimsysPathCache *cache)
 {
   PointerRNA ptr_orig;
   if (!animsys_construct_orig_pointer_rna(ptr, &ptr_orig)) {
@@ -588,11 +643,20 @@ static void animsys_write_orig_anim_rna(PointerRNA *ptr,
   }
   PathResolvedRNA orig_anim_rna;
   /* TODO(sergey): Should be possible to cache resolved path in dependency graph somehow. */
-  if (BKE_animsys_rna_path_resolve(&ptr_orig, rna_path, array_index, &orig_anim_rna)) {
+  if (animsys_rna_path_resolve_cached(&ptr_orig, rna_path, array_index, cache, &orig_anim_rna)) {
     BKE_animsys_write_to_rna_path(&orig_anim_rna, value);
   }
 }
 
+static void animsys_write_orig_anim_rna(PointerRNA *ptr,
+                                        const char *rna_path,
+                                        int array_index,
+                                        float value)
+{
+  AnimsysPathCache cache = {NULL};
+  animsys_write_orig_anim_rna_cached(ptr, rna_path, array_index, value, &cache);
+}
+
 /**
  * Evaluate all the F-Curves in the given list
  * This performs a set of standard checks. If extra checks are required,
@@ -603,6 +667,9 @@ static void animsys_evaluate_fcurves(PointerRNA *ptr,
                                      const AnimationEvalContext *anim_eval_context,
                                      bool flush_to_original)
 {
+  AnimsysPathCache path_cache = {NULL};
+  AnimsysPathCache orig_path_cache = {NULL};
+
   /* Calculate then execute each curve. */
   LISTBASE_FOREACH (FCurve *, fcu, list) {
 
@@ -611,11 +678,13 @@ static void animsys_evaluate_fcurves(PointerRNA *ptr,
     }
 
     PathResolvedRNA anim_rna;
-    if (BKE_animsys_rna_path_resolve(ptr, fcu->rna_path, fcu->array_index, &anim_rna)) {
+    if (animsys_rna_path_resolve_cached(
+            ptr, fcu->rna_path, fcu->array_index, &path_cache, &anim_rna)) {
       const float curval = calculate_fcurve(&anim_rna, fcu, anim_eval_context);
       BKE_animsys_write_to_rna_path(&anim_rna, curval);
       if (flush_to_original) {
-        animsys_write_orig_anim_rna(ptr, fcu->rna_path, fcu->array_index, curval);
+        animsys_write_orig_anim_rna_cached(
+            ptr, fcu->rna_path, fcu->array_index, curval, &orig_path_cache);
       }
     }
   }
@@ -214,6 +214,79 @@ static bool rule_goal_avoid(BoidRule *rule, BoidBrainData *bbd, BoidValues *val,
   return ret;
 }
 
+typedef struct BoidAvoidCollisionData {
+  BoidBrainData *bbd;
+  const BoidValues *val;
+  ParticleData *pa;
+
+  /* Particles of the searched system, `index_exclude` is the boid itself. */
+  ParticleData *particles;
+  int index_exclude;
+  float range_sq;
+
+  float t_min;
+  bool ret;
+} BoidAvoidCollisionData;
+
+static void boid_avoid_collision_cb(void *userdata,
+                                    int index,
+                                    const float UNUSED(co[3]),
+                                    float UNUSED(dist_sq))
+{
+  BoidAvoidCollisionData *data = userdata;
+  BoidBrainData *bbd = data->bbd;
+  ParticleData *pa = data->pa;
+  ParticleData *npa = data->particles + index;
+  float co1[3], vel1[3], co2[3], vel2[3], loc[3], vec[3];
+  float len, t, inp;
+
+  if (index == data->index_exclude) {
+    return;
+  }
+
+  /* Boids behind are searched in a smaller range to avoid head-on collisions. */
+  if (len_squared_v3v3_with_normal_bias(
+          pa->prev_state.co, npa->prev_state.co, pa->prev_state.ave) > data->range_sq) {
+    return;
+  }
+
+  copy_v3_v3(co1, pa->prev_state.co);
+  copy_v3_v3(vel1, pa->prev_state.vel);
+  copy_v3_v3(co2, npa->prev_state.co);
+  copy_v3_v3(vel2, npa->prev_state.vel);
+
+  sub_v3_v3v3(loc, co1, co2);
+
+  sub_v3_v3v3(vec, vel1, vel2);
+
+  inp = dot_v3v3(vec, vec);
+
+  /* velocities not parallel */
+  if (inp != 0.0f) {
+    t = -dot_v3v3(loc, vec) / inp;
+    /* cpa is not too far in the future so investigate further */
+    if (t > 0.0f && t < data->t_min) {
+      madd_v3_v3fl(co1, vel1, t);
+      madd_v3_v3fl(co2, vel2, t);
+
+      sub_v3_v3v3(vec, co2, co1);
+
+      len = normalize_v3(vec);
+
+      /* distance of cpa is close enough */
+      if (len < 2.0f * data->val->personal_space * pa->size) {
+        data->t_min = t;
+
+        mul_v3_fl(vec, len_v3(vel1));
+        mul_v3_fl(vec, (2.0f - t) / 2.0f);
+        sub_v3_v3v3(bbd->wanted_co, vel1, vec);
+        bbd->wanted_speed = len_v3(bbd->wanted_co);
+        data->ret = true;
+      }
+    }
+  }
+}
+
 static bool rule_avoid_collision(BoidRule *rule,
                                  BoidBrainData *bbd,
                                  BoidValues *val,
@@ -221,15 +294,19 @@ static bool rule_avoid_collision(BoidRule *rule,
 {
   const int raycast_flag = BVH_RAYCAST_DEFAULT & ~BVH_RAYCAST_WATERTIGHT;
   BoidRuleAvoidCollision *acbr = (BoidRuleAvoidCollision *)rule;
-  KDTreeNearest_3d *ptn = NULL;
   ParticleTarget *pt;
   BoidParticle *bpa = pa->boid;
   ColliderCache *coll;
-  float vec[3] = {0.0f, 0.0f, 0.0f}, loc[3] = {0.0f, 0.0f, 0.0f};
-  float co1[3], vel1[3], co2[3], vel2[3];
-  float len, t, inp, t_min = 2.0f;
-  int n, neighbors = 0, nearest = 0;
-  bool ret = 0;
+  const float range = acbr->look_ahead * len_v3(pa->prev_state.vel);
+  BoidAvoidCollisionData data = {
+      .bbd = bbd,
+      .val = val,
+      .pa = pa,
+      .range_sq = range * range,
+      .t_min = 2.0f,
+  };
+  float t;
+  int i;
 
   // check deflector objects first
   if (acbr->options & BRULE_ACOLL_WITH_DEFLECTORS && bbd->sim->colliders) {
@@ -295,172 +372,66 @@ static bool rule_avoid_collision(BoidRule *rule,
 
   // check boids in own system
   if (acbr->options & BRULE_ACOLL_WITH_BOIDS) {
-    neighbors = BLI_kdtree_3d_range_search_with_len_squared_cb(bbd->sim->psys->tree,
-                                                               pa->prev_state.co,
-                                                               &ptn,
-                                                               acbr->look_ahead *
-                                                                   len_v3(pa->prev_state.vel),
-                                                               len_squared_v3v3_with_normal_bias,
-                                                               pa->prev_state.ave);
-    if (neighbors > 1) {
-      for (n = 1; n < neighbors; n++) {
-        copy_v3_v3(co1, pa->prev_state.co);
-        copy_v3_v3(vel1, pa->prev_state.vel);
-        copy_v3_v3(co2, (bbd->sim->psys->particles + ptn[n].index)->prev_state.co);
-        copy_v3_v3(vel2, (bbd->sim->psys->particles + ptn[n].index)->prev_state.vel);
-
-        sub_v3_v3v3(loc, co1, co2);
-
-        sub_v3_v3v3(vec, vel1, vel2);
-
-        inp = dot_v3v3(vec, vec);
-
-        /* velocities not parallel */
-        if (inp != 0.0f) {
-          t = -dot_v3v3(loc, vec) / inp;
-          /* cpa is not too far in the future so investigate further */
-          if (t > 0.0f && t < t_min) {
-            madd_v3_v3fl(co1, vel1, t);
-            madd_v3_v3fl(co2, vel2, t);
-
-            sub_v3_v3v3(vec, co2, co1);
-
-            len = normalize_v3(vec);
-
-            /* distance of cpa is close enough */
-            if (len < 2.0f * val->personal_space * pa->size) {
-              t_min = t;
-
-              mul_v3_fl(vec, len_v3(vel1));
-              mul_v3_fl(vec, (2.0f - t) / 2.0f);
-              sub_v3_v3v3(bbd->wanted_co, vel1, vec);
-              bbd->wanted_speed = len_v3(bbd->wanted_co);
-              ret = 1;
-            }
-          }
-        }
-      }
-    }
-  }
-  if (ptn) {
-    MEM_freeN(ptn);
-    ptn = NULL;
+    data.particles = bbd->sim->psys->particles;
+    data.index_exclude = pa - bbd->sim->psys->particles;
+    psys_grid_range_query(bbd->grid, pa->prev_state.co, range, boid_avoid_collision_cb, &data);
   }
 
   /* check boids in other systems */
-  for (pt = bbd->sim->psys->targets.first; pt; pt = pt->next) {
+  for (pt = bbd->sim->psys->targets.first, i = 0; pt; pt = pt->next, i++) {
     ParticleSystem *epsys = psys_get_target_system(bbd->sim->ob, pt);
 
     if (epsys) {
-      BLI_assert(epsys->tree != NULL);
-      neighbors = BLI_kdtree_3d_range_search_with_len_squared_cb(epsys->tree,
-                                                                 pa->prev_state.co,
-                                                                 &ptn,
-                                                                 acbr->look_ahead *
-                                                                     len_v3(pa->prev_state.vel),
-                                                                 len_squared_v3v3_with_normal_bias,
-                                                                 pa->prev_state.ave);
-
-      if (neighbors > 0) {
-        for (n = 0; n < neighbors; n++) {
-          copy_v3_v3(co1, pa->prev_state.co);
-          copy_v3_v3(vel1, pa->prev_state.vel);
-          copy_v3_v3(co2, (epsys->particles + ptn[n].index)->prev_state.co);
-          copy_v3_v3(vel2, (epsys->particles + ptn[n].index)->prev_state.vel);
-
-          sub_v3_v3v3(loc, co1, co2);
-
-          sub_v3_v3v3(vec, vel1, vel2);
-
-          inp = dot_v3v3(vec, vec);
-
-          /* velocities not parallel */
-          if (inp != 0.0f) {
-            t = -dot_v3v3(loc, vec) / inp;
-            /* cpa is not too far in the future so investigate further */
-            if (t > 0.0f && t < t_min) {
-              madd_v3_v3fl(co1, vel1, t);
-              madd_v3_v3fl(co2, vel2, t);
-
-              sub_v3_v3v3(vec, co2, co1);
-
-              len = normalize_v3(vec);
-
-              /* distance of cpa is close enough */
-              if (len < 2.0f * val->personal_space * pa->size) {
-                t_min = t;
-
-                mul_v3_fl(vec, len_v3(vel1));
-                mul_v3_fl(vec, (2.0f - t) / 2.0f);
-                sub_v3_v3v3(bbd->wanted_co, vel1, vec);
-                bbd->wanted_speed = len_v3(bbd->wanted_co);
-                ret = 1;
-              }
-            }
-          }
-        }
-      }
-
-      if (ptn) {
-        MEM_freeN(ptn);
-        ptn = NULL;
-      }
+      BLI_assert(bbd->target_grids[i] != NULL);
+      data.particles = epsys->particles;
+      data.index_exclude = -1;
+      psys_grid_range_query(
+          bbd->target_grids[i], pa->prev_state.co, range, boid_avoid_collision_cb, &data);
     }
   }
 
-  if (ptn && nearest == 0) {
-    MEM_freeN(ptn);
-  }
-
-  return ret;
+  return data.ret;
 }
 static bool rule_separate(BoidRule *UNUSED(rule),
                           BoidBrainData *bbd,
                           BoidValues *val,
                           ParticleData *pa)
 {
-  KDTreeNearest_3d *ptn = NULL;
+  KDTreeNearest_3d ptn;
   ParticleTarget *pt;
-  float len = 2.0f * val->personal_space * pa->size + 1.0f;
+  const float range = 2.0f * val->personal_space * pa->size;
+  float len = range + 1.0f;
   float vec[3] = {0.0f, 0.0f, 0.0f};
-  int neighbors = BLI_kdtree_3d_range_search(
-      bbd->sim->psys->tree, pa->prev_state.co, &ptn, 2.0f * val->personal_space * pa->size);
+  int neighbors = psys_grid_find_nearest_n(
+      bbd->grid, pa->prev_state.co, range, pa - bbd->sim->psys->particles, &ptn, 1, NULL, NULL);
+  int i;
   bool ret = false;
 
-  if (neighbors > 1 && ptn[1].dist != 0.0f) {
-    sub_v3_v3v3(vec, pa->prev_state.co, bbd->sim->psys->particles[ptn[1].index].state.co);
-    mul_v3_fl(vec, (2.0f * val->personal_space * pa->size - ptn[1].dist) / ptn[1].dist);
+  if (neighbors > 0 && ptn.dist != 0.0f) {
+    sub_v3_v3v3(vec, pa->prev_state.co, bbd->sim->psys->particles[ptn.index].state.co);
+    mul_v3_fl(vec, (range - ptn.dist) / ptn.dist);
     add_v3_v3(bbd->wanted_co, vec);
     bbd->wanted_speed = val->max_speed;
-    len = ptn[1].dist;
+    len = ptn.dist;
     ret = 1;
   }
-  if (ptn) {
-    MEM_freeN(ptn);
-    ptn = NULL;
-  }
 
   /* check other boid systems */
-  for (pt = bbd->sim->psys->targets.first; pt; pt = pt->next) {
+  for (pt = bbd->sim->psys->targets.first, i = 0; pt; pt = pt->next, i++) {
     ParticleSystem *epsys = psys_get_target_system(bbd->sim->ob, pt);
 
     if (epsys) {
-      neighbors = BLI_kdtree_3d_range_search(
-          epsys->tree, pa->prev_state.co, &ptn, 2.0f * val->personal_space * pa->size);
+      neighbors = psys_grid_find_nearest_n(
+          bbd->target_grids[i], pa->prev_state.co, range, -1, &ptn, 1, NULL, NULL);
 
-      if (neighbors > 0 && ptn[0].dist < len) {
-        sub_v3_v3v3(vec, pa->prev_state.co, ptn[0].co);
-        mul_v3_fl(vec, (2.0f * val->personal_space * pa->size - ptn[0].dist) / ptn[1].dist);
+      if (neighbors > 0 && ptn.dist != 0.0f && ptn.dist < len) {
+        sub_v3_v3v3(vec, pa->prev_state.co, ptn.co);
+        mul_v3_fl(vec, (range - ptn.dist) / ptn.dist);
         add_v3_v3(bbd->wanted_co, vec);
         bbd->wanted_speed = val->max_speed;
-        len = ptn[0].dist;
+        len = ptn.dist;
         ret = true;
       }
-
-      if (ptn) {
-        MEM_freeN(ptn);
-        ptn = NULL;
-      }
     }
   }
   return ret;
@@ -470,26 +441,27 @@ static bool rule_flock(BoidRule *UNUSED(rule),
                        BoidValues *UNUSED(val),
                        ParticleData *pa)
 {
-  KDTreeNearest_3d ptn[11];
+  KDTreeNearest_3d ptn[10];
   float vec[3] = {0.0f, 0.0f, 0.0f}, loc[3] = {0.0f, 0.0f, 0.0f};
-  int neighbors = BLI_kdtree_3d_find_nearest_n_with_len_squared_cb(
-      bbd->sim->psys->tree,
-      pa->state.co,
-      ptn,
-      ARRAY_SIZE(ptn),
-      len_squared_v3v3_with_normal_bias,
-      pa->prev_state.ave);
+  int neighbors = psys_grid_find_nearest_n(bbd->grid,
+                                           pa->state.co,
+                                           FLT_MAX,
+                                           pa - bbd->sim->psys->particles,
+                                           ptn,
+                                           ARRAY_SIZE(ptn),
+                                           len_squared_v3v3_with_normal_bias,
+                                           pa->prev_state.ave);
   int n;
   bool ret = false;
 
-  if (neighbors > 1) {
-    for (n = 1; n < neighbors; n++) {
+  if (neighbors > 0) {
+    for (n = 0; n < neighbors; n++) {
       add_v3_v3(loc, bbd->sim->psys->particles[ptn[n].index].prev_state.co);
       add_v3_v3(vec, bbd->sim->psys->particles[ptn[n].index].prev_state.vel);
     }
 
-    mul_v3_fl(loc, 1.0f / ((float)neighbors - 1.0f));
-    mul_v3_fl(vec, 1.0f / ((float)neighbors - 1.0f));
+    mul_v3_fl(loc, 1.0f / (float)neighbors);
+    mul_v3_fl(vec, 1.0f / (float)neighbors);
 
     sub_v3_v3(loc, pa->prev_state.co);
     sub_v3_v3(vec, pa->prev_state.vel);
@@ -697,10 +669,33 @@ static bool rule_average_speed(BoidRule *rule,
 
   return true;
 }
+typedef struct BoidFightNeighborData {
+  ParticleData *particles;
+
+  float health;
+  int nearest;
+  float nearest_dist_sq;
+} BoidFightNeighborData;
+
+static void boid_fight_neighbor_cb(void *userdata,
+                                   int index,
+                                   const float UNUSED(co[3]),
+                                   float dist_sq)
+{
+  BoidFightNeighborData *data = userdata;
+
+  data->health += data->particles[index].boid->data.health;
+
+  if (dist_sq < data->nearest_dist_sq) {
+    data->nearest = index;
+    data->nearest_dist_sq = dist_sq;
+  }
+}
+
 static bool rule_fight(BoidRule *rule, BoidBrainData *bbd, BoidValues *val, ParticleData *pa)
 {
   BoidRuleFight *fbr = (BoidRuleFight *)rule;
-  KDTreeNearest_3d *ptn = NULL;
+  BoidFightNeighborData data;
   ParticleTarget *pt;
   ParticleData *epars;
   ParticleData *enemy_pa = NULL;
@@ -709,55 +704,47 @@ static bool rule_fight(BoidRule *rule, BoidBrainData *bbd, BoidValues *val, Part
   float closest_enemy[3] = {0.0f, 0.0f, 0.0f};
   float closest_dist = fbr->distance + 1.0f;
   float f_strength = 0.0f, e_strength = 0.0f;
-  float health = 0.0f;
-  int n;
+  int i;
   bool ret = false;
 
   /* calculate own group strength */
-  int neighbors = BLI_kdtree_3d_range_search(
-      bbd->sim->psys->tree, pa->prev_state.co, &ptn, fbr->distance);
-  for (n = 0; n < neighbors; n++) {
-    bpa = bbd->sim->psys->particles[ptn[n].index].boid;
-    health += bpa->data.health;
-  }
+  data.particles = bbd->sim->psys->particles;
+  data.health = 0.0f;
+  data.nearest = -1;
+  data.nearest_dist_sq = FLT_MAX;
+  psys_grid_range_query(
+      bbd->grid, pa->prev_state.co, fbr->distance, boid_fight_neighbor_cb, &data);
 
-  f_strength += bbd->part->boids->strength * health;
-
-  if (ptn) {
-    MEM_freeN(ptn);
-    ptn = NULL;
-  }
+  f_strength += bbd->part->boids->strength * data.health;
 
   /* add other friendlies and calculate enemy strength and find closest enemy */
-  for (pt = bbd->sim->psys->targets.first; pt; pt = pt->next) {
+  for (pt = bbd->sim->psys->targets.first, i = 0; pt; pt = pt->next, i++) {
     ParticleSystem *epsys = psys_get_target_system(bbd->sim->ob, pt);
     if (epsys) {
       epars = epsys->particles;
 
-      neighbors = BLI_kdtree_3d_range_search(epsys->tree, pa->prev_state.co, &ptn, fbr->distance);
-
-      health = 0.0f;
-
-      for (n = 0; n < neighbors; n++) {
-        bpa = epars[ptn[n].index].boid;
-        health += bpa->data.health;
-
-        if (n == 0 && pt->mode == PTARGET_MODE_ENEMY && ptn[n].dist < closest_dist) {
-          copy_v3_v3(closest_enemy, ptn[n].co);
-          closest_dist = ptn[n].dist;
-          enemy_pa = epars + ptn[n].index;
-        }
+      data.particles = epars;
+      data.health = 0.0f;
+      data.nearest = -1;
+      data.nearest_dist_sq = FLT_MAX;
+      psys_grid_range_query(bbd->target_grids[i],
+                            pa->prev_state.co,
+                            fbr->distance,
+                            boid_fight_neighbor_cb,
+                            &data);
+
+      if (data.nearest != -1 && pt->mode == PTARGET_MODE_ENEMY &&
+          sqrtf(data.nearest_dist_sq) < closest_dist) {
+        copy_v3_v3(closest_enemy, epars[data.nearest].prev_state.co);
+        closest_dist = sqrtf(data.nearest_dist_sq);
+        enemy_pa = epars + data.nearest;
       }
+
       if (pt->mode == PTARGET_MODE_ENEMY) {
-        e_strength += epsys->part->boids->strength * health;
+        e_strength += epsys->part->boids->strength * data.health;
       }
       else if (pt->mode == PTARGET_MODE_FRIEND) {
-        f_strength += epsys->part->boids->strength * health;
-      }
-
-      if (ptn) {
-        MEM_freeN(ptn);
-        ptn = NULL;
+        f_strength += epsys->part->boids->strength * data.health;
       }
     }
   }
@@ -979,6 +966,22 @@ static bool boid_rule_applies(ParticleData *pa, BoidSettings *UNUSED(boids), Boi
 
   return false;
 }
+/* Rules only write to the boid they are evaluated for, except for fighting which damages
+ * other boids and reads their health. */
+bool boids_rules_thread_safe(const ParticleSettings *part)
+{
+  const BoidState *state = part->boids->states.first;
+  const BoidRule *rule;
+  for (; state; state = state->next) {
+    for (rule = state->rules.first; rule; rule = rule->next) {
+      if (rule->type == eBoidRuleType_Fight) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 void boids_precalc_rules(ParticleSettings *part, float cfra)
 {
   BoidState *state = part->boids->states.first;
@@ -1087,6 +1090,8 @@ void boid_brain(BoidBrainData *bbd, int p, ParticleData *pa)
   int rand;
   // BoidCondition *cond;
 
+  bbd->do_jump = false;
+
   if (bpa->data.health <= 0.0f) {
     pa->alive = PARS_DYING;
     pa->dietime = bbd->cfra;
@@ -1225,7 +1230,9 @@ void boid_brain(BoidBrainData *bbd, int p, ParticleData *pa)
       }
 
       if (jump) {
-        copy_v3_v3(pa->prev_state.vel, jump_v);
+        /* Other boids of this step still see the previous velocity, see #boid_body. */
+        copy_v3_v3(bbd->jump_vel, jump_v);
+        bbd->do_jump = true;
         bpa->data.mode = eBoidMode_Falling;
       }
     }
@@ -1250,6 +1257,10 @@ void boid_body(BoidBrainData *bbd, ParticleData *pa)
 
   set_boid_values(&val, boids, pa);
 
+  if (bbd->do_jump) {
+    copy_v3_v3(pa->prev_state.vel, bbd->jump_vel);
+  }
+
   /* make sure there's something in new velocity, location & rotation */
   copy_particle_key(&pa->state, &pa->prev_state, 0);
 
@@ -74,6 +74,47 @@ typedef struct SelfColDetectData {
   bool collided;
 } SelfColDetectData;
 
+/* Impulses of one self-collision pair, computed in parallel and applied in order. */
+typedef struct SelfColImpulse {
+  float ia[3][3];
+  float ib[3][3];
+  /* SELFCOL_IMPULSE_* */
+  char state;
+} SelfColImpulse;
+
+enum {
+  /* Pair is not handled by the static response. */
+  SELFCOL_IMPULSE_SKIP = 0,
+  /* Impulses are computed, but the pair did not need a response. */
+  SELFCOL_IMPULSE_NONE = 1,
+  /* Pair needs a response. */
+  SELFCOL_IMPULSE_APPLY = 2,
+};
+
+typedef struct SelfColResponseData {
+  ClothModifierData *clmd;
+  const CollPair *collpair;
+  SelfColImpulse *impulses;
+  float time_multiplier;
+  float min_distance;
+} SelfColResponseData;
+
+/* Broad phase data of the cloth self-collision, kept between substeps. */
+typedef struct SelfCollisionCache {
+  /* Candidate triangle pairs, found using bounds inflated by the margin. These are not filtered
+   * by the vertex flags, which can change between frames while the pairs are still valid. */
+  BVHTreeOverlap *pairs;
+  uint pairs_len;
+  /* The subset of pairs that is active for the current substep. */
+  BVHTreeOverlap *active_pairs;
+  /* Vertex positions the pairs were found for. */
+  float (*co)[3];
+  uint mvert_num;
+  uint tri_num;
+  float epsilon;
+  float margin;
+} SelfCollisionCache;
+
 /***********************************
  * Collision modifier code start
  ***********************************/
@@ -837,107 +878,130 @@ static int cloth_collision_response_static(ClothModifierData *clmd,
   return result;
 }
 
-static int cloth_selfcollision_response_static(ClothModifierData *clmd,
-                                               CollPair *collpair,
-                                               uint collision_count,
-                                               const float dt)
+static void cloth_selfcollision_impulse(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  int result = 0;
+  SelfColResponseData *data = userdata;
+  ClothModifierData *clmd = data->clmd;
   Cloth *cloth = clmd->clothObject;
-  const float clamp_sq = square_f(clmd->coll_parms->self_clamp * dt);
-  const float time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
-  const float min_distance = (2.0f * clmd->coll_parms->selfepsilon) * (8.0f / 9.0f);
+  const CollPair *collpair = &data->collpair[i];
+  SelfColImpulse *result = &data->impulses[i];
+  const float time_multiplier = data->time_multiplier;
+  const float min_distance = data->min_distance;
+  float(*ia)[3] = result->ia;
+  float(*ib)[3] = result->ib;
+  float w1, w2, w3, u1, u2, u3;
+  float v1[3], v2[3], relativeVelocity[3];
+
+  memset(ia, 0, sizeof(result->ia));
+  memset(ib, 0, sizeof(result->ib));
+  result->state = SELFCOL_IMPULSE_SKIP;
+
+  /* Only handle static collisions here. */
+  if (collpair->flag & (COLLISION_IN_FUTURE | COLLISION_INACTIVE)) {
+    return;
+  }
 
-  for (int i = 0; i < collision_count; i++, collpair++) {
-    float ia[3][3] = {{0.0f}};
-    float ib[3][3] = {{0.0f}};
-    float w1, w2, w3, u1, u2, u3;
-    float v1[3], v2[3], relativeVelocity[3];
+  result->state = SELFCOL_IMPULSE_NONE;
 
-    /* Only handle static collisions here. */
-    if (collpair->flag & (COLLISION_IN_FUTURE | COLLISION_INACTIVE)) {
-      continue;
-    }
+  /* Compute barycentric coordinates for both collision points. */
+  collision_compute_barycentric(collpair->pa,
+                                cloth->verts[collpair->ap1].tx,
+                                cloth->verts[collpair->ap2].tx,
+                                cloth->verts[collpair->ap3].tx,
+                                &w1,
+                                &w2,
+                                &w3);
 
-    /* Compute barycentric coordinates for both collision points. */
-    collision_compute_barycentric(collpair->pa,
-                                  cloth->verts[collpair->ap1].tx,
-                                  cloth->verts[collpair->ap2].tx,
-                                  cloth->verts[collpair->ap3].tx,
-                                  &w1,
-                                  &w2,
-                                  &w3);
+  collision_compute_barycentric(collpair->pb,
+                                cloth->verts[collpair->bp1].tx,
+                                cloth->verts[collpair->bp2].tx,
+                                cloth->verts[collpair->bp3].tx,
+                                &u1,
+                                &u2,
+                                &u3);
 
-    collision_compute_barycentric(collpair->pb,
-                                  cloth->verts[collpair->bp1].tx,
-                                  cloth->verts[collpair->bp2].tx,
-                                  cloth->verts[collpair->bp3].tx,
-                                  &u1,
-                                  &u2,
-                                  &u3);
+  /* Calculate relative "velocity". */
+  collision_interpolateOnTriangle(v1,
+                                  cloth->verts[collpair->ap1].tv,
+                                  cloth->verts[collpair->ap2].tv,
+                                  cloth->verts[collpair->ap3].tv,
+                                  w1,
+                                  w2,
+                                  w3);
+
+  collision_interpolateOnTriangle(v2,
+                                  cloth->verts[collpair->bp1].tv,
+                                  cloth->verts[collpair->bp2].tv,
+                                  cloth->verts[collpair->bp3].tv,
+                                  u1,
+                                  u2,
+                                  u3);
 
-    /* Calculate relative "velocity". */
-    collision_interpolateOnTriangle(v1,
-                                    cloth->verts[collpair->ap1].tv,
-                                    cloth->verts[collpair->ap2].tv,
-                                    cloth->verts[collpair->ap3].tv,
-                                    w1,
-                                    w2,
-                                    w3);
+  sub_v3_v3v3(relativeVelocity, v2, v1);
 
-    collision_interpolateOnTriangle(v2,
-                                    cloth->verts[collpair->bp1].tv,
-                                    cloth->verts[collpair->bp2].tv,
-                                    cloth->verts[collpair->bp3].tv,
-                                    u1,
-                                    u2,
-                                    u3);
+  /* Calculate the normal component of the relative velocity
+   * (actually only the magnitude - the direction is stored in 'normal'). */
+  const float magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
+  const float d = min_distance - collpair->distance;
 
-    sub_v3_v3v3(relativeVelocity, v2, v1);
+  /* TODO: Impulses should be weighed by mass as this is self col,
+   * this has to be done after mass distribution is implemented. */
 
-    /* Calculate the normal component of the relative velocity
-     * (actually only the magnitude - the direction is stored in 'normal'). */
-    const float magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
-    const float d = min_distance - collpair->distance;
+  /* If magrelVel < 0 the edges are approaching each other. */
+  if (magrelVel > 0.0f) {
+    /* Calculate Impulse magnitude to stop all motion in normal direction. */
+    float magtangent = 0, repulse = 0;
+    double impulse = 0.0;
+    float vrel_t_pre[3];
+    float temp[3];
 
-    /* TODO: Impulses should be weighed by mass as this is self col,
-     * this has to be done after mass distribution is implemented. */
+    /* Calculate tangential velocity. */
+    copy_v3_v3(temp, collpair->normal);
+    mul_v3_fl(temp, magrelVel);
+    sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
 
-    /* If magrelVel < 0 the edges are approaching each other. */
-    if (magrelVel > 0.0f) {
-      /* Calculate Impulse magnitude to stop all motion in normal direction. */
-      float magtangent = 0, repulse = 0;
-      double impulse = 0.0;
-      float vrel_t_pre[3];
-      float temp[3];
+    /* Decrease in magnitude of relative tangential velocity due to coulomb friction
+     * in original formula "magrelVel" should be the
+     * "change of relative velocity in normal direction". */
+    magtangent = min_ff(clmd->coll_parms->self_friction * 0.01f * magrelVel, len_v3(vrel_t_pre));
 
-      /* Calculate tangential velocity. */
-      copy_v3_v3(temp, collpair->normal);
-      mul_v3_fl(temp, magrelVel);
-      sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
+    /* Apply friction impulse. */
+    if (magtangent > ALMOST_ZERO) {
+      normalize_v3(vrel_t_pre);
 
-      /* Decrease in magnitude of relative tangential velocity due to coulomb friction
-       * in original formula "magrelVel" should be the
-       * "change of relative velocity in normal direction". */
-      magtangent = min_ff(clmd->coll_parms->self_friction * 0.01f * magrelVel, len_v3(vrel_t_pre));
+      impulse = magtangent / 1.5;
 
-      /* Apply friction impulse. */
-      if (magtangent > ALMOST_ZERO) {
-        normalize_v3(vrel_t_pre);
+      VECADDMUL(ia[0], vrel_t_pre, (double)w1 * impulse);
+      VECADDMUL(ia[1], vrel_t_pre, (double)w2 * impulse);
+      VECADDMUL(ia[2], vrel_t_pre, (double)w3 * impulse);
 
-        impulse = magtangent / 1.5;
+      VECADDMUL(ib[0], vrel_t_pre, (double)u1 * -impulse);
+      VECADDMUL(ib[1], vrel_t_pre, (double)u2 * -impulse);
+      VECADDMUL(ib[2], vrel_t_pre, (double)u3 * -impulse);
+    }
+
+    /* Apply velocity stopping impulse. */
+    impulse = magrelVel / 3.0f;
+
+    VECADDMUL(ia[0], collpair->normal, (double)w1 * impulse);
+    VECADDMUL(ia[1], collpair->normal, (double)w2 * impulse);
+    VECADDMUL(ia[2], collpair->normal, (double)w3 * impulse);
 
-        VECADDMUL(ia[0], vrel_t_pre, (double)w1 * impulse);
-        VECADDMUL(ia[1], vrel_t_pre, (double)w2 * impulse);
-        VECADDMUL(ia[2], vrel_t_pre, (double)w3 * impulse);
+    VECADDMUL(ib[0], collpair->normal, (double)u1 * -impulse);
+    VECADDMUL(ib[1], collpair->normal, (double)u2 * -impulse);
+    VECADDMUL(ib[2], collpair->normal, (double)u3 * -impulse);
 
-        VECADDMUL(ib[0], vrel_t_pre, (double)u1 * -impulse);
-        VECADDMUL(ib[1], vrel_t_pre, (double)u2 * -impulse);
-        VECADDMUL(ib[2], vrel_t_pre, (double)u3 * -impulse);
+    if ((magrelVel < 0.1f * d * time_multiplier) && (d > ALMOST_ZERO)) {
+      repulse = MIN2(d / time_multiplier, 0.1f * d * time_multiplier - magrelVel);
+
+      if (impulse > ALMOST_ZERO) {
+        repulse = min_ff(repulse, 5.0 * impulse);
       }
 
-      /* Apply velocity stopping impulse. */
-      impulse = magrelVel / 3.0f;
+      repulse = max_ff(impulse, repulse);
+      impulse = repulse / 1.5f;
 
       VECADDMUL(ia[0], collpair->normal, (double)w1 * impulse);
       VECADDMUL(ia[1], collpair->normal, (double)w2 * impulse);
@@ -946,55 +1010,76 @@ static int cloth_selfcollision_response_static(ClothModifierData *clmd,
       VECADDMUL(ib[0], collpair->normal, (double)u1 * -impulse);
       VECADDMUL(ib[1], collpair->normal, (double)u2 * -impulse);
       VECADDMUL(ib[2], collpair->normal, (double)u3 * -impulse);
+    }
 
-      if ((magrelVel < 0.1f * d * time_multiplier) && (d > ALMOST_ZERO)) {
-        repulse = MIN2(d / time_multiplier, 0.1f * d * time_multiplier - magrelVel);
+    result->state = SELFCOL_IMPULSE_APPLY;
+  }
+  else if (d > ALMOST_ZERO) {
+    /* Stay on the safe side and clamp repulse. */
+    float repulse = d * 1.0f / time_multiplier;
+    float impulse = repulse / 9.0f;
 
-        if (impulse > ALMOST_ZERO) {
-          repulse = min_ff(repulse, 5.0 * impulse);
-        }
+    VECADDMUL(ia[0], collpair->normal, w1 * impulse);
+    VECADDMUL(ia[1], collpair->normal, w2 * impulse);
+    VECADDMUL(ia[2], collpair->normal, w3 * impulse);
 
-        repulse = max_ff(impulse, repulse);
-        impulse = repulse / 1.5f;
+    VECADDMUL(ib[0], collpair->normal, u1 * -impulse);
+    VECADDMUL(ib[1], collpair->normal, u2 * -impulse);
+    VECADDMUL(ib[2], collpair->normal, u3 * -impulse);
 
-        VECADDMUL(ia[0], collpair->normal, (double)w1 * impulse);
-        VECADDMUL(ia[1], collpair->normal, (double)w2 * impulse);
-        VECADDMUL(ia[2], collpair->normal, (double)w3 * impulse);
+    result->state = SELFCOL_IMPULSE_APPLY;
+  }
+}
 
-        VECADDMUL(ib[0], collpair->normal, (double)u1 * -impulse);
-        VECADDMUL(ib[1], collpair->normal, (double)u2 * -impulse);
-        VECADDMUL(ib[2], collpair->normal, (double)u3 * -impulse);
-      }
+static int cloth_selfcollision_response_static(ClothModifierData *clmd,
+                                               CollPair *collpair,
+                                               uint collision_count,
+                                               const float dt)
+{
+  int result = 0;
+  Cloth *cloth = clmd->clothObject;
+  const float clamp_sq = square_f(clmd->coll_parms->self_clamp * dt);
 
-      result = 1;
-    }
-    else if (d > ALMOST_ZERO) {
-      /* Stay on the safe side and clamp repulse. */
-      float repulse = d * 1.0f / time_multiplier;
-      float impulse = repulse / 9.0f;
+  /* Impulses of all pairs are computed in parallel. They are accumulated into the vertices
+   * afterwards in the original order, which keeps the result independent of threading. */
+  SelfColImpulse *impulses = MEM_mallocN(sizeof(*impulses) * collision_count, __func__);
+  SelfColResponseData data = {
+      .clmd = clmd,
+      .collpair = collpair,
+      .impulses = impulses,
+      .time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale),
+      .min_distance = (2.0f * clmd->coll_parms->selfepsilon) * (8.0f / 9.0f),
+  };
 
-      VECADDMUL(ia[0], collpair->normal, w1 * impulse);
-      VECADDMUL(ia[1], collpair->normal, w2 * impulse);
-      VECADDMUL(ia[2], collpair->normal, w3 * impulse);
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 64;
+  BLI_task_parallel_range(0, collision_count, &data, cloth_selfcollision_impulse, &settings);
 
-      VECADDMUL(ib[0], collpair->normal, u1 * -impulse);
-      VECADDMUL(ib[1], collpair->normal, u2 * -impulse);
-      VECADDMUL(ib[2], collpair->normal, u3 * -impulse);
+  for (int i = 0; i < collision_count; i++, collpair++) {
+    const SelfColImpulse *impulse = &impulses[i];
 
+    if (impulse->state == SELFCOL_IMPULSE_SKIP) {
+      continue;
+    }
+
+    if (impulse->state == SELFCOL_IMPULSE_APPLY) {
       result = 1;
     }
 
     if (result) {
-      cloth_collision_impulse_vert(clamp_sq, ia[0], &cloth->verts[collpair->ap1]);
-      cloth_collision_impulse_vert(clamp_sq, ia[1], &cloth->verts[collpair->ap2]);
-      cloth_collision_impulse_vert(clamp_sq, ia[2], &cloth->verts[collpair->ap3]);
+      cloth_collision_impulse_vert(clamp_sq, impulse->ia[0], &cloth->verts[collpair->ap1]);
+      cloth_collision_impulse_vert(clamp_sq, impulse->ia[1], &cloth->verts[collpair->ap2]);
+      cloth_collision_impulse_vert(clamp_sq, impulse->ia[2], &cloth->verts[collpair->ap3]);
 
-      cloth_collision_impulse_vert(clamp_sq, ib[0], &cloth->verts[collpair->bp1]);
-      cloth_collision_impulse_vert(clamp_sq, ib[1], &cloth->verts[collpair->bp2]);
-      cloth_collision_impulse_vert(clamp_sq, ib[2], &cloth->verts[collpair->bp3]);
+      cloth_collision_impulse_vert(clamp_sq, impulse->ib[0], &cloth->verts[collpair->bp1]);
+      cloth_collision_impulse_vert(clamp_sq, impulse->ib[1], &cloth->verts[collpair->bp2]);
+      cloth_collision_impulse_vert(clamp_sq, impulse->ib[2], &cloth->verts[collpair->bp3]);
     }
   }
 
+  MEM_freeN(impulses);
+
   return result;
 }
 
@@ -1533,6 +1618,398 @@ static int cloth_bvh_selfcollisions_resolve(ClothModifierData *clmd,
   return ret;
 }
 
+/***********************************
+ * Self-collision broad phase
+ *
+ * Candidate triangle pairs are found with a uniform spatial hash of the triangle bounds. The
+ * bounds are inflated by a margin, so the pairs remain valid for following substeps as long as
+ * no vertex moved further than the margin since they were found.
+ ***********************************/
+
+/* Margin the triangle bounds are inflated by, relative to the self-collision distance. */
+#define SELFCOL_MARGIN_FAC 1.0f
+/* Limit the average amount of cells per triangle, the cell size is grown until it fits. */
+#define SELFCOL_MAX_CELLS_PER_TRI 8
+
+typedef struct SelfColHashEntry {
+  uint tri;
+  int cell[3];
+} SelfColHashEntry;
+
+typedef struct SelfColBroadphaseData {
+  const float (*bounds_min)[3];
+  const float (*bounds_max)[3];
+  float cell_size;
+  /* Hash entries sorted by bucket. */
+  const SelfColHashEntry *entries;
+  const uint *bucket_offsets;
+  /* Number of pairs found in each bucket, and where they are written to. */
+  uint *bucket_pairs;
+  BVHTreeOverlap *pairs;
+} SelfColBroadphaseData;
+
+BLI_INLINE uint selfcol_cell_hash(const int cell[3], uint mask)
+{
+  return (((uint)cell[0] * 73856093u) ^ ((uint)cell[1] * 19349663u) ^
+          ((uint)cell[2] * 83492791u)) &
+         mask;
+}
+
+BLI_INLINE void selfcol_cell_of_point(const float co[3], float cell_size, int r_cell[3])
+{
+  r_cell[0] = (int)floorf(co[0] / cell_size);
+  r_cell[1] = (int)floorf(co[1] / cell_size);
+  r_cell[2] = (int)floorf(co[2] / cell_size);
+}
+
+/* Test the entries of one bucket against each other. Every pair is only reported by the cell
+ * that contains the minimum corner of the overlap of both bounds, so it is found exactly once. */
+static uint selfcol_bucket_pairs(const SelfColBroadphaseData *data,
+                                 const uint bucket,
+                                 BVHTreeOverlap *r_pairs)
+{
+  const SelfColHashEntry *entries = data->entries;
+  uint pairs_num = 0;
+
+  for (uint i = data->bucket_offsets[bucket]; i < data->bucket_offsets[bucket + 1]; i++) {
+    for (uint j = i + 1; j < data->bucket_offsets[bucket + 1]; j++) {
+      const SelfColHashEntry *a = &entries[i], *b = &entries[j];
+
+      /* Different cells can share a bucket. */
+      if (a->cell[0] != b->cell[0] || a->cell[1] != b->cell[1] || a->cell[2] != b->cell[2]) {
+        continue;
+      }
+
+      const float *min_a = data->bounds_min[a->tri], *max_a = data->bounds_max[a->tri];
+      const float *min_b = data->bounds_min[b->tri], *max_b = data->bounds_max[b->tri];
+      if (!isect_aabb_aabb_v3(min_a, max_a, min_b, max_b)) {
+        continue;
+      }
+
+      float overlap_min[3];
+      int home_cell[3];
+      overlap_min[0] = max_ff(min_a[0], min_b[0]);
+      overlap_min[1] = max_ff(min_a[1], min_b[1]);
+      overlap_min[2] = max_ff(min_a[2], min_b[2]);
+      selfcol_cell_of_point(overlap_min, data->cell_size, home_cell);
+      if (!equals_v3v3_int(home_cell, a->cell)) {
+        continue;
+      }
+
+      const uint tri_a = MIN2(a->tri, b->tri), tri_b = MAX2(a->tri, b->tri);
+      if (r_pairs) {
+        r_pairs[pairs_num].indexA = (int)tri_a;
+        r_pairs[pairs_num].indexB = (int)tri_b;
+      }
+      pairs_num++;
+    }
+  }
+
+  return pairs_num;
+}
+
+static void selfcol_bucket_count_cb(void *__restrict userdata,
+                                    const int bucket,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SelfColBroadphaseData *data = userdata;
+  data->bucket_pairs[bucket] = selfcol_bucket_pairs(data, (uint)bucket, NULL);
+}
+
+static void selfcol_bucket_fill_cb(void *__restrict userdata,
+                                   const int bucket,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SelfColBroadphaseData *data = userdata;
+  selfcol_bucket_pairs(data, (uint)bucket, data->pairs + data->bucket_pairs[bucket]);
+}
+
+BLI_INLINE bool selfcol_bounds_is_finite(const float bounds_min[3], const float bounds_max[3])
+{
+  return isfinite(bounds_min[0]) && isfinite(bounds_min[1]) && isfinite(bounds_min[2]) &&
+         isfinite(bounds_max[0]) && isfinite(bounds_max[1]) && isfinite(bounds_max[2]);
+}
+
+/* Cell range covered by a triangle, false for non-finite bounds which are left out. */
+static bool selfcol_cell_range(const float bounds_min[3],
+                               const float bounds_max[3],
+                               float cell_size,
+                               int r_cell_min[3],
+                               int r_cell_max[3])
+{
+  if (!selfcol_bounds_is_finite(bounds_min, bounds_max)) {
+    return false;
+  }
+  selfcol_cell_of_point(bounds_min, cell_size, r_cell_min);
+  selfcol_cell_of_point(bounds_max, cell_size, r_cell_max);
+  return true;
+}
+
+/* Amount of cells covered by all triangles, as double so large bounds can not overflow. */
+static double selfcol_cells_num(const float (*bounds_min)[3],
+                                const float (*bounds_max)[3],
+                                const uint tri_num,
+                                const float cell_size)
+{
+  double cells_num = 0.0;
+  for (uint i = 0; i < tri_num; i++) {
+    if (!selfcol_bounds_is_finite(bounds_min[i], bounds_max[i])) {
+      continue;
+    }
+    double tri_cells_num = 1.0;
+    for (int k = 0; k < 3; k++) {
+      tri_cells_num *= floor((double)bounds_max[i][k] / cell_size) -
+                       floor((double)bounds_min[i][k] / cell_size) + 1.0;
+    }
+    cells_num += tri_cells_num;
+  }
+  return cells_num;
+}
+
+static void selfcol_cache_build(ClothModifierData *clmd, SelfCollisionCache *cache)
+{
+  Cloth *cloth = clmd->clothObject;
+  const ClothVertex *verts = cloth->verts;
+  const uint tri_num = cloth->primitive_num;
+  const float epsilon = clmd->coll_parms->selfepsilon;
+  const float margin = max_ff(epsilon * SELFCOL_MARGIN_FAC, FLT_EPSILON);
+
+  MEM_SAFE_FREE(cache->pairs);
+  MEM_SAFE_FREE(cache->active_pairs);
+  cache->pairs_len = 0;
+
+  /* Remember positions to detect when the pairs have to be updated. */
+  if (cache->mvert_num != cloth->mvert_num) {
+    MEM_SAFE_FREE(cache->co);
+  }
+  if (cache->co == NULL) {
+    cache->co = MEM_mallocN(sizeof(*cache->co) * cloth->mvert_num, __func__);
+  }
+  for (uint i = 0; i < cloth->mvert_num; i++) {
+    copy_v3_v3(cache->co[i], verts[i].tx);
+  }
+  cache->mvert_num = cloth->mvert_num;
+  cache->tri_num = tri_num;
+  cache->epsilon = epsilon;
+  cache->margin = margin;
+
+  if (tri_num == 0) {
+    return;
+  }
+
+  /* Triangle bounds, inflated by the collision distance and the margin. */
+  float(*bounds_min)[3] = MEM_mallocN(sizeof(*bounds_min) * tri_num, __func__);
+  float(*bounds_max)[3] = MEM_mallocN(sizeof(*bounds_max) * tri_num, __func__);
+  float extent_sum = 0.0f;
+
+  for (uint i = 0; i < tri_num; i++) {
+    const MVertTri *vt = &cloth->tri[i];
+    INIT_MINMAX(bounds_min[i], bounds_max[i]);
+    for (int j = 0; j < 3; j++) {
+      minmax_v3v3_v3(bounds_min[i], bounds_max[i], verts[vt->tri[j]].tx);
+    }
+    add_v3_fl(bounds_min[i], -(epsilon + margin));
+    add_v3_fl(bounds_max[i], epsilon + margin);
+
+    float extent[3];
+    sub_v3_v3v3(extent, bounds_max[i], bounds_min[i]);
+    const float extent_max = max_fff(extent[0], extent[1], extent[2]);
+    if (isfinite(extent_max)) {
+      extent_sum += extent_max;
+    }
+  }
+
+  /* Cells of the average triangle size, so most triangles only cover a few cells. Grow the
+   * cells when a few very large triangles would cover too many of them. */
+  float cell_size = max_ff(extent_sum / tri_num, FLT_EPSILON);
+  const double max_cells_num = (double)tri_num * SELFCOL_MAX_CELLS_PER_TRI;
+  while (selfcol_cells_num((const float(*)[3])bounds_min,
+                           (const float(*)[3])bounds_max,
+                           tri_num,
+                           cell_size) > max_cells_num) {
+    cell_size *= 2.0f;
+  }
+
+  /* Count the cells covered by each triangle, fits as it is bounded by the limit above. */
+  uint entries_num = 0;
+  for (uint i = 0; i < tri_num; i++) {
+    int cell_min[3], cell_max[3];
+    if (selfcol_cell_range(bounds_min[i], bounds_max[i], cell_size, cell_min, cell_max)) {
+      entries_num += (uint)((cell_max[0] - cell_min[0] + 1) * (cell_max[1] - cell_min[1] + 1) *
+                            (cell_max[2] - cell_min[2] + 1));
+    }
+  }
+
+  if (entries_num == 0) {
+    MEM_freeN(bounds_min);
+    MEM_freeN(bounds_max);
+    return;
+  }
+
+  const uint buckets_num = power_of_2_max_u(entries_num);
+  const uint mask = buckets_num - 1;
+  uint *bucket_offsets = MEM_callocN(sizeof(uint) * (buckets_num + 1), __func__);
+  SelfColHashEntry *entries = MEM_mallocN(sizeof(*entries) * entries_num, __func__);
+
+  /* Sort entries by bucket, counting first and filling afterwards. */
+  for (int pass = 0; pass < 2; pass++) {
+    for (uint i = 0; i < tri_num; i++) {
+      int cell_min[3], cell_max[3], cell[3];
+      if (!selfcol_cell_range(bounds_min[i], bounds_max[i], cell_size, cell_min, cell_max)) {
+        continue;
+      }
+
+      for (cell[0] = cell_min[0]; cell[0] <= cell_max[0]; cell[0]++) {
+        for (cell[1] = cell_min[1]; cell[1] <= cell_max[1]; cell[1]++) {
+          for (cell[2] = cell_min[2]; cell[2] <= cell_max[2]; cell[2]++) {
+            const uint bucket = selfcol_cell_hash(cell, mask);
+            if (pass == 0) {
+              bucket_offsets[bucket + 1]++;
+            }
+            else {
+              SelfColHashEntry *entry = &entries[bucket_offsets[bucket]++];
+              entry->tri = i;
+              copy_v3_v3_int(entry->cell, cell);
+            }
+          }
+        }
+      }
+    }
+
+    if (pass == 0) {
+      for (uint i = 0; i < buckets_num; i++) {
+        bucket_offsets[i + 1] += bucket_offsets[i];
+      }
+    }
+    else {
+      /* Filling moved every offset to the start of the next bucket. */
+      memmove(bucket_offsets + 1, bucket_offsets, sizeof(uint) * buckets_num);
+      bucket_offsets[0] = 0;
+    }
+  }
+
+  /* Find pairs in two passes, so they can be written in parallel without synchronization,
+   * in an order that does not depend on threading. */
+  uint *bucket_pairs = MEM_mallocN(sizeof(uint) * buckets_num, __func__);
+  SelfColBroadphaseData data = {
+      .bounds_min = (const float(*)[3])bounds_min,
+      .bounds_max = (const float(*)[3])bounds_max,
+      .cell_size = cell_size,
+      .entries = entries,
+      .bucket_offsets = bucket_offsets,
+      .bucket_pairs = bucket_pairs,
+      .pairs = NULL,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, (int)buckets_num, &data, selfcol_bucket_count_cb, &settings);
+
+  uint pairs_num = 0;
+  for (uint i = 0; i < buckets_num; i++) {
+    const uint bucket_num = bucket_pairs[i];
+    bucket_pairs[i] = pairs_num;
+    pairs_num += bucket_num;
+  }
+
+  if (pairs_num) {
+    data.pairs = MEM_mallocN(sizeof(BVHTreeOverlap) * pairs_num, __func__);
+    BLI_task_parallel_range(0, (int)buckets_num, &data, selfcol_bucket_fill_cb, &settings);
+  }
+
+  cache->pairs = data.pairs;
+  cache->pairs_len = pairs_num;
+  if (pairs_num) {
+    cache->active_pairs = MEM_mallocN(sizeof(BVHTreeOverlap) * pairs_num, __func__);
+  }
+
+  MEM_freeN(bucket_pairs);
+  MEM_freeN(entries);
+  MEM_freeN(bucket_offsets);
+  MEM_freeN(bounds_min);
+  MEM_freeN(bounds_max);
+}
+
+/* Check whether the cached pairs still contain all triangles within collision distance. */
+static bool selfcol_cache_is_valid(ClothModifierData *clmd, const SelfCollisionCache *cache)
+{
+  const Cloth *cloth = clmd->clothObject;
+
+  if (cache->co == NULL || cache->mvert_num != cloth->mvert_num ||
+      cache->tri_num != cloth->primitive_num ||
+      cache->epsilon != clmd->coll_parms->selfepsilon) {
+    return false;
+  }
+
+  /* Bounds were inflated by the margin, so they still contain the triangles as long as no
+   * vertex moved further than that. */
+  const float margin_sq = square_f(cache->margin);
+  for (uint i = 0; i < cloth->mvert_num; i++) {
+    if (len_squared_v3v3(cloth->verts[i].tx, cache->co[i]) > margin_sq) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Find candidate pairs of triangles for self-collision, the returned array is owned by the
+ * cloth and stays valid until the next call. */
+static BVHTreeOverlap *cloth_selfcollision_broadphase(ClothModifierData *clmd, uint *r_pairs_len)
+{
+  Cloth *cloth = clmd->clothObject;
+  ClothSolverResult *sres = clmd->solver_result;
+
+  if (cloth->selfcol_cache == NULL) {
+    cloth->selfcol_cache = MEM_callocN(sizeof(SelfCollisionCache), __func__);
+  }
+
+  SelfCollisionCache *cache = cloth->selfcol_cache;
+
+  if (selfcol_cache_is_valid(clmd, cache)) {
+    if (sres) {
+      sres->selfcol_reuses++;
+    }
+  }
+  else {
+    selfcol_cache_build(clmd, cache);
+    if (sres) {
+      sres->selfcol_builds++;
+    }
+  }
+
+  /* Pinned and excluded vertices can change every frame, so filter the pairs on every use. */
+  uint active_pairs_num = 0;
+  for (uint i = 0; i < cache->pairs_len; i++) {
+    const BVHTreeOverlap *pair = &cache->pairs[i];
+    if (cloth_bvh_selfcollision_is_active(
+            clmd, cloth, &cloth->tri[pair->indexA], &cloth->tri[pair->indexB])) {
+      cache->active_pairs[active_pairs_num++] = *pair;
+    }
+  }
+
+  if (sres) {
+    sres->selfcol_max_pairs = max_ii(sres->selfcol_max_pairs, (int)active_pairs_num);
+  }
+
+  *r_pairs_len = active_pairs_num;
+  return cache->active_pairs;
+}
+
+void cloth_selfcollision_cache_free(Cloth *cloth)
+{
+  SelfCollisionCache *cache = cloth->selfcol_cache;
+
+  if (cache) {
+    MEM_SAFE_FREE(cache->pairs);
+    MEM_SAFE_FREE(cache->active_pairs);
+    MEM_SAFE_FREE(cache->co);
+    MEM_freeN(cache);
+    cloth->selfcol_cache = NULL;
+  }
+}
+
 static bool cloth_bvh_obj_overlap_cb(void *userdata,
                                      int index_a,
                                      int UNUSED(index_b),
@@ -1545,23 +2022,6 @@ static bool cloth_bvh_obj_overlap_cb(void *userdata,
   return cloth_bvh_collision_is_active(clmd, clothObject, tri_a);
 }
 
-static bool cloth_bvh_self_overlap_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
-{
-  /* No need for equal combinations (eg. (0,1) & (1,0)). */
-  if (index_a < index_b) {
-    ClothModifierData *clmd = (ClothModifierData *)userdata;
-    struct Cloth *clothObject = clmd->clothObject;
-    const MVertTri *tri_a, *tri_b;
-    tri_a = &clothObject->tri[index_a];
-    tri_b = &clothObject->tri[index_b];
-
-    if (cloth_bvh_selfcollision_is_active(clmd, clothObject, tri_a, tri_b)) {
-      return true;
-    }
-  }
-  return false;
-}
-
 int cloth_bvh_collision(
     Depsgraph *depsgraph, Object *ob, ClothModifierData *clmd, float step, float dt)
 {
@@ -1586,7 +2046,7 @@ int cloth_bvh_collision(
   mvert_num = cloth->mvert_num;
 
   if (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_ENABLED) {
-    bvhtree_update_from_cloth(clmd, false, false);
+    bvhtree_update_from_cloth(clmd, false);
 
     /* Enable self collision if this is a hair sim */
     const bool is_hair = (clmd->hairdata != NULL);
@@ -1623,10 +2083,7 @@ int cloth_bvh_collision(
   }
 
   if (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_SELF) {
-    bvhtree_update_from_cloth(clmd, false, true);
-
-    overlap_self = BLI_bvhtree_overlap(
-        cloth->bvhselftree, cloth->bvhselftree, &coll_count_self, cloth_bvh_self_overlap_cb, clmd);
+    overlap_self = cloth_selfcollision_broadphase(clmd, &coll_count_self);
   }
 
   do {
@@ -1681,16 +2138,22 @@ int cloth_bvh_collision(
       verts = cloth->verts;
       mvert_num = cloth->mvert_num;
 
-      if (cloth->bvhselftree) {
-        if (coll_count_self && overlap_self) {
-          collisions = (CollPair *)MEM_mallocN(sizeof(CollPair) * coll_count_self,
-                                               "collision array");
-
-          if (cloth_bvh_selfcollisions_nearcheck(
-                  clmd, collisions, coll_count_self, overlap_self)) {
-            ret += cloth_bvh_selfcollisions_resolve(clmd, collisions, coll_count_self, dt);
-            ret2 += ret;
+      if (coll_count_self && overlap_self) {
+        collisions = (CollPair *)MEM_mallocN(sizeof(CollPair) * coll_count_self,
+                                             "collision array");
+
+        if (cloth_bvh_selfcollisions_nearcheck(clmd, collisions, coll_count_self, overlap_self)) {
+          if (clmd->solver_result) {
+            int contacts = 0;
+            for (i = 0; i < coll_count_self; i++) {
+              contacts += (collisions[i].flag & COLLISION_INACTIVE) == 0;
+            }
+            clmd->solver_result->selfcol_max_contacts = max_ii(
+                clmd->solver_result->selfcol_max_contacts, contacts);
           }
+
+          ret += cloth_bvh_selfcollisions_resolve(clmd, collisions, coll_count_self, dt);
+          ret2 += ret;
         }
       }
 
@@ -1723,8 +2186,6 @@ int cloth_bvh_collision(
 
   MEM_SAFE_FREE(coll_counts_obj);
 
-  MEM_SAFE_FREE(overlap_self);
-
   BKE_collision_objects_free(collobjs);
 
   return MIN2(ret, 1);
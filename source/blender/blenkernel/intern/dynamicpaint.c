@@ -3305,9 +3305,69 @@ static void dynamic_paint_output_surface_image_wetmap_cb(
   ibuf->rect_float[pos + 3] = 1.0f;
 }
 
+/* Limit of images buffered by the writer before the bake waits for them to be written,
+ * bounds memory use for high resolution surfaces. */
+#define DPAINT_IMAGE_WRITER_MAX_PENDING 4
+
+typedef struct DynamicPaintImageWriter {
+  TaskPool *pool;
+  /* Images queued since the last wait, only accessed from the baking thread. */
+  int num_pending;
+} DynamicPaintImageWriter;
+
+typedef struct DynamicPaintImageWriteTask {
+  ImBuf *ibuf;
+  char filepath[FILE_MAX];
+} DynamicPaintImageWriteTask;
+
+static void dynamic_paint_image_write_task(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  DynamicPaintImageWriteTask *task = taskdata;
+
+  IMB_saveiff(task->ibuf, task->filepath, IB_rectfloat);
+  IMB_freeImBuf(task->ibuf);
+}
+
+/* Image sequence output is encoded and written in the background, so compressing the images of
+ * one frame overlaps with simulating the next. */
+DynamicPaintImageWriter *dynamicPaint_imageWriter_new(void)
+{
+  DynamicPaintImageWriter *writer = MEM_callocN(sizeof(*writer), __func__);
+  writer->pool = BLI_task_pool_create_background(NULL, TASK_PRIORITY_LOW);
+  return writer;
+}
+
+/* Waits for all queued images to be written. */
+void dynamicPaint_imageWriter_free(DynamicPaintImageWriter *writer)
+{
+  BLI_task_pool_work_and_wait(writer->pool);
+  BLI_task_pool_free(writer->pool);
+  MEM_freeN(writer);
+}
+
+static void dynamic_paint_image_writer_push(DynamicPaintImageWriter *writer,
+                                            ImBuf *ibuf,
+                                            const char *filepath)
+{
+  if (writer->num_pending >= DPAINT_IMAGE_WRITER_MAX_PENDING) {
+    BLI_task_pool_work_and_wait(writer->pool);
+    writer->num_pending = 0;
+  }
+
+  DynamicPaintImageWriteTask *task = MEM_mallocN(sizeof(*task), __func__);
+  task->ibuf = ibuf;
+  BLI_strncpy(task->filepath, filepath, sizeof(task->filepath));
+
+  BLI_task_pool_push(writer->pool, dynamic_paint_image_write_task, task, true, NULL);
+  writer->num_pending++;
+}
+
+/* Writes the surface to an image, when a writer is given the image buffer is filled from the
+ * current surface data immediately and saved in the background. */
 void dynamicPaint_outputSurfaceImage(DynamicPaintSurface *surface,
                                      char *filename,
-                                     short output_layer)
+                                     short output_layer,
+                                     DynamicPaintImageWriter *writer)
 {
   ImBuf *ibuf = NULL;
   PaintSurfaceData *sData = surface->data;
@@ -3433,6 +3493,10 @@ void dynamicPaint_outputSurfaceImage(DynamicPaintSurface *surface,
   }
 
   /* Save image */
+  if (writer) {
+    dynamic_paint_image_writer_push(writer, ibuf, output_file);
+    return;
+  }
   IMB_saveiff(ibuf, output_file, IB_rectfloat);
   IMB_freeImBuf(ibuf);
 }
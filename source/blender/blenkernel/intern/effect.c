@@ -180,9 +180,6 @@ static void precalculate_effector(struct Depsgraph *depsgraph, EffectorCache *ef
       eff->flag |= PE_USE_NORMAL_DATA;
     }
   }
-  else if (eff->psys) {
-    psys_update_particle_tree(eff->psys, ctime);
-  }
 }
 
 static void add_effector_relation(ListBase *relations,
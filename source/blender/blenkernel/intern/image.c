@@ -5701,6 +5701,18 @@ bool BKE_image_has_loaded_ibuf(Image *image)
   return has_loaded_ibuf;
 }
 
+/* Usage statistics of the image buffer cache, all zero when nothing was cached yet. */
+void BKE_image_get_cache_stats(Image *image, MovieCacheStats *r_stats)
+{
+  memset(r_stats, 0, sizeof(*r_stats));
+
+  BLI_mutex_lock(image_mutex);
+  if (image->cache != NULL) {
+    IMB_moviecache_get_stats(image->cache, r_stats);
+  }
+  BLI_mutex_unlock(image_mutex);
+}
+
 /**
  * References the result, #BKE_image_release_ibuf is to be called to de-reference.
  * Use lock=NULL when calling #BKE_image_release_ibuf().
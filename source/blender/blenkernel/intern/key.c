@@ -31,6 +31,7 @@
 #include "BLI_endian_switch.h"
 #include "BLI_math_vector.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -1003,6 +1004,140 @@ static void key_evaluate_relative(const int start,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Relative Key Evaluation for Coordinates
+ *
+ * Specialization of #key_evaluate_relative for mesh and lattice keys, which store a single
+ * coordinate per element. Active key blocks are gathered once, after which the elements are
+ * processed in parallel chunks, applying every key block to a chunk before moving on to the next
+ * one. Per element, key blocks are applied in the same order as the generic code.
+ * \{ */
+
+#define KEY_RELATIVE_CHUNK_SIZE 1024
+
+typedef struct KeyRelativeBlock {
+  const float (*from)[3];
+  const float (*reffrom)[3];
+  /* Optional vertex group weights, indexed from the first evaluated element. */
+  const float *weights;
+  float influence;
+  char *freefrom;
+} KeyRelativeBlock;
+
+typedef struct KeyRelativeData {
+  float (*out)[3];
+  const KeyRelativeBlock *blocks;
+  int blocks_num;
+  int start, end;
+} KeyRelativeData;
+
+static void key_evaluate_relative_coords_chunk(void *__restrict userdata,
+                                               const int chunk,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KeyRelativeData *data = userdata;
+  float(*out)[3] = data->out;
+  const int start = data->start;
+  const int chunk_start = start + chunk * KEY_RELATIVE_CHUNK_SIZE;
+  const int chunk_end = min_ii(chunk_start + KEY_RELATIVE_CHUNK_SIZE, data->end);
+
+  for (int i = 0; i < data->blocks_num; i++) {
+    const KeyRelativeBlock *block = &data->blocks[i];
+    const float(*from)[3] = block->from;
+    const float(*reffrom)[3] = block->reffrom;
+    const float influence = block->influence;
+
+    if (block->weights) {
+      const float *weights = block->weights - start;
+      for (int b = chunk_start; b < chunk_end; b++) {
+        /* Vertex groups usually only cover part of the mesh, skip untouched elements. */
+        if (weights[b] != 0.0f) {
+          rel_flerp(KEYELEM_FLOAT_LEN_COORD, out[b], reffrom[b], from[b], weights[b] * influence);
+        }
+      }
+    }
+    else {
+      for (int b = chunk_start; b < chunk_end; b++) {
+        rel_flerp(KEYELEM_FLOAT_LEN_COORD, out[b], reffrom[b], from[b], influence);
+      }
+    }
+  }
+}
+
+static void key_evaluate_relative_coords(const int start,
+                                         int end,
+                                         const int tot,
+                                         char *basispoin,
+                                         Key *key,
+                                         KeyBlock *actkb,
+                                         float **per_keyblock_weights)
+{
+  KeyBlock *kb;
+  int keyblock_index;
+
+  BLI_assert(key->elemsize == sizeof(float[KEYELEM_FLOAT_LEN_COORD]));
+
+  if (end > tot) {
+    end = tot;
+  }
+
+  /* step 1 init */
+  cp_key(start, end, tot, basispoin, key, actkb, key->refkey, NULL, KEY_MODE_DUMMY);
+
+  /* step 2: gather the key blocks which have an effect */
+  KeyRelativeBlock *blocks = MEM_mallocN(sizeof(*blocks) * key->totkey, __func__);
+  int blocks_num = 0;
+
+  for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
+    if (kb == key->refkey) {
+      continue;
+    }
+    /* only with value, and no difference allowed */
+    if ((kb->flag & KEYBLOCK_MUTE) || kb->curval == 0.0f || kb->totelem != tot) {
+      continue;
+    }
+    /* reference now can be any block */
+    KeyBlock *refb = BLI_findlink(&key->block, kb->relative);
+    if (refb == NULL) {
+      continue;
+    }
+
+    KeyRelativeBlock *block = &blocks[blocks_num++];
+    block->from = (const float(*)[3])key_block_get_data(key, actkb, kb, &block->freefrom);
+    /* For meshes, use the original values instead of the bmesh values to
+     * maintain a constant offset. */
+    block->reffrom = (const float(*)[3])refb->data;
+    block->weights = per_keyblock_weights ? per_keyblock_weights[keyblock_index] : NULL;
+    block->influence = kb->curval;
+  }
+
+  /* step 3: do it */
+  if (blocks_num != 0 && end > start) {
+    KeyRelativeData data = {
+        .out = (float(*)[3])basispoin,
+        .blocks = blocks,
+        .blocks_num = blocks_num,
+        .start = start,
+        .end = end,
+    };
+    const int chunks_num = divide_ceil_u(end - start, KEY_RELATIVE_CHUNK_SIZE);
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (chunks_num > 1);
+    BLI_task_parallel_range(0, chunks_num, &data, key_evaluate_relative_coords_chunk, &settings);
+  }
+
+  for (int i = 0; i < blocks_num; i++) {
+    if (blocks[i].freefrom) {
+      MEM_freeN(blocks[i].freefrom);
+    }
+  }
+  MEM_freeN(blocks);
+}
+
+/** \} */
+
 static void do_key(const int start,
                    int end,
                    const int tot,
@@ -1357,6 +1492,11 @@ static float **keyblock_get_per_block_weights(Object *ob, Key *key, WeightsArray
 
   for (keyblock = key->block.first, keyblock_index = 0; keyblock;
        keyblock = keyblock->next, keyblock_index++) {
+    /* Muted and zero value key blocks are skipped by the evaluation, don't build weights. */
+    if ((keyblock->flag & KEYBLOCK_MUTE) || keyblock->curval == 0.0f) {
+      per_keyblock_weights[keyblock_index] = NULL;
+      continue;
+    }
     per_keyblock_weights[keyblock_index] = get_weights_array(ob, keyblock->vgroup, cache);
   }
 
@@ -1401,8 +1541,7 @@ static void do_mesh_key(Object *ob, Key *key, char *out, const int tot)
     WeightsArrayCache cache = {0, NULL};
     float **per_keyblock_weights;
     per_keyblock_weights = keyblock_get_per_block_weights(ob, key, &cache);
-    key_evaluate_relative(
-        0, tot, tot, (char *)out, key, actkb, per_keyblock_weights, KEY_MODE_DUMMY);
+    key_evaluate_relative_coords(0, tot, tot, (char *)out, key, actkb, per_keyblock_weights);
     keyblock_free_per_block_weights(key, per_keyblock_weights, &cache);
   }
   else {
@@ -1494,8 +1633,7 @@ static void do_latt_key(Object *ob, Key *key, char *out, const int tot)
   if (key->type == KEY_RELATIVE) {
     float **per_keyblock_weights;
     per_keyblock_weights = keyblock_get_per_block_weights(ob, key, NULL);
-    key_evaluate_relative(
-        0, tot, tot, (char *)out, key, actkb, per_keyblock_weights, KEY_MODE_DUMMY);
+    key_evaluate_relative_coords(0, tot, tot, (char *)out, key, actkb, per_keyblock_weights);
     keyblock_free_per_block_weights(key, per_keyblock_weights, NULL);
   }
   else {
@@ -43,6 +43,13 @@
 /** \name Mesh Runtime Struct Utils
  * \{ */
 
+/* Unique stamp for every new or copied mesh, zero is never used. */
+static uint64_t mesh_runtime_data_stamp_next(void)
+{
+  static uint64_t data_stamp = 0;
+  return atomic_add_and_fetch_uint64(&data_stamp, 1);
+}
+
 /**
  * Default values defined at read time.
  */
@@ -51,6 +58,7 @@ void BKE_mesh_runtime_reset(Mesh *mesh)
   memset(&mesh->runtime, 0, sizeof(mesh->runtime));
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
+  mesh->runtime.data_stamp = mesh_runtime_data_stamp_next();
 }
 
 /* Clear all pointers which we don't want to be shared on copying the datablock.
@@ -70,6 +78,8 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
 
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
+
+  runtime->data_stamp = mesh_runtime_data_stamp_next();
 }
 
 void BKE_mesh_runtime_clear_cache(Mesh *mesh)
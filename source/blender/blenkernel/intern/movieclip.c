@@ -1980,6 +1980,18 @@ bool BKE_movieclip_has_cached_frame(MovieClip *clip, MovieClipUser *user)
   return has_frame;
 }
 
+/* Usage statistics of the frame cache, all zero when nothing was cached yet. */
+void BKE_movieclip_get_cache_stats(MovieClip *clip, MovieCacheStats *r_stats)
+{
+  memset(r_stats, 0, sizeof(*r_stats));
+
+  BLI_thread_lock(LOCK_MOVIECLIP);
+  if (clip->cache != NULL && clip->cache->moviecache != NULL) {
+    IMB_moviecache_get_stats(clip->cache->moviecache, r_stats);
+  }
+  BLI_thread_unlock(LOCK_MOVIECLIP);
+}
+
 bool BKE_movieclip_put_frame_if_possible(MovieClip *clip, MovieClipUser *user, ImBuf *ibuf)
 {
   bool result;
@@ -279,6 +279,7 @@ static void object_free_data(ID *id)
   /* BKE_<id>_free shall never touch to ID->us. Never ever. */
   BKE_object_free_modifiers(ob, LIB_ID_CREATE_NO_USER_REFCOUNT);
   BKE_object_free_shaderfx(ob, LIB_ID_CREATE_NO_USER_REFCOUNT);
+  BKE_object_modifier_stack_cache_free(ob);
 
   MEM_SAFE_FREE(ob->mat);
   MEM_SAFE_FREE(ob->matbits);
@@ -1803,6 +1804,7 @@ void BKE_object_free_caches(Object *object)
    */
   if ((object->base_flag & BASE_FROM_DUPLI) == 0) {
     BKE_object_free_derived_caches(object);
+    BKE_object_modifier_stack_cache_free(object);
     update_flag |= ID_RECALC_GEOMETRY;
   }
 
@@ -2365,7 +2367,6 @@ ParticleSystem *BKE_object_copy_particlesystem(ParticleSystem *psys, const int f
   psysn->edit = NULL;
   psysn->pdd = NULL;
   psysn->effectors = NULL;
-  psysn->tree = NULL;
   psysn->bvhtree = NULL;
   psysn->batch_cache = NULL;
 
@@ -5114,6 +5115,7 @@ void BKE_object_runtime_reset_on_copy(Object *object, const int UNUSED(flag))
   runtime->object_as_temp_mesh = NULL;
   runtime->object_as_temp_curve = NULL;
   runtime->geometry_set_eval = NULL;
+  runtime->modifier_stack_cache = NULL;
 }
 
 /**
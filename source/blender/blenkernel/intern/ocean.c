@@ -378,12 +378,8 @@ void BKE_ocean_eval_xz_catrom(struct Ocean *oc, struct OceanResult *ocr, float x
   BKE_ocean_eval_uv_catrom(oc, ocr, x / oc->_Lx, z / oc->_Lz);
 }
 
-/* note that this doesn't wrap properly for i, j < 0, but its not really meant for that being
- * just a way to get the raw data out to save in some image format. */
-void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
+static void ocean_eval_ij_nolock(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
 {
-  BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
-
   i = abs(i) % oc->_M;
   j = abs(j) % oc->_N;
 
@@ -410,6 +406,15 @@ void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
     compute_eigenstuff(
         ocr, oc->_Jxx[i * oc->_N + j], oc->_Jzz[i * oc->_N + j], oc->_Jxz[i * oc->_N + j]);
   }
+}
+
+/* note that this doesn't wrap properly for i, j < 0, but its not really meant for that being
+ * just a way to get the raw data out to save in some image format. */
+void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
+{
+  BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
+
+  ocean_eval_ij_nolock(oc, ocr, i, j);
 
   BLI_rw_mutex_unlock(&oc->oceanmutex);
 }
@@ -421,11 +426,8 @@ typedef struct OceanSimulateData {
   float chop_amount;
 } OceanSimulateData;
 
-static void ocean_compute_htilda(void *__restrict userdata,
-                                 const int i,
-                                 const TaskParallelTLS *__restrict UNUSED(tls))
+static void ocean_compute_htilda(const OceanSimulateData *osd, const int i)
 {
-  OceanSimulateData *osd = userdata;
   const Ocean *o = osd->o;
   const float scale = osd->scale;
   const float t = osd->t;
@@ -453,201 +455,201 @@ static void ocean_compute_htilda(void *__restrict userdata,
   }
 }
 
-static void ocean_compute_displacement_y(TaskPool *__restrict pool, void *UNUSED(taskdata))
+static void ocean_fill_displacement_x(const OceanSimulateData *osd, const int i)
 {
-  OceanSimulateData *osd = BLI_task_pool_user_data(pool);
   const Ocean *o = osd->o;
+  const float scale = osd->scale;
+  const float chop_amount = osd->chop_amount;
+  int j;
+
+  for (j = 0; j <= o->_N / 2; j++) {
+    fftw_complex mul_param;
+    fftw_complex minus_i;
 
-  fftw_execute(o->_disp_y_plan);
+    init_complex(minus_i, 0.0, -1.0);
+    init_complex(mul_param, -scale, 0);
+    mul_complex_f(mul_param, mul_param, chop_amount);
+    mul_complex_c(mul_param, mul_param, minus_i);
+    mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
+    mul_complex_f(mul_param,
+                  mul_param,
+                  ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
+                       0.0f :
+                       o->_kx[i] / o->_k[i * (1 + o->_N / 2) + j]));
+    init_complex(o->_fft_in_x[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
+  }
 }
 
-static void ocean_compute_displacement_x(TaskPool *__restrict pool, void *UNUSED(taskdata))
+static void ocean_fill_displacement_z(const OceanSimulateData *osd, const int i)
 {
-  OceanSimulateData *osd = BLI_task_pool_user_data(pool);
   const Ocean *o = osd->o;
   const float scale = osd->scale;
   const float chop_amount = osd->chop_amount;
-  int i, j;
+  int j;
 
-  for (i = 0; i < o->_M; i++) {
-    for (j = 0; j <= o->_N / 2; j++) {
-      fftw_complex mul_param;
-      fftw_complex minus_i;
-
-      init_complex(minus_i, 0.0, -1.0);
-      init_complex(mul_param, -scale, 0);
-      mul_complex_f(mul_param, mul_param, chop_amount);
-      mul_complex_c(mul_param, mul_param, minus_i);
-      mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-      mul_complex_f(mul_param,
-                    mul_param,
-                    ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-                         0.0f :
-                         o->_kx[i] / o->_k[i * (1 + o->_N / 2) + j]));
-      init_complex(o->_fft_in_x[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-    }
+  for (j = 0; j <= o->_N / 2; j++) {
+    fftw_complex mul_param;
+    fftw_complex minus_i;
+
+    init_complex(minus_i, 0.0, -1.0);
+    init_complex(mul_param, -scale, 0);
+    mul_complex_f(mul_param, mul_param, chop_amount);
+    mul_complex_c(mul_param, mul_param, minus_i);
+    mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
+    mul_complex_f(mul_param,
+                  mul_param,
+                  ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
+                       0.0f :
+                       o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
+    init_complex(o->_fft_in_z[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
   }
-  fftw_execute(o->_disp_x_plan);
 }
 
-static void ocean_compute_displacement_z(TaskPool *__restrict pool, void *UNUSED(taskdata))
+static void ocean_fill_jacobian_jxx(const OceanSimulateData *osd, const int i)
 {
-  OceanSimulateData *osd = BLI_task_pool_user_data(pool);
   const Ocean *o = osd->o;
-  const float scale = osd->scale;
   const float chop_amount = osd->chop_amount;
-  int i, j;
+  int j;
 
-  for (i = 0; i < o->_M; i++) {
-    for (j = 0; j <= o->_N / 2; j++) {
-      fftw_complex mul_param;
-      fftw_complex minus_i;
-
-      init_complex(minus_i, 0.0, -1.0);
-      init_complex(mul_param, -scale, 0);
-      mul_complex_f(mul_param, mul_param, chop_amount);
-      mul_complex_c(mul_param, mul_param, minus_i);
-      mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-      mul_complex_f(mul_param,
-                    mul_param,
-                    ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-                         0.0f :
-                         o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
-      init_complex(o->_fft_in_z[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-    }
+  for (j = 0; j <= o->_N / 2; j++) {
+    fftw_complex mul_param;
+
+    /* init_complex(mul_param, -scale, 0); */
+    init_complex(mul_param, -1, 0);
+
+    mul_complex_f(mul_param, mul_param, chop_amount);
+    mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
+    mul_complex_f(mul_param,
+                  mul_param,
+                  ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
+                       0.0f :
+                       o->_kx[i] * o->_kx[i] / o->_k[i * (1 + o->_N / 2) + j]));
+    init_complex(o->_fft_in_jxx[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
   }
-  fftw_execute(o->_disp_z_plan);
 }
 
-static void ocean_compute_jacobian_jxx(TaskPool *__restrict pool, void *UNUSED(taskdata))
+static void ocean_fill_jacobian_jzz(const OceanSimulateData *osd, const int i)
 {
-  OceanSimulateData *osd = BLI_task_pool_user_data(pool);
   const Ocean *o = osd->o;
   const float chop_amount = osd->chop_amount;
-  int i, j;
+  int j;
 
-  for (i = 0; i < o->_M; i++) {
-    for (j = 0; j <= o->_N / 2; j++) {
-      fftw_complex mul_param;
-
-      /* init_complex(mul_param, -scale, 0); */
-      init_complex(mul_param, -1, 0);
-
-      mul_complex_f(mul_param, mul_param, chop_amount);
-      mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-      mul_complex_f(mul_param,
-                    mul_param,
-                    ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-                         0.0f :
-                         o->_kx[i] * o->_kx[i] / o->_k[i * (1 + o->_N / 2) + j]));
-      init_complex(o->_fft_in_jxx[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-    }
-  }
-  fftw_execute(o->_Jxx_plan);
+  for (j = 0; j <= o->_N / 2; j++) {
+    fftw_complex mul_param;
 
-  for (i = 0; i < o->_M; i++) {
-    for (j = 0; j < o->_N; j++) {
-      o->_Jxx[i * o->_N + j] += 1.0;
-    }
+    /* init_complex(mul_param, -scale, 0); */
+    init_complex(mul_param, -1, 0);
+
+    mul_complex_f(mul_param, mul_param, chop_amount);
+    mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
+    mul_complex_f(mul_param,
+                  mul_param,
+                  ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
+                       0.0f :
+                       o->_kz[j] * o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
+    init_complex(o->_fft_in_jzz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
   }
 }
 
-static void ocean_compute_jacobian_jzz(TaskPool *__restrict pool, void *UNUSED(taskdata))
+static void ocean_fill_jacobian_jxz(const OceanSimulateData *osd, const int i)
 {
-  OceanSimulateData *osd = BLI_task_pool_user_data(pool);
   const Ocean *o = osd->o;
   const float chop_amount = osd->chop_amount;
-  int i, j;
+  int j;
 
-  for (i = 0; i < o->_M; i++) {
-    for (j = 0; j <= o->_N / 2; j++) {
-      fftw_complex mul_param;
-
-      /* init_complex(mul_param, -scale, 0); */
-      init_complex(mul_param, -1, 0);
-
-      mul_complex_f(mul_param, mul_param, chop_amount);
-      mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-      mul_complex_f(mul_param,
-                    mul_param,
-                    ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-                         0.0f :
-                         o->_kz[j] * o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
-      init_complex(o->_fft_in_jzz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-    }
+  for (j = 0; j <= o->_N / 2; j++) {
+    fftw_complex mul_param;
+
+    /* init_complex(mul_param, -scale, 0); */
+    init_complex(mul_param, -1, 0);
+
+    mul_complex_f(mul_param, mul_param, chop_amount);
+    mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
+    mul_complex_f(mul_param,
+                  mul_param,
+                  ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
+                       0.0f :
+                       o->_kx[i] * o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
+    init_complex(o->_fft_in_jxz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
   }
-  fftw_execute(o->_Jzz_plan);
+}
 
-  for (i = 0; i < o->_M; i++) {
-    for (j = 0; j < o->_N; j++) {
-      o->_Jzz[i * o->_N + j] += 1.0;
-    }
+static void ocean_fill_normal_x(const OceanSimulateData *osd, const int i)
+{
+  const Ocean *o = osd->o;
+  int j;
+
+  for (j = 0; j <= o->_N / 2; j++) {
+    fftw_complex mul_param;
+
+    init_complex(mul_param, 0.0, -1.0);
+    mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
+    mul_complex_f(mul_param, mul_param, o->_kx[i]);
+    init_complex(o->_fft_in_nx[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
   }
 }
 
-static void ocean_compute_jacobian_jxz(TaskPool *__restrict pool, void *UNUSED(taskdata))
+static void ocean_fill_normal_z(const OceanSimulateData *osd, const int i)
 {
-  OceanSimulateData *osd = BLI_task_pool_user_data(pool);
   const Ocean *o = osd->o;
-  const float chop_amount = osd->chop_amount;
-  int i, j;
+  int j;
 
-  for (i = 0; i < o->_M; i++) {
-    for (j = 0; j <= o->_N / 2; j++) {
-      fftw_complex mul_param;
-
-      /* init_complex(mul_param, -scale, 0); */
-      init_complex(mul_param, -1, 0);
-
-      mul_complex_f(mul_param, mul_param, chop_amount);
-      mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-      mul_complex_f(mul_param,
-                    mul_param,
-                    ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-                         0.0f :
-                         o->_kx[i] * o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
-      init_complex(o->_fft_in_jxz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-    }
+  for (j = 0; j <= o->_N / 2; j++) {
+    fftw_complex mul_param;
+
+    init_complex(mul_param, 0.0, -1.0);
+    mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
+    mul_complex_f(mul_param, mul_param, o->_kz[i]);
+    init_complex(o->_fft_in_nz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
   }
-  fftw_execute(o->_Jxz_plan);
 }
 
-static void ocean_compute_normal_x(TaskPool *__restrict pool, void *UNUSED(taskdata))
+static void ocean_compute_spectra(void *__restrict userdata,
+                                  const int i,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  OceanSimulateData *osd = BLI_task_pool_user_data(pool);
+  const OceanSimulateData *osd = userdata;
   const Ocean *o = osd->o;
-  int i, j;
 
-  for (i = 0; i < o->_M; i++) {
-    for (j = 0; j <= o->_N / 2; j++) {
-      fftw_complex mul_param;
+  /* All spectra of a row only depend on the same row of htilda, filling them together
+   * reads htilda and the wave numbers while they are still in cache. */
+  ocean_compute_htilda(osd, i);
 
-      init_complex(mul_param, 0.0, -1.0);
-      mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-      mul_complex_f(mul_param, mul_param, o->_kx[i]);
-      init_complex(o->_fft_in_nx[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-    }
+  if (o->_do_chop) {
+    ocean_fill_displacement_x(osd, i);
+    ocean_fill_displacement_z(osd, i);
+  }
+
+  if (o->_do_jacobian) {
+    ocean_fill_jacobian_jxx(osd, i);
+    ocean_fill_jacobian_jzz(osd, i);
+    ocean_fill_jacobian_jxz(osd, i);
+  }
+
+  if (o->_do_normals) {
+    ocean_fill_normal_x(osd, i);
+    ocean_fill_normal_z(osd, i);
   }
-  fftw_execute(o->_N_x_plan);
 }
 
-static void ocean_compute_normal_z(TaskPool *__restrict pool, void *UNUSED(taskdata))
+static void ocean_execute_plan(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  fftw_execute(*(fftw_plan *)taskdata);
+}
+
+static void ocean_execute_plan_jacobian(TaskPool *__restrict pool, void *taskdata)
 {
   OceanSimulateData *osd = BLI_task_pool_user_data(pool);
   const Ocean *o = osd->o;
-  int i, j;
+  const fftw_plan *plan = taskdata;
+  double *jacobian = (plan == &o->_Jxx_plan) ? o->_Jxx : o->_Jzz;
+  int i;
 
-  for (i = 0; i < o->_M; i++) {
-    for (j = 0; j <= o->_N / 2; j++) {
-      fftw_complex mul_param;
+  fftw_execute(*plan);
 
-      init_complex(mul_param, 0.0, -1.0);
-      mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-      mul_complex_f(mul_param, mul_param, o->_kz[i]);
-      init_complex(o->_fft_in_nz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-    }
+  for (i = 0; i < o->_M * o->_N; i++) {
+    jacobian[i] += 1.0;
   }
-  fftw_execute(o->_N_z_plan);
 }
 
 void BKE_ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount)
@@ -667,37 +669,34 @@ void BKE_ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount
 
   BLI_rw_mutex_lock(&o->oceanmutex, THREAD_LOCK_WRITE);
 
-  /* Note about multi-threading here: we have to run a first set of computations (htilda one)
-   * before we can run all others, since they all depend on it.
-   * So we make a first parallelized forloop run for htilda,
-   * and then pack all other computations into a set of parallel tasks.
-   * This is not optimal in all cases,
-   * but remains reasonably simple and should be OK most of the time. */
+  /* Note about multi-threading here: all spectra are filled in a first parallel loop over the
+   * rows, together with htilda they depend on. The inverse FFTs of the channels are independent
+   * of each other then, and run as a set of parallel tasks. */
 
-  /* compute a new htilda */
+  /* compute a new htilda and the spectra of all channels */
   TaskParallelSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
   settings.use_threading = (o->_M > 16);
-  BLI_task_parallel_range(0, o->_M, &osd, ocean_compute_htilda, &settings);
+  BLI_task_parallel_range(0, o->_M, &osd, ocean_compute_spectra, &settings);
 
   if (o->_do_disp_y) {
-    BLI_task_pool_push(pool, ocean_compute_displacement_y, NULL, false, NULL);
+    BLI_task_pool_push(pool, ocean_execute_plan, &o->_disp_y_plan, false, NULL);
   }
 
   if (o->_do_chop) {
-    BLI_task_pool_push(pool, ocean_compute_displacement_x, NULL, false, NULL);
-    BLI_task_pool_push(pool, ocean_compute_displacement_z, NULL, false, NULL);
+    BLI_task_pool_push(pool, ocean_execute_plan, &o->_disp_x_plan, false, NULL);
+    BLI_task_pool_push(pool, ocean_execute_plan, &o->_disp_z_plan, false, NULL);
   }
 
   if (o->_do_jacobian) {
-    BLI_task_pool_push(pool, ocean_compute_jacobian_jxx, NULL, false, NULL);
-    BLI_task_pool_push(pool, ocean_compute_jacobian_jzz, NULL, false, NULL);
-    BLI_task_pool_push(pool, ocean_compute_jacobian_jxz, NULL, false, NULL);
+    BLI_task_pool_push(pool, ocean_execute_plan_jacobian, &o->_Jxx_plan, false, NULL);
+    BLI_task_pool_push(pool, ocean_execute_plan_jacobian, &o->_Jzz_plan, false, NULL);
+    BLI_task_pool_push(pool, ocean_execute_plan, &o->_Jxz_plan, false, NULL);
   }
 
   if (o->_do_normals) {
-    BLI_task_pool_push(pool, ocean_compute_normal_x, NULL, false, NULL);
-    BLI_task_pool_push(pool, ocean_compute_normal_z, NULL, false, NULL);
+    BLI_task_pool_push(pool, ocean_execute_plan, &o->_N_x_plan, false, NULL);
+    BLI_task_pool_push(pool, ocean_execute_plan, &o->_N_z_plan, false, NULL);
     o->_N_y = 1.0f / scale;
   }
 
@@ -708,6 +707,18 @@ void BKE_ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount
   BLI_task_pool_free(pool);
 }
 
+/* Measured plans are a lot faster to execute than estimated ones. Measuring is only slow the
+ * first time for a grid size, FFTW keeps the result as wisdom for the process, so planning the
+ * other channels and re-initializing at the same resolution reuses it. The time limit (in
+ * seconds) keeps the first initialization at a new resolution responsive. */
+#define OCEAN_FFT_PLAN_TIME_LIMIT 2.0
+
+/* Call with #LOCK_FFTW held. Measuring overwrites the contents of `in` and `out`. */
+static fftw_plan ocean_fft_plan(const Ocean *o, fftw_complex *in, double *out)
+{
+  return fftw_plan_dft_c2r_2d(o->_M, o->_N, in, out, FFTW_MEASURE);
+}
+
 static void set_height_normalize_factor(struct Ocean *oc)
 {
   float res = 1.0;
@@ -969,10 +980,11 @@ void BKE_ocean_init(struct Ocean *o,
                                            "ocean_htilda");
 
   BLI_thread_lock(LOCK_FFTW);
+  fftw_set_timelimit(OCEAN_FFT_PLAN_TIME_LIMIT);
 
   if (o->_do_disp_y) {
     o->_disp_y = (double *)MEM_mallocN(o->_M * o->_N * sizeof(double), "ocean_disp_y");
-    o->_disp_y_plan = fftw_plan_dft_c2r_2d(o->_M, o->_N, o->_fft_in, o->_disp_y, FFTW_ESTIMATE);
+    o->_disp_y_plan = ocean_fft_plan(o, o->_fft_in, o->_disp_y);
   }
 
   if (o->_do_normals) {
@@ -985,8 +997,8 @@ void BKE_ocean_init(struct Ocean *o,
     /* o->_N_y = (float *) fftwf_malloc(o->_M * o->_N * sizeof(float)); (MEM01) */
     o->_N_z = (double *)MEM_mallocN(o->_M * o->_N * sizeof(double), "ocean_N_z");
 
-    o->_N_x_plan = fftw_plan_dft_c2r_2d(o->_M, o->_N, o->_fft_in_nx, o->_N_x, FFTW_ESTIMATE);
-    o->_N_z_plan = fftw_plan_dft_c2r_2d(o->_M, o->_N, o->_fft_in_nz, o->_N_z, FFTW_ESTIMATE);
+    o->_N_x_plan = ocean_fft_plan(o, o->_fft_in_nx, o->_N_x);
+    o->_N_z_plan = ocean_fft_plan(o, o->_fft_in_nz, o->_N_z);
   }
 
   if (o->_do_chop) {
@@ -998,8 +1010,8 @@ void BKE_ocean_init(struct Ocean *o,
     o->_disp_x = (double *)MEM_mallocN(o->_M * o->_N * sizeof(double), "ocean_disp_x");
     o->_disp_z = (double *)MEM_mallocN(o->_M * o->_N * sizeof(double), "ocean_disp_z");
 
-    o->_disp_x_plan = fftw_plan_dft_c2r_2d(o->_M, o->_N, o->_fft_in_x, o->_disp_x, FFTW_ESTIMATE);
-    o->_disp_z_plan = fftw_plan_dft_c2r_2d(o->_M, o->_N, o->_fft_in_z, o->_disp_z, FFTW_ESTIMATE);
+    o->_disp_x_plan = ocean_fft_plan(o, o->_fft_in_x, o->_disp_x);
+    o->_disp_z_plan = ocean_fft_plan(o, o->_fft_in_z, o->_disp_z);
   }
   if (o->_do_jacobian) {
     o->_fft_in_jxx = (fftw_complex *)MEM_mallocN(o->_M * (1 + o->_N / 2) * sizeof(fftw_complex),
@@ -1013,11 +1025,12 @@ void BKE_ocean_init(struct Ocean *o,
     o->_Jzz = (double *)MEM_mallocN(o->_M * o->_N * sizeof(double), "ocean_Jzz");
     o->_Jxz = (double *)MEM_mallocN(o->_M * o->_N * sizeof(double), "ocean_Jxz");
 
-    o->_Jxx_plan = fftw_plan_dft_c2r_2d(o->_M, o->_N, o->_fft_in_jxx, o->_Jxx, FFTW_ESTIMATE);
-    o->_Jzz_plan = fftw_plan_dft_c2r_2d(o->_M, o->_N, o->_fft_in_jzz, o->_Jzz, FFTW_ESTIMATE);
-    o->_Jxz_plan = fftw_plan_dft_c2r_2d(o->_M, o->_N, o->_fft_in_jxz, o->_Jxz, FFTW_ESTIMATE);
+    o->_Jxx_plan = ocean_fft_plan(o, o->_fft_in_jxx, o->_Jxx);
+    o->_Jzz_plan = ocean_fft_plan(o, o->_fft_in_jzz, o->_Jzz);
+    o->_Jxz_plan = ocean_fft_plan(o, o->_fft_in_jxz, o->_Jxz);
   }
 
+  fftw_set_timelimit(FFTW_NO_TIMELIMIT);
   BLI_thread_unlock(LOCK_FFTW);
 
   BLI_rw_mutex_unlock(&o->oceanmutex);
@@ -1372,19 +1385,106 @@ void BKE_ocean_simulate_cache(struct OceanCache *och, int frame)
   och->ibufs_norm[f] = IMB_loadiffname(string, 0, NULL);
 }
 
-void BKE_ocean_bake(struct Ocean *o,
-                    struct OceanCache *och,
-                    void (*update_cb)(void *, float progress, int *cancel),
-                    void *update_cb_data)
+typedef struct OceanBakeData {
+  Ocean *o;
+  OceanCache *och;
+  /* Index of the baked frame, from the start of the cache. */
+  int frame_index;
+  float *prev_foam;
+  ImBuf *ibuf_foam, *ibuf_disp, *ibuf_normal, *ibuf_spray, *ibuf_spray_inverse;
+} OceanBakeData;
+
+static void ocean_bake_row(void *__restrict userdata,
+                           const int y,
+                           const TaskParallelTLS *__restrict UNUSED(tls))
 {
   /* note: some of these values remain uninitialized unless certain options
-   * are enabled, take care that BKE_ocean_eval_ij() initializes a member
+   * are enabled, take care that ocean_eval_ij_nolock() initializes a member
    * before use - campbell */
   OceanResult ocr;
 
+  const OceanBakeData *data = userdata;
+  Ocean *o = data->o;
+  const OceanCache *och = data->och;
+  float *prev_foam = data->prev_foam;
+  ImBuf *ibuf_foam = data->ibuf_foam, *ibuf_disp = data->ibuf_disp;
+  ImBuf *ibuf_normal = data->ibuf_normal, *ibuf_spray = data->ibuf_spray;
+  ImBuf *ibuf_spray_inverse = data->ibuf_spray_inverse;
+  const int res_x = och->resolution_x;
+  int x;
+
+  /* Every pixel, including its accumulated foam, only depends on its own cell. */
+  for (x = 0; x < res_x; x++) {
+    ocean_eval_ij_nolock(o, &ocr, x, y);
+
+    /* add to the image */
+    rgb_to_rgba_unit_alpha(&ibuf_disp->rect_float[4 * (res_x * y + x)], ocr.disp);
+
+    if (o->_do_jacobian) {
+      /* TODO, cleanup unused code - campbell */
+
+      float /*r, */ /* UNUSED */ pr = 0.0f, foam_result;
+      float neg_disp, neg_eplus;
+
+      ocr.foam = BKE_ocean_jminus_to_foam(ocr.Jminus, och->foam_coverage);
+
+      /* accumulate previous value for this cell */
+      if (data->frame_index > 0) {
+        pr = prev_foam[res_x * y + x];
+      }
+
+      /* r = BLI_rng_get_float(rng); */ /* UNUSED */ /* randomly reduce foam */
+
+      /* pr = pr * och->foam_fade; */ /* overall fade */
+
+      /* Remember ocean coord sys is Y up!
+       * break up the foam where height (Y) is low (wave valley),
+       * and X and Z displacement is greatest. */
+
+      neg_disp = ocr.disp[1] < 0.0f ? 1.0f + ocr.disp[1] : 1.0f;
+      neg_disp = neg_disp < 0.0f ? 0.0f : neg_disp;
+
+      /* foam, 'ocr.Eplus' only initialized with do_jacobian */
+      neg_eplus = ocr.Eplus[2] < 0.0f ? 1.0f + ocr.Eplus[2] : 1.0f;
+      neg_eplus = neg_eplus < 0.0f ? 0.0f : neg_eplus;
+
+      if (pr < 1.0f) {
+        pr *= pr;
+      }
+
+      pr *= och->foam_fade * (0.75f + neg_eplus * 0.25f);
+
+      /* A full clamping should not be needed! */
+      foam_result = min_ff(pr + ocr.foam, 1.0f);
+
+      prev_foam[res_x * y + x] = foam_result;
+
+      /*foam_result = min_ff(foam_result, 1.0f); */
+
+      value_to_rgba_unit_alpha(&ibuf_foam->rect_float[4 * (res_x * y + x)], foam_result);
+
+      /* spray map baking */
+      if (o->_do_spray) {
+        rgb_to_rgba_unit_alpha(&ibuf_spray->rect_float[4 * (res_x * y + x)], ocr.Eplus);
+        rgb_to_rgba_unit_alpha(&ibuf_spray_inverse->rect_float[4 * (res_x * y + x)],
+                               ocr.Eminus);
+      }
+    }
+
+    if (o->_do_normals) {
+      rgb_to_rgba_unit_alpha(&ibuf_normal->rect_float[4 * (res_x * y + x)], ocr.normal);
+    }
+  }
+}
+
+void BKE_ocean_bake(struct Ocean *o,
+                    struct OceanCache *och,
+                    void (*update_cb)(void *, float progress, int *cancel),
+                    void *update_cb_data)
+{
   ImageFormatData imf = {0};
 
-  int f, i = 0, x, y, cancel = 0;
+  int f, i = 0, cancel = 0;
   float progress;
 
   ImBuf *ibuf_foam, *ibuf_disp, *ibuf_normal, *ibuf_spray, *ibuf_spray_inverse;
@@ -1424,69 +1524,28 @@ void BKE_ocean_bake(struct Ocean *o,
     BKE_ocean_simulate(o, och->time[i], och->wave_scale, och->chop_amount);
 
     /* add new foam */
-    for (y = 0; y < res_y; y++) {
-      for (x = 0; x < res_x; x++) {
-
-        BKE_ocean_eval_ij(o, &ocr, x, y);
-
-        /* add to the image */
-        rgb_to_rgba_unit_alpha(&ibuf_disp->rect_float[4 * (res_x * y + x)], ocr.disp);
-
-        if (o->_do_jacobian) {
-          /* TODO, cleanup unused code - campbell */
-
-          float /*r, */ /* UNUSED */ pr = 0.0f, foam_result;
-          float neg_disp, neg_eplus;
-
-          ocr.foam = BKE_ocean_jminus_to_foam(ocr.Jminus, och->foam_coverage);
-
-          /* accumulate previous value for this cell */
-          if (i > 0) {
-            pr = prev_foam[res_x * y + x];
-          }
-
-          /* r = BLI_rng_get_float(rng); */ /* UNUSED */ /* randomly reduce foam */
-
-          /* pr = pr * och->foam_fade; */ /* overall fade */
-
-          /* Remember ocean coord sys is Y up!
-           * break up the foam where height (Y) is low (wave valley),
-           * and X and Z displacement is greatest. */
-
-          neg_disp = ocr.disp[1] < 0.0f ? 1.0f + ocr.disp[1] : 1.0f;
-          neg_disp = neg_disp < 0.0f ? 0.0f : neg_disp;
-
-          /* foam, 'ocr.Eplus' only initialized with do_jacobian */
-          neg_eplus = ocr.Eplus[2] < 0.0f ? 1.0f + ocr.Eplus[2] : 1.0f;
-          neg_eplus = neg_eplus < 0.0f ? 0.0f : neg_eplus;
-
-          if (pr < 1.0f) {
-            pr *= pr;
-          }
-
-          pr *= och->foam_fade * (0.75f + neg_eplus * 0.25f);
-
-          /* A full clamping should not be needed! */
-          foam_result = min_ff(pr + ocr.foam, 1.0f);
-
-          prev_foam[res_x * y + x] = foam_result;
-
-          /*foam_result = min_ff(foam_result, 1.0f); */
-
-          value_to_rgba_unit_alpha(&ibuf_foam->rect_float[4 * (res_x * y + x)], foam_result);
-
-          /* spray map baking */
-          if (o->_do_spray) {
-            rgb_to_rgba_unit_alpha(&ibuf_spray->rect_float[4 * (res_x * y + x)], ocr.Eplus);
-            rgb_to_rgba_unit_alpha(&ibuf_spray_inverse->rect_float[4 * (res_x * y + x)],
-                                   ocr.Eminus);
-          }
-        }
-
-        if (o->_do_normals) {
-          rgb_to_rgba_unit_alpha(&ibuf_normal->rect_float[4 * (res_x * y + x)], ocr.normal);
-        }
-      }
+    {
+      OceanBakeData data = {
+          .o = o,
+          .och = och,
+          .frame_index = i,
+          .prev_foam = prev_foam,
+          .ibuf_foam = ibuf_foam,
+          .ibuf_disp = ibuf_disp,
+          .ibuf_normal = ibuf_normal,
+          .ibuf_spray = ibuf_spray,
+          .ibuf_spray_inverse = ibuf_spray_inverse,
+      };
+
+      /* The ocean is only read here, lock once instead of for every pixel. */
+      BLI_rw_mutex_lock(&o->oceanmutex, THREAD_LOCK_READ);
+
+      TaskParallelSettings settings;
+      BLI_parallel_range_settings_defaults(&settings);
+      settings.use_threading = (res_y > 16);
+      BLI_task_parallel_range(0, res_y, &data, ocean_bake_row, &settings);
+
+      BLI_rw_mutex_unlock(&o->oceanmutex);
     }
 
     /* write the images */
@@ -1127,7 +1127,6 @@ void psys_free(Object *ob, ParticleSystem *psys)
     BLI_freelistN(&psys->targets);
 
     BLI_bvhtree_free(psys->bvhtree);
-    BLI_kdtree_3d_free(psys->tree);
 
     if (psys->fluid_springs) {
       MEM_freeN(psys->fluid_springs);
@@ -5372,7 +5371,6 @@ void BKE_particle_system_blend_read_data(BlendDataReader *reader, ListBase *part
       psys->clmd->point_cache = psys->pointcache;
     }
 
-    psys->tree = NULL;
     psys->bvhtree = NULL;
 
     psys->orig_psys = NULL;
@@ -47,7 +47,6 @@
 #include "DNA_texture_types.h"
 
 #include "BLI_blenlib.h"
-#include "BLI_edgehash.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_kdtree.h"
 #include "BLI_linklist.h"
@@ -92,8 +91,6 @@
 #  include "manta_fluid_API.h"
 #endif  // WITH_FLUID
 
-static ThreadRWMutex psys_bvhtree_rwlock = BLI_RWLOCK_INITIALIZER;
-
 /************************************************/
 /*          Reacting to system events           */
 /************************************************/
@@ -1323,80 +1320,6 @@ void psys_get_pointcache_start_end(Scene *scene, ParticleSystem *psys, int *sfra
 /************************************************/
 /*          Effectors                           */
 /************************************************/
-static void psys_update_particle_bvhtree(ParticleSystem *psys, float cfra)
-{
-  if (psys) {
-    PARTICLE_P;
-    int totpart = 0;
-    bool need_rebuild;
-
-    BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_READ);
-    need_rebuild = !psys->bvhtree || psys->bvhtree_frame != cfra;
-    BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
-
-    if (need_rebuild) {
-      LOOP_SHOWN_PARTICLES
-      {
-        totpart++;
-      }
-
-      BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_WRITE);
-
-      BLI_bvhtree_free(psys->bvhtree);
-      psys->bvhtree = BLI_bvhtree_new(totpart, 0.0, 4, 6);
-
-      LOOP_SHOWN_PARTICLES
-      {
-        if (pa->alive == PARS_ALIVE) {
-          if (pa->state.time == cfra) {
-            BLI_bvhtree_insert(psys->bvhtree, p, pa->prev_state.co, 1);
-          }
-          else {
-            BLI_bvhtree_insert(psys->bvhtree, p, pa->state.co, 1);
-          }
-        }
-      }
-      BLI_bvhtree_balance(psys->bvhtree);
-
-      psys->bvhtree_frame = cfra;
-
-      BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
-    }
-  }
-}
-void psys_update_particle_tree(ParticleSystem *psys, float cfra)
-{
-  if (psys) {
-    PARTICLE_P;
-    int totpart = 0;
-
-    if (!psys->tree || psys->tree_frame != cfra) {
-      LOOP_SHOWN_PARTICLES
-      {
-        totpart++;
-      }
-
-      BLI_kdtree_3d_free(psys->tree);
-      psys->tree = BLI_kdtree_3d_new(psys->totpart);
-
-      LOOP_SHOWN_PARTICLES
-      {
-        if (pa->alive == PARS_ALIVE) {
-          if (pa->state.time == cfra) {
-            BLI_kdtree_3d_insert(psys->tree, p, pa->prev_state.co);
-          }
-          else {
-            BLI_kdtree_3d_insert(psys->tree, p, pa->state.co);
-          }
-        }
-      }
-      BLI_kdtree_3d_balance(psys->tree);
-
-      psys->tree_frame = cfra;
-    }
-  }
-}
-
 static void psys_update_effectors(ParticleSimulationData *sim)
 {
   BKE_effectors_free(sim->psys->effectors);
@@ -1656,20 +1579,396 @@ static void sph_springs_modify(ParticleSystem *psys, float dtime)
     }
   }
 }
-static EdgeHash *sph_springhash_build(ParticleSystem *psys)
+/* Fluid springs of a particle system stored by their lower particle index, so all springs
+ * of a particle pair are found by scanning a short contiguous row. */
+typedef struct SPHSpringIndex {
+  int totpart;
+  /* Offsets into `other` and `spring` for each particle, `totpart + 1` entries. */
+  int *row_start;
+  /* Higher particle index of the pair. */
+  int *other;
+  /* Index into `psys->fluid_springs`. */
+  int *spring;
+} SPHSpringIndex;
+
+static SPHSpringIndex *sph_spring_index_build(ParticleSystem *psys)
 {
-  EdgeHash *springhash = NULL;
+  SPHSpringIndex *springs;
   ParticleSpring *spring;
-  int i = 0;
+  const int totpart = psys->totpart;
+  int *fill;
+  int i;
+
+  if (psys->tot_fluidsprings == 0 || totpart == 0) {
+    return NULL;
+  }
 
-  springhash = BLI_edgehash_new_ex(__func__, psys->tot_fluidsprings);
+  springs = MEM_callocN(sizeof(*springs), __func__);
+  springs->totpart = totpart;
+  springs->row_start = MEM_calloc_arrayN(totpart + 1, sizeof(int), __func__);
+  springs->other = MEM_malloc_arrayN(psys->tot_fluidsprings, sizeof(int), __func__);
+  springs->spring = MEM_malloc_arrayN(psys->tot_fluidsprings, sizeof(int), __func__);
 
+  /* Counting sort of the springs by their lower particle index. */
   for (i = 0, spring = psys->fluid_springs; i < psys->tot_fluidsprings; i++, spring++) {
-    BLI_edgehash_insert(
-        springhash, spring->particle_index[0], spring->particle_index[1], POINTER_FROM_INT(i + 1));
+    const int lo = min_ii(spring->particle_index[0], spring->particle_index[1]);
+    const int hi = max_ii(spring->particle_index[0], spring->particle_index[1]);
+    if (lo >= 0 && hi < totpart) {
+      springs->row_start[lo + 1]++;
+    }
+  }
+  for (i = 0; i < totpart; i++) {
+    springs->row_start[i + 1] += springs->row_start[i];
+  }
+
+  fill = MEM_malloc_arrayN(totpart, sizeof(int), __func__);
+  memcpy(fill, springs->row_start, sizeof(int) * totpart);
+
+  for (i = 0, spring = psys->fluid_springs; i < psys->tot_fluidsprings; i++, spring++) {
+    const int lo = min_ii(spring->particle_index[0], spring->particle_index[1]);
+    const int hi = max_ii(spring->particle_index[0], spring->particle_index[1]);
+    if (lo >= 0 && hi < totpart) {
+      const int j = fill[lo]++;
+      springs->other[j] = hi;
+      springs->spring[j] = i;
+    }
+  }
+
+  MEM_freeN(fill);
+
+  return springs;
+}
+
+static void sph_spring_index_free(SPHSpringIndex *springs)
+{
+  MEM_freeN(springs->row_start);
+  MEM_freeN(springs->other);
+  MEM_freeN(springs->spring);
+  MEM_freeN(springs);
+}
+
+/* Returns the index of the spring between two particles, or -1 when there is none. */
+static int sph_spring_index_lookup(const SPHSpringIndex *springs, int index_a, int index_b)
+{
+  const int lo = min_ii(index_a, index_b);
+  const int hi = max_ii(index_a, index_b);
+  int j;
+
+  if (lo < 0 || hi >= springs->totpart) {
+    return -1;
   }
 
-  return springhash;
+  for (j = springs->row_start[lo]; j < springs->row_start[lo + 1]; j++) {
+    if (springs->other[j] == hi) {
+      return springs->spring[j];
+    }
+  }
+
+  return -1;
+}
+
+/* Limit the grid resolution for sparse systems, the cells grow instead. */
+#define PSYS_GRID_MAX_CELLS_PER_POINT 4
+
+/* Uniform grid over the particles alive at the start of a step. Points are sorted by cell
+ * (x varying fastest), so a row of neighboring cells is one contiguous range of `co`. */
+typedef struct ParticleGrid {
+  float min[3];
+  float inv_cell_size;
+  int res[3];
+
+  int totpoint;
+  /* Offsets into the sorted arrays for each cell, `res[0] * res[1] * res[2] + 1` entries. */
+  int *cell_start;
+  /* Particle index and position of the sorted points. */
+  int *index;
+  float (*co)[3];
+
+  /* All particles of the system, grid points first in cell order. Used as iteration order
+   * of the solver passes so neighboring tasks touch neighboring memory. */
+  int *order;
+} ParticleGrid;
+
+ParticleGrid *psys_grid_build(ParticleSystem *psys, float cfra, float cell_size)
+{
+  ParticleGrid *grid;
+  PARTICLE_P;
+  float max[3], extent[3];
+  int64_t totcell;
+  int *cell_of_point, *fill;
+  int i, totpoint = 0, totorder = 0;
+
+  LOOP_SHOWN_PARTICLES
+  {
+    if (pa->alive == PARS_ALIVE) {
+      totpoint++;
+    }
+  }
+
+  grid = MEM_callocN(sizeof(*grid), __func__);
+  grid->totpoint = totpoint;
+  grid->index = MEM_malloc_arrayN(max_ii(totpoint, 1), sizeof(int), __func__);
+  grid->co = MEM_malloc_arrayN(max_ii(totpoint, 1), sizeof(float[3]), __func__);
+  grid->order = MEM_malloc_arrayN(max_ii(psys->totpart, 1), sizeof(int), __func__);
+  cell_of_point = MEM_malloc_arrayN(max_ii(totpoint, 1), sizeof(int), __func__);
+
+  /* Gather positions with the same rule the BVH tree used, and the bounds. */
+  INIT_MINMAX(grid->min, max);
+  i = 0;
+  LOOP_SHOWN_PARTICLES
+  {
+    if (pa->alive == PARS_ALIVE) {
+      const float *co = (pa->state.time == cfra) ? pa->prev_state.co : pa->state.co;
+      /* Stored unsorted in `co` for now, `index` keeps the particle. */
+      copy_v3_v3(grid->co[i], co);
+      grid->index[i] = p;
+      minmax_v3v3_v3(grid->min, max, co);
+      i++;
+    }
+  }
+
+  if (totpoint == 0) {
+    zero_v3(grid->min);
+    zero_v3(max);
+  }
+
+  sub_v3_v3v3(extent, max, grid->min);
+  for (int axis = 0; axis < 3; axis++) {
+    /* Degenerate positions must not keep the resolution search below from terminating. */
+    if (!(extent[axis] >= 0.0f && extent[axis] <= FLT_MAX)) {
+      extent[axis] = 0.0f;
+    }
+  }
+  cell_size = max_ff(cell_size, FLT_EPSILON);
+  for (;;) {
+    totcell = 1;
+    for (int axis = 0; axis < 3; axis++) {
+      /* The cap keeps the cell count product from overflowing. */
+      grid->res[axis] = (int)min_ff(extent[axis] / cell_size, (float)(1 << 20)) + 1;
+      totcell *= grid->res[axis];
+    }
+    if (totcell <= max_ii(totpoint, 1) * (int64_t)PSYS_GRID_MAX_CELLS_PER_POINT) {
+      break;
+    }
+    cell_size *= 2.0f;
+  }
+  grid->inv_cell_size = 1.0f / cell_size;
+
+  /* Counting sort of the points by cell. */
+  grid->cell_start = MEM_calloc_arrayN((size_t)totcell + 1, sizeof(int), __func__);
+  for (i = 0; i < totpoint; i++) {
+    int cell[3];
+    for (int axis = 0; axis < 3; axis++) {
+      cell[axis] = (int)((grid->co[i][axis] - grid->min[axis]) * grid->inv_cell_size);
+      CLAMP(cell[axis], 0, grid->res[axis] - 1);
+    }
+    cell_of_point[i] = (cell[2] * grid->res[1] + cell[1]) * grid->res[0] + cell[0];
+    grid->cell_start[cell_of_point[i] + 1]++;
+  }
+  for (i = 0; i < totcell; i++) {
+    grid->cell_start[i + 1] += grid->cell_start[i];
+  }
+
+  fill = MEM_malloc_arrayN((size_t)totcell, sizeof(int), __func__);
+  memcpy(fill, grid->cell_start, sizeof(int) * (size_t)totcell);
+  for (i = 0; i < totpoint; i++) {
+    grid->order[fill[cell_of_point[i]]++] = i;
+  }
+  MEM_freeN(fill);
+  MEM_freeN(cell_of_point);
+
+  {
+    /* Apply the permutation, `order` holds the unsorted point for each sorted slot. */
+    int *index_sorted = MEM_malloc_arrayN(max_ii(totpoint, 1), sizeof(int), __func__);
+    float(*co_sorted)[3] = MEM_malloc_arrayN(max_ii(totpoint, 1), sizeof(float[3]), __func__);
+    for (i = 0; i < totpoint; i++) {
+      index_sorted[i] = grid->index[grid->order[i]];
+      copy_v3_v3(co_sorted[i], grid->co[grid->order[i]]);
+    }
+    MEM_freeN(grid->index);
+    MEM_freeN(grid->co);
+    grid->index = index_sorted;
+    grid->co = co_sorted;
+  }
+
+  /* Grid points first, then the remaining particles in their own order. */
+  memcpy(grid->order, grid->index, sizeof(int) * totpoint);
+  totorder = totpoint;
+  LOOP_PARTICLES
+  {
+    if ((pa->flag & (PARS_UNEXIST | PARS_NO_DISP)) || pa->alive != PARS_ALIVE) {
+      grid->order[totorder++] = p;
+    }
+  }
+  BLI_assert(totorder == psys->totpart);
+
+  return grid;
+}
+
+void psys_grid_free(ParticleGrid *grid)
+{
+  MEM_freeN(grid->cell_start);
+  MEM_freeN(grid->index);
+  MEM_freeN(grid->co);
+  MEM_freeN(grid->order);
+  MEM_freeN(grid);
+}
+
+/* Same contract as #BLI_bvhtree_range_query: `callback` gets every point strictly within
+ * `radius` of `co`. */
+void psys_grid_range_query(const ParticleGrid *grid,
+                           const float co[3],
+                           float radius,
+                           ParticleGridRangeQueryFn callback,
+                           void *userdata)
+{
+  const float radius_sq = radius * radius;
+  int lo[3], hi[3];
+
+  for (int axis = 0; axis < 3; axis++) {
+    const float fmin = (co[axis] - radius - grid->min[axis]) * grid->inv_cell_size;
+    const float fmax = (co[axis] + radius - grid->min[axis]) * grid->inv_cell_size;
+    /* Also rejects NaN coordinates. */
+    if (!(fmax >= 0.0f && fmin < (float)grid->res[axis])) {
+      return;
+    }
+    lo[axis] = (fmin > 0.0f) ? (int)fmin : 0;
+    hi[axis] = (fmax < (float)(grid->res[axis] - 1)) ? (int)fmax : grid->res[axis] - 1;
+  }
+
+  for (int z = lo[2]; z <= hi[2]; z++) {
+    for (int y = lo[1]; y <= hi[1]; y++) {
+      const int row = (z * grid->res[1] + y) * grid->res[0];
+      const int end = grid->cell_start[row + hi[0] + 1];
+      for (int i = grid->cell_start[row + lo[0]]; i < end; i++) {
+        const float dist_sq = len_squared_v3v3(grid->co[i], co);
+        if (dist_sq < radius_sq) {
+          callback(userdata, grid->index[i], co, dist_sq);
+        }
+      }
+    }
+  }
+}
+
+/* Insert into the `r_nearest` array sorted by (squared) distance, the furthest point drops out
+ * once the array is full. */
+static void psys_grid_nearest_insert(KDTreeNearest_3d *r_nearest,
+                                     int *r_found,
+                                     int nearest_len_capacity,
+                                     int index,
+                                     float dist_sq,
+                                     const float co[3])
+{
+  int i;
+
+  if (*r_found < nearest_len_capacity) {
+    (*r_found)++;
+  }
+  else if (dist_sq >= r_nearest[*r_found - 1].dist) {
+    return;
+  }
+
+  for (i = *r_found - 1; i > 0 && r_nearest[i - 1].dist > dist_sq; i--) {
+    r_nearest[i] = r_nearest[i - 1];
+  }
+  r_nearest[i].index = index;
+  r_nearest[i].dist = dist_sq;
+  copy_v3_v3(r_nearest[i].co, co);
+}
+
+/* Same contract as #BLI_kdtree_3d_find_nearest_n_with_len_squared_cb, limited to points within
+ * `range` and skipping the particle `index_exclude` (-1 for none). `len_sq_fn` must not return
+ * less than the squared euclidean distance, the search visits rings of cells around `co` and
+ * stops at the first ring which can't contain a closer point. */
+int psys_grid_find_nearest_n(const ParticleGrid *grid,
+                             const float co[3],
+                             float range,
+                             int index_exclude,
+                             KDTreeNearest_3d *r_nearest,
+                             int nearest_len_capacity,
+                             float (*len_sq_fn)(const float co_search[3],
+                                                const float co_test[3],
+                                                const void *user_data),
+                             const void *user_data)
+{
+  const float range_sq = range * range;
+  const float cell_size = 1.0f / grid->inv_cell_size;
+  const int ring_max = max_iii(grid->res[0], grid->res[1], grid->res[2]);
+  int center[3];
+  int found = 0;
+
+  if (grid->totpoint == 0 || nearest_len_capacity <= 0) {
+    return 0;
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    const float f = (co[axis] - grid->min[axis]) * grid->inv_cell_size;
+    /* Also rejects NaN coordinates. */
+    if (!(f > -FLT_MAX && f < FLT_MAX)) {
+      return 0;
+    }
+    center[axis] = (f > 0.0f) ? (int)min_ff(f, (float)(grid->res[axis] - 1)) : 0;
+  }
+
+  for (int ring = 0; ring < ring_max; ring++) {
+    /* Cells of this ring and beyond are at least this far from `co`. */
+    const float ring_dist = (float)max_ii(ring - 1, 0) * cell_size;
+    int lo[3], hi[3];
+
+    if (ring_dist * ring_dist > range_sq ||
+        (found == nearest_len_capacity && r_nearest[found - 1].dist <= ring_dist * ring_dist)) {
+      break;
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+      lo[axis] = max_ii(center[axis] - ring, 0);
+      hi[axis] = min_ii(center[axis] + ring, grid->res[axis] - 1);
+    }
+
+    for (int z = lo[2]; z <= hi[2]; z++) {
+      for (int y = lo[1]; y <= hi[1]; y++) {
+        const int row = (z * grid->res[1] + y) * grid->res[0];
+        /* Rows on the faces of the ring are scanned completely, the others only at both ends. */
+        const bool is_face = abs(z - center[2]) == ring || abs(y - center[1]) == ring;
+        int span[2][2] = {{lo[0], hi[0]}, {1, 0}};
+
+        if (!is_face) {
+          span[0][0] = span[0][1] = center[0] - ring;
+          span[1][0] = span[1][1] = center[0] + ring;
+          if (span[0][0] < 0) {
+            span[0][1] = -1;
+          }
+          if (span[1][0] >= grid->res[0]) {
+            span[1][1] = -1;
+          }
+        }
+
+        for (int s = 0; s < 2; s++) {
+          if (span[s][0] > span[s][1]) {
+            continue;
+          }
+          const int end = grid->cell_start[row + span[s][1] + 1];
+          for (int i = grid->cell_start[row + span[s][0]]; i < end; i++) {
+            if (grid->index[i] == index_exclude) {
+              continue;
+            }
+            const float dist_sq = len_sq_fn ? len_sq_fn(co, grid->co[i], user_data) :
+                                              len_squared_v3v3(co, grid->co[i]);
+            if (dist_sq <= range_sq) {
+              psys_grid_nearest_insert(
+                  r_nearest, &found, nearest_len_capacity, grid->index[i], dist_sq, grid->co[i]);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < found; i++) {
+    r_nearest[i].dist = sqrtf(r_nearest[i].dist);
+  }
+
+  return found;
 }
 
 #define SPH_NEIGHBORS 512
@@ -1694,12 +1993,13 @@ typedef struct SPHRangeData {
 } SPHRangeData;
 
 static void sph_evaluate_func(BVHTree *tree,
-                              ParticleSystem **psys,
+                              SPHData *sphdata,
                               const float co[3],
                               SPHRangeData *pfr,
                               float interaction_radius,
                               BVHTree_RangeQuery callback)
 {
+  ParticleSystem **psys = sphdata->psys;
   int i;
 
   pfr->tot_neighbors = 0;
@@ -1714,11 +2014,9 @@ static void sph_evaluate_func(BVHTree *tree,
       break;
     }
 
-    BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_READ);
-
-    BLI_bvhtree_range_query(psys[i]->bvhtree, co, interaction_radius, callback, pfr);
-
-    BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
+    if (sphdata->grid[i]) {
+      psys_grid_range_query(sphdata->grid[i], co, interaction_radius, callback, pfr);
+    }
   }
 }
 static void sph_density_accum_cb(void *userdata, int index, const float co[3], float squared_dist)
@@ -1798,7 +2096,7 @@ static void sph_force_cb(void *sphdata_v, ParticleKey *state, float *force, floa
   SPHRangeData pfr;
   SPHNeighbor *pfn;
   float *gravity = sphdata->gravity;
-  EdgeHash *springhash = sphdata->eh;
+  SPHSpringIndex *springs = sphdata->springs;
 
   float q, u, rij, dv[3];
   float pressure, near_pressure;
@@ -1838,7 +2136,7 @@ static void sph_force_cb(void *sphdata_v, ParticleKey *state, float *force, floa
   pfr.pa = pa;
   pfr.mass = sphdata->mass;
 
-  sph_evaluate_func(NULL, psys, state->co, &pfr, interaction_radius, sph_density_accum_cb);
+  sph_evaluate_func(NULL, sphdata, state->co, &pfr, interaction_radius, sph_density_accum_cb);
 
   density = data[0];
   near_density = data[1];
@@ -1882,12 +2180,12 @@ static void sph_force_cb(void *sphdata_v, ParticleKey *state, float *force, floa
 
     if (spring_constant > 0.0f) {
       /* Viscoelastic spring force */
-      if (pfn->psys == psys[0] && fluid->flag & SPH_VISCOELASTIC_SPRINGS && springhash) {
-        /* BLI_edgehash_lookup appears to be thread-safe. - z0r */
-        spring_index = POINTER_AS_INT(BLI_edgehash_lookup(springhash, index, pfn->index));
+      if (pfn->psys == psys[0] && fluid->flag & SPH_VISCOELASTIC_SPRINGS && springs) {
+        /* The spring index is read-only during the step. */
+        spring_index = sph_spring_index_lookup(springs, index, pfn->index);
 
-        if (spring_index) {
-          spring = psys[0]->fluid_springs + spring_index - 1;
+        if (spring_index != -1) {
+          spring = psys[0]->fluid_springs + spring_index;
 
           madd_v3_v3fl(force,
                        vec,
@@ -2031,7 +2329,7 @@ static void sphclassical_force_cb(void *sphdata_v,
   pfr.pa = pa;
 
   sph_evaluate_func(
-      NULL, psys, state->co, &pfr, interaction_radius, sphclassical_neighbor_accum_cb);
+      NULL, sphdata, state->co, &pfr, interaction_radius, sphclassical_neighbor_accum_cb);
   pressure = stiffness * (pow7f(pa->sphdensity / rest_density) - 1.0f);
 
   /* multiply by mass so that we return a force, not accel */
@@ -2115,13 +2413,17 @@ static void sphclassical_calc_dens(ParticleData *pa, float UNUSED(dfra), SPHData
   pfr.mass = sphdata->mass;
 
   sph_evaluate_func(
-      NULL, psys, pa->state.co, &pfr, interaction_radius, sphclassical_density_accum_cb);
+      NULL, sphdata, pa->state.co, &pfr, interaction_radius, sphclassical_density_accum_cb);
   pa->sphdensity = min_ff(max_ff(data[0], fluid->rest_density * 0.9f), fluid->rest_density * 1.1f);
 }
 
-void psys_sph_init(ParticleSimulationData *sim, SPHData *sphdata)
+void psys_sph_init(ParticleSimulationData *sim, SPHData *sphdata, float cfra)
 {
   ParticleTarget *pt;
+  SPHFluidSettings *fluid = sim->psys->part->fluid;
+  /* Cell size matching the interaction radius used by the solvers. */
+  float cell_size = fluid->radius * (fluid->flag & SPH_FAC_RADIUS ? 4.0f * sim->psys->part->size :
+                                                                    1.0f);
   int i;
 
   BLI_buffer_field_init(&sphdata->new_springs, ParticleSpring);
@@ -2132,13 +2434,19 @@ void psys_sph_init(ParticleSimulationData *sim, SPHData *sphdata)
     sphdata->psys[i] = pt ? psys_get_target_system(sim->ob, pt) : NULL;
   }
 
+  /* Positions are those at the start of the step, before the particles are initialized. */
+  for (i = 0; i < 10; i++) {
+    sphdata->grid[i] = sphdata->psys[i] ? psys_grid_build(sphdata->psys[i], cfra, cell_size) :
+                                          NULL;
+  }
+
   if (psys_uses_gravity(sim)) {
     sphdata->gravity = sim->scene->physics_settings.gravity;
   }
   else {
     sphdata->gravity = NULL;
   }
-  sphdata->eh = sph_springhash_build(sim->psys);
+  sphdata->springs = sph_spring_index_build(sim->psys);
 
   /* These per-particle values should be overridden later, but just for
    * completeness we give them default values now. */
@@ -2172,9 +2480,16 @@ void psys_sph_finalize(SPHData *sphdata)
 {
   psys_sph_flush_springs(sphdata);
 
-  if (sphdata->eh) {
-    BLI_edgehash_free(sphdata->eh, NULL);
-    sphdata->eh = NULL;
+  for (int i = 0; i < 10; i++) {
+    if (sphdata->grid[i]) {
+      psys_grid_free(sphdata->grid[i]);
+      sphdata->grid[i] = NULL;
+    }
+  }
+
+  if (sphdata->springs) {
+    sph_spring_index_free(sphdata->springs);
+    sphdata->springs = NULL;
   }
 }
 
@@ -2194,7 +2509,7 @@ void psys_sph_density(BVHTree *tree, SPHData *sphdata, float co[3], float vars[2
   pfr.h = interaction_radius * sphdata->hfac;
   pfr.mass = sphdata->mass;
 
-  sph_evaluate_func(tree, psys, co, &pfr, interaction_radius, sphdata->density_cb);
+  sph_evaluate_func(tree, sphdata, co, &pfr, interaction_radius, sphdata->density_cb);
 
   vars[0] = pfr.data[0];
   vars[1] = pfr.data[1];
@@ -3691,6 +4006,8 @@ static float sync_timestep(ParticleSystem *psys, float t_frac)
 
 typedef struct DynamicStepSolverTaskData {
   ParticleSimulationData *sim;
+  /* Particle to process for each task index, spatially sorted. */
+  const int *order;
 
   float cfra;
   float timestep;
@@ -3717,7 +4034,7 @@ static void dynamics_step_sphdata_reduce(const void *__restrict UNUSED(userdata)
 }
 
 static void dynamics_step_sph_ddr_task_cb_ex(void *__restrict userdata,
-                                             const int p,
+                                             const int i,
                                              const TaskParallelTLS *__restrict tls)
 {
   DynamicStepSolverTaskData *data = userdata;
@@ -3728,6 +4045,7 @@ static void dynamics_step_sph_ddr_task_cb_ex(void *__restrict userdata,
   SPHData *sphdata = tls->userdata_chunk;
 
   ParticleData *pa;
+  const int p = data->order[i];
 
   if ((pa = psys->particles + p)->state.time <= 0.0f) {
     return;
@@ -3753,13 +4071,14 @@ static void dynamics_step_sph_ddr_task_cb_ex(void *__restrict userdata,
 }
 
 static void dynamics_step_sph_classical_basic_integrate_task_cb_ex(
-    void *__restrict userdata, const int p, const TaskParallelTLS *__restrict UNUSED(tls))
+    void *__restrict userdata, const int i, const TaskParallelTLS *__restrict UNUSED(tls))
 {
   DynamicStepSolverTaskData *data = userdata;
   ParticleSimulationData *sim = data->sim;
   ParticleSystem *psys = sim->psys;
 
   ParticleData *pa;
+  const int p = data->order[i];
 
   if ((pa = psys->particles + p)->state.time <= 0.0f) {
     return;
@@ -3769,7 +4088,7 @@ static void dynamics_step_sph_classical_basic_integrate_task_cb_ex(
 }
 
 static void dynamics_step_sph_classical_calc_density_task_cb_ex(
-    void *__restrict userdata, const int p, const TaskParallelTLS *__restrict tls)
+    void *__restrict userdata, const int i, const TaskParallelTLS *__restrict tls)
 {
   DynamicStepSolverTaskData *data = userdata;
   ParticleSimulationData *sim = data->sim;
@@ -3778,6 +4097,7 @@ static void dynamics_step_sph_classical_calc_density_task_cb_ex(
   SPHData *sphdata = tls->userdata_chunk;
 
   ParticleData *pa;
+  const int p = data->order[i];
 
   if ((pa = psys->particles + p)->state.time <= 0.0f) {
     return;
@@ -3787,7 +4107,7 @@ static void dynamics_step_sph_classical_calc_density_task_cb_ex(
 }
 
 static void dynamics_step_sph_classical_integrate_task_cb_ex(void *__restrict userdata,
-                                                             const int p,
+                                                             const int i,
                                                              const TaskParallelTLS *__restrict tls)
 {
   DynamicStepSolverTaskData *data = userdata;
@@ -3798,6 +4118,7 @@ static void dynamics_step_sph_classical_integrate_task_cb_ex(void *__restrict us
   SPHData *sphdata = tls->userdata_chunk;
 
   ParticleData *pa;
+  const int p = data->order[i];
 
   if ((pa = psys->particles + p)->state.time <= 0.0f) {
     return;
@@ -3819,12 +4140,144 @@ static void dynamics_step_sph_classical_integrate_task_cb_ex(void *__restrict us
   }
 }
 
+typedef struct DynamicStepBoidsTaskData {
+  ParticleSimulationData *sim;
+  const BoidBrainData *bbd;
+  /* Brain state of every particle, the wanted velocity is passed on to #boid_body. */
+  BoidBrainData *brains;
+  unsigned int seed;
+  float cfra;
+} DynamicStepBoidsTaskData;
+
+typedef struct DynamicStepBoidsTLS {
+  RNG *rng;
+} DynamicStepBoidsTLS;
+
+/* Random numbers of a boid depend on the particle and pass only, not on the thread running it,
+ * so the result is the same for any number of threads. */
+static RNG *dynamics_step_boids_rng(const DynamicStepBoidsTaskData *data,
+                                    DynamicStepBoidsTLS *tls_data,
+                                    const int p,
+                                    const int pass)
+{
+  const unsigned int seed = data->seed + 2 * (unsigned int)p + (unsigned int)pass;
+
+  if (tls_data->rng == NULL) {
+    tls_data->rng = BLI_rng_new_srandom(seed);
+  }
+  else {
+    BLI_rng_srandom(tls_data->rng, seed);
+  }
+  return tls_data->rng;
+}
+
+static void dynamics_step_boids_brain_task_cb_ex(void *__restrict userdata,
+                                                 const int p,
+                                                 const TaskParallelTLS *__restrict tls)
+{
+  DynamicStepBoidsTaskData *data = userdata;
+  ParticleData *pa = data->sim->psys->particles + p;
+  BoidBrainData *bbd = &data->brains[p];
+
+  if (pa->state.time <= 0.0f) {
+    return;
+  }
+
+  *bbd = *data->bbd;
+  bbd->goal_ob = NULL;
+  bbd->rng = dynamics_step_boids_rng(data, tls->userdata_chunk, p, 0);
+
+  boid_brain(bbd, p, pa);
+}
+
+static void dynamics_step_boids_body_task_cb_ex(void *__restrict userdata,
+                                                const int p,
+                                                const TaskParallelTLS *__restrict tls)
+{
+  DynamicStepBoidsTaskData *data = userdata;
+  ParticleData *pa = data->sim->psys->particles + p;
+  BoidBrainData *bbd = &data->brains[p];
+
+  if (pa->state.time <= 0.0f || pa->alive == PARS_DYING) {
+    return;
+  }
+
+  bbd->rng = dynamics_step_boids_rng(data, tls->userdata_chunk, p, 1);
+
+  boid_body(bbd, pa);
+
+  /* deflection */
+  if (data->sim->colliders) {
+    /* Collision response draws from the simulation random generator. */
+    ParticleSimulationData sim = *data->sim;
+    sim.rng = bbd->rng;
+    collision_check(&sim, p, pa->state.time, data->cfra);
+  }
+}
+
+static void dynamics_step_boids_tls_free(const void *__restrict UNUSED(userdata),
+                                         void *__restrict chunk)
+{
+  DynamicStepBoidsTLS *tls_data = chunk;
+
+  if (tls_data->rng) {
+    BLI_rng_free(tls_data->rng);
+    /* The chunk is reused by the next pass when not threaded. */
+    tls_data->rng = NULL;
+  }
+}
+
+/* Neighbor grids for the boid rules, `bbd->target_grids` follows the particle target list. */
+static void dynamics_step_boids_grids_build(ParticleSimulationData *sim,
+                                            BoidBrainData *bbd,
+                                            float cfra)
+{
+  ParticleSystem *psys = sim->psys;
+  ParticleSettings *part = psys->part;
+  /* Sized for the separation range of the boids, other queries visit more cells. */
+  const float cell_size = 2.0f *
+                          max_ff(part->boids->air_personal_space,
+                                 part->boids->land_personal_space) *
+                          part->size;
+  ParticleTarget *pt;
+  int i;
+
+  bbd->grid = psys_grid_build(psys, cfra, cell_size);
+  bbd->target_grids = MEM_calloc_arrayN(
+      max_ii(BLI_listbase_count(&psys->targets), 1), sizeof(ParticleGrid *), __func__);
+
+  for (pt = psys->targets.first, i = 0; pt; pt = pt->next, i++) {
+    ParticleSystem *psys_target = psys_get_target_system(sim->ob, pt);
+    if (psys_target == psys) {
+      bbd->target_grids[i] = bbd->grid;
+    }
+    else if (psys_target) {
+      bbd->target_grids[i] = psys_grid_build(psys_target, cfra, cell_size);
+    }
+  }
+}
+
+static void dynamics_step_boids_grids_free(ParticleSimulationData *sim, BoidBrainData *bbd)
+{
+  ParticleTarget *pt;
+  int i;
+
+  for (pt = sim->psys->targets.first, i = 0; pt; pt = pt->next, i++) {
+    if (bbd->target_grids[i] && bbd->target_grids[i] != bbd->grid) {
+      psys_grid_free(bbd->target_grids[i]);
+    }
+  }
+  MEM_freeN(bbd->target_grids);
+  psys_grid_free(bbd->grid);
+}
+
 /* unbaked particles are calculated dynamically */
 static void dynamics_step(ParticleSimulationData *sim, float cfra)
 {
   ParticleSystem *psys = sim->psys;
   ParticleSettings *part = psys->part;
   BoidBrainData bbd;
+  SPHData sphdata;
   ParticleTexture ptex;
   PARTICLE_P;
   float timestep;
@@ -3864,36 +4317,23 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
   /* initialize physics type specific stuff */
   switch (part->phystype) {
     case PART_PHYS_BOIDS: {
-      ParticleTarget *pt = psys->targets.first;
+      memset(&bbd, 0, sizeof(bbd));
       bbd.sim = sim;
       bbd.part = part;
       bbd.cfra = cfra;
       bbd.dfra = dfra;
       bbd.timestep = timestep;
-      bbd.rng = sim->rng;
 
-      psys_update_particle_tree(psys, cfra);
+      /* Built from the positions before the particles are initialized for this step. */
+      dynamics_step_boids_grids_build(sim, &bbd, cfra);
 
       boids_precalc_rules(part, cfra);
-
-      for (; pt; pt = pt->next) {
-        ParticleSystem *psys_target = psys_get_target_system(sim->ob, pt);
-        if (psys_target && psys_target != psys) {
-          psys_update_particle_tree(psys_target, cfra);
-        }
-      }
       break;
     }
     case PART_PHYS_FLUID: {
-      ParticleTarget *pt = psys->targets.first;
-      psys_update_particle_bvhtree(psys, cfra);
-
-      for (; pt;
-           pt = pt->next) { /* Updating others systems particle tree for fluid-fluid interaction */
-        if (pt->ob) {
-          psys_update_particle_bvhtree(BLI_findlink(&pt->ob->particlesystem, pt->psys - 1), cfra);
-        }
-      }
+      /* Builds the neighbor grids of this and the target systems for fluid-fluid interaction,
+       * from the particle positions before they are initialized for this step. */
+      psys_sph_init(sim, &sphdata, cfra);
       break;
     }
   }
@@ -3963,29 +4403,37 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
       break;
     }
     case PART_PHYS_BOIDS: {
-      LOOP_DYNAMIC_PARTICLES
-      {
-        bbd.goal_ob = NULL;
-
-        boid_brain(&bbd, p, pa);
-
-        if (pa->alive != PARS_DYING) {
-          boid_body(&bbd, pa);
-
-          /* deflection */
-          if (sim->colliders) {
-            collision_check(sim, p, pa->state.time, cfra);
-          }
-        }
-      }
+      /* All boids decide from the state at the start of the step before any of them moves,
+       * which makes the result independent of the evaluation order. */
+      DynamicStepBoidsTaskData task_data = {
+          .sim = sim,
+          .bbd = &bbd,
+          .brains = MEM_malloc_arrayN(max_ii(psys->totpart, 1), sizeof(BoidBrainData), __func__),
+          .seed = 31415926 + (int)cfra + psys->seed,
+          .cfra = cfra,
+      };
+      DynamicStepBoidsTLS tls_data = {NULL};
+
+      TaskParallelSettings settings;
+      BLI_parallel_range_settings_defaults(&settings);
+      settings.use_threading = (psys->totpart > 100) && boids_rules_thread_safe(part);
+      settings.userdata_chunk = &tls_data;
+      settings.userdata_chunk_size = sizeof(tls_data);
+      settings.func_free = dynamics_step_boids_tls_free;
+
+      BLI_task_parallel_range(
+          0, psys->totpart, &task_data, dynamics_step_boids_brain_task_cb_ex, &settings);
+      BLI_task_parallel_range(
+          0, psys->totpart, &task_data, dynamics_step_boids_body_task_cb_ex, &settings);
+
+      MEM_freeN(task_data.brains);
+      dynamics_step_boids_grids_free(sim, &bbd);
       break;
     }
     case PART_PHYS_FLUID: {
-      SPHData sphdata;
-      psys_sph_init(sim, &sphdata);
-
       DynamicStepSolverTaskData task_data = {
           .sim = sim,
+          .order = sphdata.grid[0]->order,
           .cfra = cfra,
           .timestep = timestep,
           .dtime = dtime,
@@ -47,6 +47,7 @@
 #include "BLI_endian_switch.h"
 #include "BLI_math.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -72,10 +73,6 @@
 
 #include "BIK_api.h"
 
-#ifdef WITH_BULLET
-#  include "RBI_api.h"
-#endif
-
 #ifdef WITH_LZO
 #  ifdef WITH_SYSTEM_LZO
 #    include <lzo/lzo1x.h>
@@ -137,8 +134,10 @@ static int ptcache_extra_datasize[] = {
 
 /* forward declarations */
 static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len);
-static int ptcache_file_compressed_write(
-    PTCacheFile *pf, unsigned char *in, unsigned int in_len, unsigned char *out, int mode);
+static int ptcache_file_compressed_write(PTCacheFile *pf,
+                                         unsigned char *in,
+                                         unsigned int in_len,
+                                         int mode);
 static int ptcache_file_write(PTCacheFile *pf, const void *f, unsigned int tot, unsigned int size);
 static int ptcache_file_read(PTCacheFile *pf, void *f, unsigned int tot, unsigned int size);
 
@@ -690,7 +689,6 @@ static int ptcache_dynamicpaint_write(PTCacheFile *pf, void *dp_v)
   if (surface->format != MOD_DPAINT_SURFACE_F_IMAGESEQ && surface->data) {
     int total_points = surface->data->total_points;
     unsigned int in_len;
-    unsigned char *out;
 
     /* cache type */
     ptcache_file_write(pf, &surface->type, 1, sizeof(int));
@@ -709,11 +707,8 @@ static int ptcache_dynamicpaint_write(PTCacheFile *pf, void *dp_v)
       return 0;
     }
 
-    out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len), "pointcache_lzo_buffer");
-
     ptcache_file_compressed_write(
-        pf, (unsigned char *)surface->data->type_data, in_len, out, cache_compress);
-    MEM_freeN(out);
+        pf, (unsigned char *)surface->data->type_data, in_len, cache_compress);
   }
   return 1;
 }
@@ -773,11 +768,8 @@ static int ptcache_rigidbody_write(int index, void *rb_v, void **data, int UNUSE
   if (ob && ob->rigidbody_object) {
     RigidBodyOb *rbo = ob->rigidbody_object;
 
+    /* The transforms are copied from the physics world before writing the cache. */
     if (rbo->type == RBO_TYPE_ACTIVE && rbo->shared->physics_object != NULL) {
-#ifdef WITH_BULLET
-      RB_body_get_position(rbo->shared->physics_object, rbo->pos);
-      RB_body_get_orientation(rbo->shared->physics_object, rbo->orn);
-#endif
       PTCACHE_DATA_FROM(data, BPHYS_DATA_LOCATION, rbo->pos);
       PTCACHE_DATA_FROM(data, BPHYS_DATA_ROTATION, rbo->orn);
     }
@@ -1513,89 +1505,99 @@ static void ptcache_file_close(PTCacheFile *pf)
   }
 }
 
-static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len)
+/* In files with #PTCACHE_TYPEFLAG_SHUFFLE, compressed blocks are byte shuffled: the first bytes
+ * of all 4 byte words come first, then the second bytes and so on. Floats of neighboring points
+ * share their sign and exponent bytes, which compress much better when grouped together. */
+#define PTCACHE_COMPRESS_SHUFFLE_STRIDE 4
+
+/* One compressed block of a cache file. Compression and decompression don't touch the file,
+ * so all blocks of a frame can be processed in parallel and written or read in order. */
+typedef struct PTCacheCompressedBlock {
+  /* Uncompressed data, not owned. */
+  unsigned char *data;
+  unsigned int len;
+  /* Byte shuffle the data when it's compressed, see #PTCACHE_COMPRESS_SHUFFLE_STRIDE. */
+  bool shuffle;
+
+  /* Compression mode byte as stored in the file, 0 when stored uncompressed. */
+  unsigned char compressed;
+  unsigned char *buf;
+  unsigned int buf_len;
+  unsigned char props[16];
+  unsigned int props_len;
+
+  int result;
+} PTCacheCompressedBlock;
+
+static void ptcache_byte_shuffle(unsigned char *dst, const unsigned char *src, unsigned int len)
 {
-  int r = 0;
-  unsigned char compressed = 0;
-  size_t in_len;
-#ifdef WITH_LZO
-  size_t out_len = len;
-#endif
-  unsigned char *in;
-  unsigned char *props = MEM_callocN(sizeof(char[16]), "tmp");
+  const unsigned int tot = len / PTCACHE_COMPRESS_SHUFFLE_STRIDE;
 
-  ptcache_file_read(pf, &compressed, 1, sizeof(unsigned char));
-  if (compressed) {
-    unsigned int size;
-    ptcache_file_read(pf, &size, 1, sizeof(unsigned int));
-    in_len = (size_t)size;
-    if (in_len == 0) {
-      /* do nothing */
+  for (unsigned int b = 0; b < PTCACHE_COMPRESS_SHUFFLE_STRIDE; b++) {
+    unsigned char *dst_b = dst + b * tot;
+    for (unsigned int i = 0; i < tot; i++) {
+      dst_b[i] = src[i * PTCACHE_COMPRESS_SHUFFLE_STRIDE + b];
     }
-    else {
-      in = (unsigned char *)MEM_callocN(sizeof(unsigned char) * in_len,
-                                        "pointcache_compressed_buffer");
-      ptcache_file_read(pf, in, in_len, sizeof(unsigned char));
-#ifdef WITH_LZO
-      if (compressed == 1) {
-        r = lzo1x_decompress_safe(in, (lzo_uint)in_len, result, (lzo_uint *)&out_len, NULL);
-      }
-#endif
-#ifdef WITH_LZMA
-      if (compressed == 2) {
-        size_t sizeOfIt;
-        size_t leni = in_len, leno = len;
-        ptcache_file_read(pf, &size, 1, sizeof(unsigned int));
-        sizeOfIt = (size_t)size;
-        ptcache_file_read(pf, props, sizeOfIt, sizeof(unsigned char));
-        r = LzmaUncompress(result, &leno, in, &leni, props, sizeOfIt);
-      }
-#endif
-      MEM_freeN(in);
-    }
-  }
-  else {
-    ptcache_file_read(pf, result, len, sizeof(unsigned char));
   }
+}
 
-  MEM_freeN(props);
+static void ptcache_byte_unshuffle(unsigned char *dst, const unsigned char *src, unsigned int len)
+{
+  const unsigned int tot = len / PTCACHE_COMPRESS_SHUFFLE_STRIDE;
 
-  return r;
+  for (unsigned int b = 0; b < PTCACHE_COMPRESS_SHUFFLE_STRIDE; b++) {
+    const unsigned char *src_b = src + b * tot;
+    for (unsigned int i = 0; i < tot; i++) {
+      dst[i * PTCACHE_COMPRESS_SHUFFLE_STRIDE + b] = src_b[i];
+    }
+  }
 }
-static int ptcache_file_compressed_write(
-    PTCacheFile *pf, unsigned char *in, unsigned int in_len, unsigned char *out, int mode)
+
+static void ptcache_block_compress(PTCacheCompressedBlock *block, int mode)
 {
+  unsigned char *in = block->data;
+  unsigned char *shuffled = NULL;
+  size_t out_len = LZO_OUT_LEN(block->len) * 4;
   int r = 0;
-  unsigned char compressed = 0;
-  size_t out_len = 0;
-  unsigned char *props = MEM_callocN(sizeof(char[16]), "tmp");
-  size_t sizeOfIt = 5;
 
-  (void)mode; /* unused when building w/o compression */
+  block->compressed = 0;
+  block->buf = NULL;
+  block->buf_len = 0;
+  block->props_len = 0;
+  block->result = 0;
+
+  if (block->len == 0 || !ELEM(mode, 1, 2)) {
+    return;
+  }
+
+  if (block->shuffle && block->len % PTCACHE_COMPRESS_SHUFFLE_STRIDE == 0) {
+    shuffled = MEM_mallocN(block->len, "pointcache_shuffle_buffer");
+    ptcache_byte_shuffle(shuffled, block->data, block->len);
+    in = shuffled;
+  }
+
+  block->buf = MEM_mallocN(out_len, "pointcache_compressed_buffer");
 
 #ifdef WITH_LZO
-  out_len = LZO_OUT_LEN(in_len);
   if (mode == 1) {
     LZO_HEAP_ALLOC(wrkmem, LZO1X_MEM_COMPRESS);
 
-    r = lzo1x_1_compress(in, (lzo_uint)in_len, out, (lzo_uint *)&out_len, wrkmem);
-    if (!(r == LZO_E_OK) || (out_len >= in_len)) {
-      compressed = 0;
-    }
-    else {
-      compressed = 1;
+    r = lzo1x_1_compress(in, (lzo_uint)block->len, block->buf, (lzo_uint *)&out_len, wrkmem);
+    if ((r == LZO_E_OK) && (out_len < block->len)) {
+      block->compressed = 1;
     }
   }
 #endif
 #ifdef WITH_LZMA
   if (mode == 2) {
+    size_t props_len = 5;
 
-    r = LzmaCompress(out,
+    r = LzmaCompress(block->buf,
                      &out_len,
                      in,
-                     in_len, /* assume sizeof(char)==1.... */
-                     props,
-                     &sizeOfIt,
+                     block->len, /* assume sizeof(char)==1.... */
+                     block->props,
+                     &props_len,
                      5,
                      1 << 24,
                      3,
@@ -1604,34 +1606,197 @@ static int ptcache_file_compressed_write(
                      32,
                      2);
 
-    if (!(r == SZ_OK) || (out_len >= in_len)) {
-      compressed = 0;
-    }
-    else {
-      compressed = 2;
+    if ((r == SZ_OK) && (out_len < block->len)) {
+      block->compressed = 2;
+      block->props_len = (unsigned int)props_len;
     }
   }
 #endif
+  UNUSED_VARS(in);
 
-  ptcache_file_write(pf, &compressed, 1, sizeof(unsigned char));
-  if (compressed) {
-    unsigned int size = out_len;
-    ptcache_file_write(pf, &size, 1, sizeof(unsigned int));
-    ptcache_file_write(pf, out, out_len, sizeof(unsigned char));
+  if (block->compressed) {
+    block->buf_len = (unsigned int)out_len;
   }
   else {
-    ptcache_file_write(pf, in, in_len, sizeof(unsigned char));
+    MEM_freeN(block->buf);
+    block->buf = NULL;
+  }
+
+  if (shuffled) {
+    MEM_freeN(shuffled);
   }
 
-  if (compressed == 2) {
-    unsigned int size = sizeOfIt;
-    ptcache_file_write(pf, &sizeOfIt, 1, sizeof(unsigned int));
-    ptcache_file_write(pf, props, size, sizeof(unsigned char));
+  block->result = r;
+}
+
+static void ptcache_block_decompress(PTCacheCompressedBlock *block)
+{
+  const int mode = block->compressed;
+  unsigned char *out = block->data;
+  unsigned char *shuffled = NULL;
+  int r = 0;
+
+  if (block->buf == NULL) {
+    return;
+  }
+
+  if (block->shuffle && block->len % PTCACHE_COMPRESS_SHUFFLE_STRIDE == 0) {
+    shuffled = MEM_mallocN(block->len, "pointcache_shuffle_buffer");
+    out = shuffled;
+  }
+
+#ifdef WITH_LZO
+  if (mode == 1) {
+    size_t out_len = block->len;
+    r = lzo1x_decompress_safe(
+        block->buf, (lzo_uint)block->buf_len, out, (lzo_uint *)&out_len, NULL);
+  }
+#endif
+#ifdef WITH_LZMA
+  if (mode == 2) {
+    size_t leni = block->buf_len, leno = block->len;
+    r = LzmaUncompress(out, &leno, block->buf, &leni, block->props, block->props_len);
+  }
+#endif
+  UNUSED_VARS(mode, out);
+
+  if (shuffled) {
+    ptcache_byte_unshuffle(block->data, shuffled, block->len);
+    MEM_freeN(shuffled);
   }
 
-  MEM_freeN(props);
+  MEM_freeN(block->buf);
+  block->buf = NULL;
 
-  return r;
+  block->result = r;
+}
+
+typedef struct PTCacheCompressData {
+  PTCacheCompressedBlock *blocks;
+  int mode;
+} PTCacheCompressData;
+
+static void ptcache_block_compress_cb(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PTCacheCompressData *data = userdata;
+  ptcache_block_compress(&data->blocks[i], data->mode);
+}
+
+static void ptcache_block_decompress_cb(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PTCacheCompressedBlock *blocks = userdata;
+  ptcache_block_decompress(&blocks[i]);
+}
+
+/* Only worth to spawn tasks for frames with enough data. */
+#define PTCACHE_COMPRESS_PARALLEL_LIMIT (64 * 1024)
+
+static void ptcache_blocks_compress(PTCacheCompressedBlock *blocks, int totblock, int mode)
+{
+  PTCacheCompressData data = {.blocks = blocks, .mode = mode};
+  TaskParallelSettings settings;
+  size_t totlen = 0;
+
+  for (int i = 0; i < totblock; i++) {
+    totlen += blocks[i].len;
+  }
+
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (totblock > 1 && totlen > PTCACHE_COMPRESS_PARALLEL_LIMIT);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, totblock, &data, ptcache_block_compress_cb, &settings);
+}
+
+static void ptcache_blocks_decompress(PTCacheCompressedBlock *blocks, int totblock)
+{
+  TaskParallelSettings settings;
+  size_t totlen = 0;
+
+  for (int i = 0; i < totblock; i++) {
+    totlen += blocks[i].len;
+  }
+
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (totblock > 1 && totlen > PTCACHE_COMPRESS_PARALLEL_LIMIT);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, totblock, blocks, ptcache_block_decompress_cb, &settings);
+}
+
+static void ptcache_file_block_write(PTCacheFile *pf, PTCacheCompressedBlock *block)
+{
+  ptcache_file_write(pf, &block->compressed, 1, sizeof(unsigned char));
+  if (block->compressed) {
+    ptcache_file_write(pf, &block->buf_len, 1, sizeof(unsigned int));
+    ptcache_file_write(pf, block->buf, block->buf_len, sizeof(unsigned char));
+  }
+  else {
+    ptcache_file_write(pf, block->data, block->len, sizeof(unsigned char));
+  }
+
+  if (block->compressed == 2) {
+    ptcache_file_write(pf, &block->props_len, 1, sizeof(unsigned int));
+    ptcache_file_write(pf, block->props, block->props_len, sizeof(unsigned char));
+  }
+
+  MEM_SAFE_FREE(block->buf);
+}
+
+/* Reads a block into `block->data`. Compressed data is only loaded into `block->buf` and
+ * needs #ptcache_block_decompress afterwards. */
+static void ptcache_file_block_read(PTCacheFile *pf, PTCacheCompressedBlock *block)
+{
+  block->compressed = 0;
+  block->buf = NULL;
+  block->buf_len = 0;
+  block->props_len = 0;
+  block->result = 0;
+
+  ptcache_file_read(pf, &block->compressed, 1, sizeof(unsigned char));
+  if (block->compressed) {
+    ptcache_file_read(pf, &block->buf_len, 1, sizeof(unsigned int));
+    if (block->buf_len != 0) {
+      block->buf = MEM_callocN(sizeof(unsigned char) * block->buf_len,
+                               "pointcache_compressed_buffer");
+      ptcache_file_read(pf, block->buf, block->buf_len, sizeof(unsigned char));
+
+      if (block->compressed == 2) {
+        ptcache_file_read(pf, &block->props_len, 1, sizeof(unsigned int));
+        block->props_len = MIN2(block->props_len, sizeof(block->props));
+        ptcache_file_read(pf, block->props, block->props_len, sizeof(unsigned char));
+      }
+    }
+  }
+  else {
+    ptcache_file_read(pf, block->data, block->len, sizeof(unsigned char));
+  }
+}
+
+static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len)
+{
+  PTCacheCompressedBlock block = {
+      .data = result, .len = len, .shuffle = (pf->flag & PTCACHE_TYPEFLAG_SHUFFLE) != 0};
+
+  ptcache_file_block_read(pf, &block);
+  ptcache_block_decompress(&block);
+
+  return block.result;
+}
+static int ptcache_file_compressed_write(PTCacheFile *pf,
+                                         unsigned char *in,
+                                         unsigned int in_len,
+                                         int mode)
+{
+  PTCacheCompressedBlock block = {
+      .data = in, .len = in_len, .shuffle = (pf->flag & PTCACHE_TYPEFLAG_SHUFFLE) != 0};
+
+  ptcache_block_compress(&block, mode);
+  ptcache_file_block_write(pf, &block);
+
+  return block.result;
 }
 static int ptcache_file_read(PTCacheFile *pf, void *f, unsigned int tot, unsigned int size)
 {
@@ -1967,12 +2132,21 @@ static PTCacheMem *ptcache_disk_frame_to_mem(PTCacheID *pid, int cfra)
     ptcache_data_alloc(pm);
 
     if (pf->flag & PTCACHE_TYPEFLAG_COMPRESS) {
+      /* Read all channels, then decompress them in parallel. */
+      PTCacheCompressedBlock blocks[BPHYS_TOT_DATA];
+      int totblock = 0;
+
       for (i = 0; i < BPHYS_TOT_DATA; i++) {
-        unsigned int out_len = pm->totpoint * ptcache_data_size[i];
         if (pf->data_types & (1 << i)) {
-          ptcache_file_compressed_read(pf, (unsigned char *)(pm->data[i]), out_len);
+          PTCacheCompressedBlock *block = &blocks[totblock++];
+          block->data = (unsigned char *)(pm->data[i]);
+          block->len = pm->totpoint * ptcache_data_size[i];
+          block->shuffle = (pf->flag & PTCACHE_TYPEFLAG_SHUFFLE) != 0;
+          ptcache_file_block_read(pf, block);
         }
       }
+
+      ptcache_blocks_decompress(blocks, totblock);
     }
     else {
       void *cur[BPHYS_TOT_DATA];
@@ -2056,7 +2230,7 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
   }
 
   if (pid->cache->compression) {
-    pf->flag |= PTCACHE_TYPEFLAG_COMPRESS;
+    pf->flag |= PTCACHE_TYPEFLAG_COMPRESS | PTCACHE_TYPEFLAG_SHUFFLE;
   }
 
   if (!ptcache_file_header_begin_write(pf) || !pid->write_header(pf)) {
@@ -2065,16 +2239,24 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
 
   if (!error) {
     if (pid->cache->compression) {
+      /* Compress all channels in parallel, then write them in order. */
+      PTCacheCompressedBlock blocks[BPHYS_TOT_DATA];
+      int totblock = 0;
+
       for (i = 0; i < BPHYS_TOT_DATA; i++) {
         if (pm->data[i]) {
-          unsigned int in_len = pm->totpoint * ptcache_data_size[i];
-          unsigned char *out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len) * 4,
-                                                            "pointcache_lzo_buffer");
-          ptcache_file_compressed_write(
-              pf, (unsigned char *)(pm->data[i]), in_len, out, pid->cache->compression);
-          MEM_freeN(out);
+          PTCacheCompressedBlock *block = &blocks[totblock++];
+          block->data = (unsigned char *)(pm->data[i]);
+          block->len = pm->totpoint * ptcache_data_size[i];
+          block->shuffle = true;
         }
       }
+
+      ptcache_blocks_compress(blocks, totblock, pid->cache->compression);
+
+      for (i = 0; i < totblock; i++) {
+        ptcache_file_block_write(pf, &blocks[i]);
+      }
     }
     else {
       void *cur[BPHYS_TOT_DATA];
@@ -2105,11 +2287,8 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
 
       if (pid->cache->compression) {
         unsigned int in_len = extra->totdata * ptcache_extra_datasize[extra->type];
-        unsigned char *out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len) * 4,
-                                                          "pointcache_lzo_buffer");
         ptcache_file_compressed_write(
-            pf, (unsigned char *)(extra->data), in_len, out, pid->cache->compression);
-        MEM_freeN(out);
+            pf, (unsigned char *)(extra->data), in_len, pid->cache->compression);
       }
       else {
         ptcache_file_write(pf, extra->data, extra->totdata, ptcache_extra_datasize[extra->type]);
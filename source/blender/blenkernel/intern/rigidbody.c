@@ -35,6 +35,7 @@
 
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #ifdef WITH_BULLET
 #  include "RBI_api.h"
@@ -2014,6 +2015,38 @@ static void rigidbody_update_simulation_post_step(Depsgraph *depsgraph, RigidBod
   FOREACH_COLLECTION_OBJECT_RECURSIVE_END;
 }
 
+static void rigidbody_update_ob_transforms_cb(void *__restrict userdata,
+                                              const int i,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RigidBodyWorld *rbw = userdata;
+  Object *ob = rbw->objects[i];
+
+  if (ob && ob->rigidbody_object) {
+    RigidBodyOb *rbo = ob->rigidbody_object;
+
+    if (rbo->type == RBO_TYPE_ACTIVE && rbo->shared->physics_object != NULL) {
+      RB_body_get_position(rbo->shared->physics_object, rbo->pos);
+      RB_body_get_orientation(rbo->shared->physics_object, rbo->orn);
+    }
+  }
+}
+
+/* Copy the simulated transforms of all active bodies back in one pass before writing the cache,
+ * only reading from the physics world so the bodies can be handled in parallel. */
+static void rigidbody_update_ob_transforms(RigidBodyWorld *rbw)
+{
+  if (rbw->objects == NULL) {
+    return;
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (rbw->numbodies > 1024);
+  settings.min_iter_per_thread = 256;
+  BLI_task_parallel_range(0, rbw->numbodies, rbw, rigidbody_update_ob_transforms_cb, &settings);
+}
+
 bool BKE_rigidbody_check_sim_running(RigidBodyWorld *rbw, float ctime)
 {
   return (rbw && (rbw->flag & RBW_FLAG_MUTED) == 0 && ctime > rbw->shared->pointcache->startframe);
@@ -2159,6 +2192,12 @@ void BKE_rigidbody_rebuild_world(Depsgraph *depsgraph, Scene *scene, float ctime
     cache->flag |= PTCACHE_OUTDATED;
   }
 
+  /* Baked playback only reads transforms from the cache, don't build the physics world for it.
+   * It is still created on demand when a frame can't be read and has to be simulated. */
+  if (cache->flag & PTCACHE_BAKED) {
+    return;
+  }
+
   if (ctime == startframe + 1 && rbw->ltime == startframe) {
     if (cache->flag & PTCACHE_OUTDATED) {
       BKE_ptcache_id_reset(scene, &pid, PTCACHE_RESET_OUTDATED);
@@ -2219,6 +2258,7 @@ void BKE_rigidbody_do_simulation(Depsgraph *depsgraph, Scene *scene, float ctime
   if (compare_ff_relative(ctime, rbw->ltime + 1, FLT_EPSILON, 64)) {
     /* write cache for first frame when on second frame */
     if (rbw->ltime == startframe && (cache->flag & PTCACHE_OUTDATED || cache->last_exact == 0)) {
+      rigidbody_update_ob_transforms(rbw);
       BKE_ptcache_write(&pid, startframe);
     }
 
@@ -2246,6 +2286,7 @@ void BKE_rigidbody_do_simulation(Depsgraph *depsgraph, Scene *scene, float ctime
     rigidbody_update_simulation_post_step(depsgraph, rbw);
 
     /* write cache for current frame */
+    rigidbody_update_ob_transforms(rbw);
     BKE_ptcache_validate(cache, (int)ctime);
     BKE_ptcache_write(&pid, (unsigned int)ctime);
 
@@ -59,6 +59,7 @@
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -269,6 +270,170 @@ typedef struct ccdf_minmax {
   float minx, miny, minz, maxx, maxy, maxz;
 } ccdf_minmax;
 
+/* Limit the amount of cells per item, for the grid and for the cells the items are stored in.
+ * The cell size is grown until both fit. */
+#define SB_HASH_MAX_CELLS_PER_ITEM 4
+/* Below this amount of points the force and integration loops are run single threaded. */
+#define SB_THREADING_LIMIT 100
+
+/**
+ * Uniform grid over axis aligned boxes, shared by the self collision of body points and the
+ * collider faces. Every item is stored in each cell its box overlaps, items of a cell are
+ * sorted by index. Looking up a single cell visits candidates in the same order as a linear scan
+ * would, so the collider face lookup gives the same results as before. Ball self collision goes
+ * over several cells one after another, which changes the order forces are summed in, so its
+ * results differ slightly from the all pairs loop.
+ */
+typedef struct SBSpatialHash {
+  float min[3];
+  float cell_size_inv;
+  int res[3];
+  /* Offsets into items for every cell, totcell + 1 entries. */
+  int *cell_start;
+  int *items;
+} SBSpatialHash;
+
+typedef void (*SBSpatialHashBoundsFn)(const void *userdata,
+                                      int index,
+                                      float r_min[3],
+                                      float r_max[3]);
+
+/* Clamped cell range of a box, false when the box is entirely outside of the grid. */
+static bool sb_spatial_hash_cell_range(const SBSpatialHash *hash,
+                                       const float min[3],
+                                       const float max[3],
+                                       int r_lo[3],
+                                       int r_hi[3])
+{
+  for (int k = 0; k < 3; k++) {
+    const float lo = (min[k] - hash->min[k]) * hash->cell_size_inv;
+    const float hi = (max[k] - hash->min[k]) * hash->cell_size_inv;
+    /* Also rejects NaN coordinates. */
+    if (!(hi >= 0.0f && lo < (float)hash->res[k])) {
+      return false;
+    }
+    r_lo[k] = (lo > 0.0f) ? (int)lo : 0;
+    r_hi[k] = min_ii((int)hi, hash->res[k] - 1);
+  }
+  return true;
+}
+
+/* Amount of cells all items are stored in, as double so large boxes can't overflow. */
+static double sb_spatial_hash_entries_num(const void *userdata,
+                                          SBSpatialHashBoundsFn bounds_fn,
+                                          int num,
+                                          const float min[3],
+                                          float cell_size)
+{
+  double entries_num = 0.0;
+  float bmin[3], bmax[3];
+
+  for (int i = 0; i < num; i++) {
+    double item_cells = 1.0;
+    bounds_fn(userdata, i, bmin, bmax);
+    for (int k = 0; k < 3; k++) {
+      item_cells *= floor((double)(bmax[k] - min[k]) / cell_size) -
+                    floor((double)(bmin[k] - min[k]) / cell_size) + 1.0;
+    }
+    entries_num += item_cells;
+  }
+  return entries_num;
+}
+
+static SBSpatialHash *sb_spatial_hash_build(const void *userdata,
+                                            SBSpatialHashBoundsFn bounds_fn,
+                                            int num,
+                                            float cell_size)
+{
+  SBSpatialHash *hash;
+  float min[3], max[3], bmin[3], bmax[3], extent[3];
+  int lo[3], hi[3], totcell, max_cells, i;
+
+  if (num <= 0 || !(cell_size > 0.0f)) {
+    return NULL;
+  }
+
+  INIT_MINMAX(min, max);
+  for (i = 0; i < num; i++) {
+    bounds_fn(userdata, i, bmin, bmax);
+    minmax_v3v3_v3(min, max, bmin);
+    minmax_v3v3_v3(min, max, bmax);
+  }
+  sub_v3_v3v3(extent, max, min);
+  if (!(isfinite(extent[0]) && isfinite(extent[1]) && isfinite(extent[2]))) {
+    return NULL;
+  }
+
+  /* Grow the cells until the grid stays within budget, mostly for scattered outliers, and until
+   * the items are stored in few enough cells, for a few items much larger than the rest. */
+  max_cells = max_ii(num, 1) * SB_HASH_MAX_CELLS_PER_ITEM;
+  for (;;) {
+    const float cells = (floorf(extent[0] / cell_size) + 1.0f) *
+                        (floorf(extent[1] / cell_size) + 1.0f) *
+                        (floorf(extent[2] / cell_size) + 1.0f);
+    if (cells <= (float)max_cells &&
+        sb_spatial_hash_entries_num(userdata, bounds_fn, num, min, cell_size) <=
+            (double)max_cells) {
+      break;
+    }
+    cell_size *= 2.0f;
+  }
+
+  hash = MEM_callocN(sizeof(SBSpatialHash), "SBSpatialHash");
+  copy_v3_v3(hash->min, min);
+  hash->cell_size_inv = 1.0f / cell_size;
+  for (int k = 0; k < 3; k++) {
+    hash->res[k] = (int)(extent[k] / cell_size) + 1;
+  }
+  totcell = hash->res[0] * hash->res[1] * hash->res[2];
+  hash->cell_start = MEM_callocN(sizeof(int) * (totcell + 1), "SBSpatialHash cells");
+
+  /* Count, accumulate and fill: a counting sort keeps the items of a cell in index order. */
+  for (int pass = 0; pass < 2; pass++) {
+    for (i = 0; i < num; i++) {
+      bounds_fn(userdata, i, bmin, bmax);
+      if (!sb_spatial_hash_cell_range(hash, bmin, bmax, lo, hi)) {
+        continue;
+      }
+      for (int z = lo[2]; z <= hi[2]; z++) {
+        for (int y = lo[1]; y <= hi[1]; y++) {
+          for (int x = lo[0]; x <= hi[0]; x++) {
+            const int cell = (z * hash->res[1] + y) * hash->res[0] + x;
+            if (pass == 0) {
+              hash->cell_start[cell + 1]++;
+            }
+            else {
+              hash->items[hash->cell_start[cell]++] = i;
+            }
+          }
+        }
+      }
+    }
+
+    if (pass == 0) {
+      for (i = 0; i < totcell; i++) {
+        hash->cell_start[i + 1] += hash->cell_start[i];
+      }
+      hash->items = MEM_mallocN(sizeof(int) * max_ii(hash->cell_start[totcell], 1),
+                                "SBSpatialHash items");
+    }
+  }
+  /* Filling advanced every start to the next cell's start, shift them back. */
+  memmove(hash->cell_start + 1, hash->cell_start, sizeof(int) * totcell);
+  hash->cell_start[0] = 0;
+
+  return hash;
+}
+
+static void sb_spatial_hash_free(SBSpatialHash *hash)
+{
+  if (hash) {
+    MEM_freeN(hash->cell_start);
+    MEM_freeN(hash->items);
+    MEM_freeN(hash);
+  }
+}
+
 typedef struct ccd_Mesh {
   int mvert_num, tri_num;
   const MVert *mvert;
@@ -276,11 +441,43 @@ typedef struct ccd_Mesh {
   const MVertTri *tri;
   int safety;
   ccdf_minmax *mima;
+  /* Grid over the face bounds in mima, used to find collision candidates of a point. */
+  SBSpatialHash *hash;
   /* Axis Aligned Bounding Box AABB */
   float bbmin[3];
   float bbmax[3];
 } ccd_Mesh;
 
+static void ccd_mesh_face_bounds(const void *userdata, int index, float r_min[3], float r_max[3])
+{
+  const ccdf_minmax *mima = &((const ccdf_minmax *)userdata)[index];
+  r_min[0] = mima->minx;
+  r_min[1] = mima->miny;
+  r_min[2] = mima->minz;
+  r_max[0] = mima->maxx;
+  r_max[1] = mima->maxy;
+  r_max[2] = mima->maxz;
+}
+
+/* (Re)build the face grid, cells are sized after the average face bounds. */
+static void ccd_mesh_hash_update(ccd_Mesh *pccd_M)
+{
+  float cell_size = 0.0f;
+  int i;
+
+  sb_spatial_hash_free(pccd_M->hash);
+
+  for (i = 0; i < pccd_M->tri_num; i++) {
+    const ccdf_minmax *mima = &pccd_M->mima[i];
+    cell_size += max_fff(
+        mima->maxx - mima->minx, mima->maxy - mima->miny, mima->maxz - mima->minz);
+  }
+  cell_size /= (float)max_ii(pccd_M->tri_num, 1);
+
+  pccd_M->hash = sb_spatial_hash_build(
+      pccd_M->mima, ccd_mesh_face_bounds, pccd_M->tri_num, cell_size);
+}
+
 static ccd_Mesh *ccd_mesh_make(Object *ob)
 {
   CollisionModifierData *cmd;
@@ -307,6 +504,7 @@ static ccd_Mesh *ccd_mesh_make(Object *ob)
   pccd_M->bbmin[0] = pccd_M->bbmin[1] = pccd_M->bbmin[2] = 1e30f;
   pccd_M->bbmax[0] = pccd_M->bbmax[1] = pccd_M->bbmax[2] = -1e30f;
   pccd_M->mprevvert = NULL;
+  pccd_M->hash = NULL;
 
   /* blow it up with forcefield ranges */
   hull = max_ff(ob->pd->pdef_sbift, ob->pd->pdef_sboft);
@@ -366,6 +564,8 @@ static ccd_Mesh *ccd_mesh_make(Object *ob)
     mima->maxz = max_ff(mima->maxz, v[2] + hull);
   }
 
+  ccd_mesh_hash_update(pccd_M);
+
   return pccd_M;
 }
 static void ccd_mesh_update(Object *ob, ccd_Mesh *pccd_M)
@@ -486,6 +686,8 @@ static void ccd_mesh_update(Object *ob, ccd_Mesh *pccd_M)
     mima->maxy = max_ff(mima->maxy, v[1] + hull);
     mima->maxz = max_ff(mima->maxz, v[2] + hull);
   }
+
+  ccd_mesh_hash_update(pccd_M);
 }
 
 static void ccd_mesh_free(ccd_Mesh *ccdm)
@@ -498,6 +700,7 @@ static void ccd_mesh_free(ccd_Mesh *ccdm)
       MEM_freeN((void *)ccdm->mprevvert);
     }
     MEM_freeN(ccdm->mima);
+    sb_spatial_hash_free(ccdm->hash);
     MEM_freeN(ccdm);
     ccdm = NULL;
   }
@@ -1698,12 +1901,27 @@ static int sb_detect_vertex_collisionCached(float opco[3],
         fa *= fa;
         fa = 1.0f / fa;
         avel[0] = avel[1] = avel[2] = 0.0f;
+
+        /* Only visit the faces sharing the grid cell of the point, when there is a grid. */
+        const int *candidates = NULL;
+        if (ccdm->hash) {
+          int lo[3], hi[3];
+          if (!sb_spatial_hash_cell_range(ccdm->hash, opco, opco, lo, hi)) {
+            BLI_ghashIterator_step(ihash);
+            continue;
+          }
+          const int cell = (lo[2] * ccdm->hash->res[1] + lo[1]) * ccdm->hash->res[0] + lo[0];
+          candidates = &ccdm->hash->items[ccdm->hash->cell_start[cell]];
+          a = ccdm->hash->cell_start[cell + 1] - ccdm->hash->cell_start[cell];
+        }
+
         /* use mesh*/
-        while (a--) {
+        for (int c = 0; c < a; c++) {
+          const int t = candidates ? candidates[c] : c;
+          mima = &ccdm->mima[t];
+          vt = &ccdm->tri[t];
           if ((opco[0] < mima->minx) || (opco[0] > mima->maxx) || (opco[1] < mima->miny) ||
               (opco[1] > mima->maxy) || (opco[2] < mima->minz) || (opco[2] > mima->maxz)) {
-            mima++;
-            vt++;
             continue;
           }
 
@@ -1773,10 +1991,7 @@ static int sb_detect_vertex_collisionCached(float opco[3],
               ci++;
             }
           }
-
-          mima++;
-          vt++;
-        } /* while a */
+        } /* for candidates */
       }   /* if (ob->pd && ob->pd->deflect) */
       BLI_ghashIterator_step(ihash);
     }
@@ -1961,243 +2176,246 @@ static void sb_spring_force(
 /* since this is definitely the most CPU consuming task here .. try to spread it */
 /* core function _softbody_calc_forces_slice_in_a_thread */
 /* result is int to be able to flag user break */
-static int _softbody_calc_forces_slice_in_a_thread(Scene *scene,
-                                                   Object *ob,
-                                                   float forcetime,
-                                                   float timenow,
-                                                   int ifirst,
-                                                   int ilast,
-                                                   int *UNUSED(ptr_to_break_func(void)),
-                                                   ListBase *effectors,
-                                                   int do_deflector,
-                                                   float fieldfactor,
-                                                   float windfactor)
-{
+typedef struct SBCalcForcesData {
+  Scene *scene;
+  Object *ob;
+  float forcetime;
+  float timenow;
+  ListBase *effectors;
+  int do_deflector;
+  float fieldfactor;
+  float windfactor;
+  int do_selfcollision;
+  int do_springcollision;
+  int do_aero;
+  /* inner spring constants function */
   float iks;
-  int bb, do_selfcollision, do_springcollision, do_aero;
-  int number_of_points_here = ilast - ifirst;
-  SoftBody *sb = ob->soft; /* is supposed to be there */
-  BodyPoint *bp;
+  /* Grid over the body points for the ball self collision, may be NULL. */
+  const SBSpatialHash *selfhash;
+  float max_colball;
+} SBCalcForcesData;
 
-  /* initialize */
-  if (sb) {
-    /* check conditions for various options */
-    /* +++ could be done on object level to squeeze out the last bits of it */
-    do_selfcollision = ((ob->softflag & OB_SB_EDGES) && (sb->bspring) &&
-                        (ob->softflag & OB_SB_SELF));
-    do_springcollision = do_deflector && (ob->softflag & OB_SB_EDGES) &&
-                         (ob->softflag & OB_SB_EDGECOLL);
-    do_aero = ((sb->aeroedge) && (ob->softflag & OB_SB_EDGES));
-    /* --- could be done on object level to squeeze out the last bits of it */
+static void sb_body_point_bounds(const void *userdata, int index, float r_min[3], float r_max[3])
+{
+  const BodyPoint *bp = &((const BodyPoint *)userdata)[index];
+  copy_v3_v3(r_min, bp->pos);
+  copy_v3_v3(r_max, bp->pos);
+}
+
+/* Ball self collision of point a against obp, running in a thread we must not alter obp. */
+static void sb_ball_self_collision(Object *ob, int a, BodyPoint *bp, const BodyPoint *obp)
+{
+  SoftBody *sb = ob->soft;
+  float velcenter[3], dvel[3], def[3];
+  float distance;
+  const float compare = (obp->colball + bp->colball);
+  const float bstune = sb->ballstiff;
+
+  sub_v3_v3v3(def, bp->pos, obp->pos);
+  /* rather check the AABBoxes before ever calculating the real distance */
+  /* mathematically it is completely nuts, but performance is pretty much (3) times faster */
+  if ((fabsf(def[0]) > compare) || (fabsf(def[1]) > compare) || (fabsf(def[2]) > compare)) {
+    return;
   }
-  else {
-    CLOG_ERROR(&LOG, "expected a SB here");
-    return 999;
-  }
-
-  /* debugerin */
-  if (sb->totpoint < ifirst) {
-    printf("Aye 998");
-    return 998;
-  }
-  /* debugerin */
-
-  bp = &sb->bpoint[ifirst];
-  for (bb = number_of_points_here; bb > 0; bb--, bp++) {
-    /* clear forces  accumulator */
-    bp->force[0] = bp->force[1] = bp->force[2] = 0.0;
-    /* naive ball self collision */
-    /* needs to be done if goal snaps or not */
-    if (do_selfcollision) {
-      int attached;
-      BodyPoint *obp;
-      BodySpring *bs;
-      int c, b;
-      float velcenter[3], dvel[3], def[3];
-      float distance;
-      float compare;
-      float bstune = sb->ballstiff;
-
-      /* Running in a slice we must not assume anything done with obp
-       * neither alter the data of obp. */
-      for (c = sb->totpoint, obp = sb->bpoint; c > 0; c--, obp++) {
-        compare = (obp->colball + bp->colball);
-        sub_v3_v3v3(def, bp->pos, obp->pos);
-        /* rather check the AABBoxes before ever calculating the real distance */
-        /* mathematically it is completely nuts, but performance is pretty much (3) times faster */
-        if ((fabsf(def[0]) > compare) || (fabsf(def[1]) > compare) || (fabsf(def[2]) > compare)) {
-          continue;
-        }
-        distance = normalize_v3(def);
-        if (distance < compare) {
-          /* exclude body points attached with a spring */
-          attached = 0;
-          for (b = obp->nofsprings; b > 0; b--) {
-            bs = sb->bspring + obp->springs[b - 1];
-            if (ELEM(ilast - bb, bs->v2, bs->v1)) {
-              attached = 1;
-              continue;
-            }
-          }
-          if (!attached) {
-            float f = bstune / (distance) + bstune / (compare * compare) * distance -
-                      2.0f * bstune / compare;
+  distance = normalize_v3(def);
+  if (distance < compare) {
+    /* exclude body points attached with a spring */
+    for (int b = obp->nofsprings; b > 0; b--) {
+      const BodySpring *bs = sb->bspring + obp->springs[b - 1];
+      if (ELEM(a, bs->v2, bs->v1)) {
+        return;
+      }
+    }
 
-            mid_v3_v3v3(velcenter, bp->vec, obp->vec);
-            sub_v3_v3v3(dvel, velcenter, bp->vec);
-            mul_v3_fl(dvel, _final_mass(ob, bp));
+    float f = bstune / (distance) + bstune / (compare * compare) * distance -
+              2.0f * bstune / compare;
 
-            madd_v3_v3fl(bp->force, def, f * (1.0f - sb->balldamp));
-            madd_v3_v3fl(bp->force, dvel, sb->balldamp);
-          }
-        }
+    mid_v3_v3v3(velcenter, bp->vec, obp->vec);
+    sub_v3_v3v3(dvel, velcenter, bp->vec);
+    mul_v3_fl(dvel, _final_mass(ob, bp));
+
+    madd_v3_v3fl(bp->force, def, f * (1.0f - sb->balldamp));
+    madd_v3_v3fl(bp->force, dvel, sb->balldamp);
+  }
+}
+
+static void softbody_calc_forces_cb(void *__restrict userdata,
+                                    const int a,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SBCalcForcesData *data = userdata;
+  Scene *scene = data->scene;
+  Object *ob = data->ob;
+  SoftBody *sb = ob->soft;
+  BodyPoint *bp = &sb->bpoint[a];
+  ListBase *effectors = data->effectors;
+  const float forcetime = data->forcetime;
+  const float timenow = data->timenow;
+  const float fieldfactor = data->fieldfactor;
+  const float windfactor = data->windfactor;
+  const float iks = data->iks;
+
+  /* clear forces  accumulator */
+  bp->force[0] = bp->force[1] = bp->force[2] = 0.0;
+  /* ball self collision */
+  /* needs to be done if goal snaps or not */
+  if (data->do_selfcollision) {
+    const SBSpatialHash *hash = data->selfhash;
+    int lo[3], hi[3];
+
+    if (hash == NULL) {
+      for (int c = 0; c < sb->totpoint; c++) {
+        sb_ball_self_collision(ob, a, bp, &sb->bpoint[c]);
       }
     }
-    /* naive ball self collision done */
-
-    if (_final_goal(ob, bp) < SOFTGOALSNAP) { /* omit this bp when it snaps */
-      float auxvect[3];
-      float velgoal[3];
-
-      /* do goal stuff */
-      if (ob->softflag & OB_SB_GOAL) {
-        /* true elastic goal */
-        float ks, kd;
-        sub_v3_v3v3(auxvect, bp->pos, bp->origT);
-        ks = 1.0f / (1.0f - _final_goal(ob, bp) * sb->goalspring) - 1.0f;
-        bp->force[0] += -ks * (auxvect[0]);
-        bp->force[1] += -ks * (auxvect[1]);
-        bp->force[2] += -ks * (auxvect[2]);
-
-        /* calculate damping forces generated by goals*/
-        sub_v3_v3v3(velgoal, bp->origS, bp->origE);
-        kd = sb->goalfrict * sb_fric_force_scale(ob);
-        add_v3_v3v3(auxvect, velgoal, bp->vec);
-
-        if (forcetime >
-            0.0f) { /* make sure friction does not become rocket motor on time reversal */
-          bp->force[0] -= kd * (auxvect[0]);
-          bp->force[1] -= kd * (auxvect[1]);
-          bp->force[2] -= kd * (auxvect[2]);
-        }
-        else {
-          bp->force[0] -= kd * (velgoal[0] - bp->vec[0]);
-          bp->force[1] -= kd * (velgoal[1] - bp->vec[1]);
-          bp->force[2] -= kd * (velgoal[2] - bp->vec[2]);
+    else {
+      /* Any point closer than both collision balls lives in the neighboring cells. */
+      const float reach = bp->colball + data->max_colball;
+      float min[3], max[3];
+      copy_v3_v3(min, bp->pos);
+      copy_v3_v3(max, bp->pos);
+      add_v3_fl(min, -reach);
+      add_v3_fl(max, reach);
+
+      if (sb_spatial_hash_cell_range(hash, min, max, lo, hi)) {
+        for (int z = lo[2]; z <= hi[2]; z++) {
+          for (int y = lo[1]; y <= hi[1]; y++) {
+            for (int x = lo[0]; x <= hi[0]; x++) {
+              const int cell = (z * hash->res[1] + y) * hash->res[0] + x;
+              for (int c = hash->cell_start[cell]; c < hash->cell_start[cell + 1]; c++) {
+                sb_ball_self_collision(ob, a, bp, &sb->bpoint[hash->items[c]]);
+              }
+            }
+          }
         }
       }
-      /* done goal stuff */
-
-      /* gravitation */
-      if (scene->physics_settings.flag & PHYS_GLOBAL_GRAVITY) {
-        float gravity[3];
-        copy_v3_v3(gravity, scene->physics_settings.gravity);
-
-        /* Individual mass of node here. */
-        mul_v3_fl(gravity,
-                  sb_grav_force_scale(ob) * _final_mass(ob, bp) *
-                      sb->effector_weights->global_gravity);
+    }
+  }
+  /* ball self collision done */
 
-        add_v3_v3(bp->force, gravity);
-      }
+  if (_final_goal(ob, bp) < SOFTGOALSNAP) { /* omit this bp when it snaps */
+    float auxvect[3];
+    float velgoal[3];
 
-      /* particle field & vortex */
-      if (effectors) {
-        EffectedPoint epoint;
-        float kd;
-        float force[3] = {0.0f, 0.0f, 0.0f};
-        float speed[3] = {0.0f, 0.0f, 0.0f};
-
-        /* just for calling function once */
-        float eval_sb_fric_force_scale = sb_fric_force_scale(ob);
-
-        pd_point_from_soft(scene, bp->pos, bp->vec, sb->bpoint - bp, &epoint);
-        BKE_effectors_apply(effectors, NULL, sb->effector_weights, &epoint, force, NULL, speed);
-
-        /* apply forcefield*/
-        mul_v3_fl(force, fieldfactor * eval_sb_fric_force_scale);
-        add_v3_v3(bp->force, force);
-
-        /* BP friction in moving media */
-        kd = sb->mediafrict * eval_sb_fric_force_scale;
-        bp->force[0] -= kd * (bp->vec[0] + windfactor * speed[0] / eval_sb_fric_force_scale);
-        bp->force[1] -= kd * (bp->vec[1] + windfactor * speed[1] / eval_sb_fric_force_scale);
-        bp->force[2] -= kd * (bp->vec[2] + windfactor * speed[2] / eval_sb_fric_force_scale);
-        /* now we'll have nice centrifugal effect for vortex */
+    /* do goal stuff */
+    if (ob->softflag & OB_SB_GOAL) {
+      /* true elastic goal */
+      float ks, kd;
+      sub_v3_v3v3(auxvect, bp->pos, bp->origT);
+      ks = 1.0f / (1.0f - _final_goal(ob, bp) * sb->goalspring) - 1.0f;
+      bp->force[0] += -ks * (auxvect[0]);
+      bp->force[1] += -ks * (auxvect[1]);
+      bp->force[2] += -ks * (auxvect[2]);
+
+      /* calculate damping forces generated by goals*/
+      sub_v3_v3v3(velgoal, bp->origS, bp->origE);
+      kd = sb->goalfrict * sb_fric_force_scale(ob);
+      add_v3_v3v3(auxvect, velgoal, bp->vec);
+
+      if (forcetime >
+          0.0f) { /* make sure friction does not become rocket motor on time reversal */
+        bp->force[0] -= kd * (auxvect[0]);
+        bp->force[1] -= kd * (auxvect[1]);
+        bp->force[2] -= kd * (auxvect[2]);
       }
       else {
-        /* BP friction in media (not) moving*/
-        float kd = sb->mediafrict * sb_fric_force_scale(ob);
-        /* assume it to be proportional to actual velocity */
-        bp->force[0] -= bp->vec[0] * kd;
-        bp->force[1] -= bp->vec[1] * kd;
-        bp->force[2] -= bp->vec[2] * kd;
-        /* friction in media done */
+        bp->force[0] -= kd * (velgoal[0] - bp->vec[0]);
+        bp->force[1] -= kd * (velgoal[1] - bp->vec[1]);
+        bp->force[2] -= kd * (velgoal[2] - bp->vec[2]);
       }
-      /* +++cached collision targets */
-      bp->choke = 0.0f;
-      bp->choke2 = 0.0f;
-      bp->loc_flag &= ~SBF_DOFUZZY;
-      if (do_deflector && !(bp->loc_flag & SBF_OUTOFCOLLISION)) {
-        float cfforce[3], defforce[3] = {0.0f, 0.0f, 0.0f}, vel[3] = {0.0f, 0.0f, 0.0f},
-                          facenormal[3], cf = 1.0f, intrusion;
-        float kd = 1.0f;
-
-        if (sb_deflect_face(ob, bp->pos, facenormal, defforce, &cf, timenow, vel, &intrusion)) {
-          if (intrusion < 0.0f) {
-            sb->scratch->flag |= SBF_DOFUZZY;
-            bp->loc_flag |= SBF_DOFUZZY;
-            bp->choke = sb->choke * 0.01f;
-          }
+    }
+    /* done goal stuff */
+
+    /* gravitation */
+    if (scene->physics_settings.flag & PHYS_GLOBAL_GRAVITY) {
+      float gravity[3];
+      copy_v3_v3(gravity, scene->physics_settings.gravity);
+
+      /* Individual mass of node here. */
+      mul_v3_fl(gravity,
+                sb_grav_force_scale(ob) * _final_mass(ob, bp) *
+                    sb->effector_weights->global_gravity);
+
+      add_v3_v3(bp->force, gravity);
+    }
+
+    /* particle field & vortex */
+    if (effectors) {
+      EffectedPoint epoint;
+      float kd;
+      float force[3] = {0.0f, 0.0f, 0.0f};
+      float speed[3] = {0.0f, 0.0f, 0.0f};
 
-          sub_v3_v3v3(cfforce, bp->vec, vel);
-          madd_v3_v3fl(bp->force, cfforce, -cf * 50.0f);
+      /* just for calling function once */
+      float eval_sb_fric_force_scale = sb_fric_force_scale(ob);
 
-          madd_v3_v3fl(bp->force, defforce, kd);
+      pd_point_from_soft(scene, bp->pos, bp->vec, sb->bpoint - bp, &epoint);
+      BKE_effectors_apply(effectors, NULL, sb->effector_weights, &epoint, force, NULL, speed);
+
+      /* apply forcefield*/
+      mul_v3_fl(force, fieldfactor * eval_sb_fric_force_scale);
+      add_v3_v3(bp->force, force);
+
+      /* BP friction in moving media */
+      kd = sb->mediafrict * eval_sb_fric_force_scale;
+      bp->force[0] -= kd * (bp->vec[0] + windfactor * speed[0] / eval_sb_fric_force_scale);
+      bp->force[1] -= kd * (bp->vec[1] + windfactor * speed[1] / eval_sb_fric_force_scale);
+      bp->force[2] -= kd * (bp->vec[2] + windfactor * speed[2] / eval_sb_fric_force_scale);
+      /* now we'll have nice centrifugal effect for vortex */
+    }
+    else {
+      /* BP friction in media (not) moving*/
+      float kd = sb->mediafrict * sb_fric_force_scale(ob);
+      /* assume it to be proportional to actual velocity */
+      bp->force[0] -= bp->vec[0] * kd;
+      bp->force[1] -= bp->vec[1] * kd;
+      bp->force[2] -= bp->vec[2] * kd;
+      /* friction in media done */
+    }
+    /* +++cached collision targets */
+    bp->choke = 0.0f;
+    bp->choke2 = 0.0f;
+    bp->loc_flag &= ~SBF_DOFUZZY;
+    if (data->do_deflector && !(bp->loc_flag & SBF_OUTOFCOLLISION)) {
+      float cfforce[3], defforce[3] = {0.0f, 0.0f, 0.0f}, vel[3] = {0.0f, 0.0f, 0.0f},
+                        facenormal[3], cf = 1.0f, intrusion;
+      float kd = 1.0f;
+
+      if (sb_deflect_face(ob, bp->pos, facenormal, defforce, &cf, timenow, vel, &intrusion)) {
+        if (intrusion < 0.0f) {
+          sb->scratch->flag |= SBF_DOFUZZY;
+          bp->loc_flag |= SBF_DOFUZZY;
+          bp->choke = sb->choke * 0.01f;
         }
+
+        sub_v3_v3v3(cfforce, bp->vec, vel);
+        madd_v3_v3fl(bp->force, cfforce, -cf * 50.0f);
+
+        madd_v3_v3fl(bp->force, defforce, kd);
       }
-      /* ---cached collision targets */
-
-      /* +++springs */
-      iks = 1.0f / (1.0f - sb->inspring) - 1.0f; /* inner spring constants function */
-      if (ob->softflag & OB_SB_EDGES) {
-        if (sb->bspring) { /* spring list exists at all ? */
-          int b;
-          BodySpring *bs;
-          for (b = bp->nofsprings; b > 0; b--) {
-            bs = sb->bspring + bp->springs[b - 1];
-            if (do_springcollision || do_aero) {
-              add_v3_v3(bp->force, bs->ext_force);
-              if (bs->flag & BSF_INTERSECT) {
-                bp->choke = bs->cf;
-              }
+    }
+    /* ---cached collision targets */
+
+    /* +++springs */
+    if (ob->softflag & OB_SB_EDGES) {
+      if (sb->bspring) { /* spring list exists at all ? */
+        int b;
+        BodySpring *bs;
+        for (b = bp->nofsprings; b > 0; b--) {
+          bs = sb->bspring + bp->springs[b - 1];
+          if (data->do_springcollision || data->do_aero) {
+            add_v3_v3(bp->force, bs->ext_force);
+            if (bs->flag & BSF_INTERSECT) {
+              bp->choke = bs->cf;
             }
-            // sb_spring_force(Object *ob, int bpi, BodySpring *bs, float iks, float forcetime)
-            sb_spring_force(ob, ilast - bb, bs, iks, forcetime);
-          } /* loop springs */
-        }   /* existing spring list */
-      }     /*any edges*/
-      /* ---springs */
-    }       /*omit on snap */
-  }         /*loop all bp's*/
-  return 0; /*done fine*/
-}
-
-static void *exec_softbody_calc_forces(void *data)
-{
-  SB_thread_context *pctx = (SB_thread_context *)data;
-  _softbody_calc_forces_slice_in_a_thread(pctx->scene,
-                                          pctx->ob,
-                                          pctx->forcetime,
-                                          pctx->timenow,
-                                          pctx->ifirst,
-                                          pctx->ilast,
-                                          NULL,
-                                          pctx->effectors,
-                                          pctx->do_deflector,
-                                          pctx->fieldfactor,
-                                          pctx->windfactor);
-  return NULL;
+          }
+          // sb_spring_force(Object *ob, int bpi, BodySpring *bs, float iks, float forcetime)
+          sb_spring_force(ob, a, bs, iks, forcetime);
+        } /* loop springs */
+      }   /* existing spring list */
+    }     /*any edges*/
+    /* ---springs */
+  }       /*omit on snap */
 }
 
 static void sb_cf_threads_run(Scene *scene,
@@ -2211,62 +2429,48 @@ static void sb_cf_threads_run(Scene *scene,
                               float fieldfactor,
                               float windfactor)
 {
-  ListBase threads;
-  SB_thread_context *sb_threads;
-  int i, totthread, left, dec;
-
-  /* wild guess .. may increase with better thread management 'above'
-   * or even be UI option sb->spawn_cf_threads_nopts. */
-  int lowpoints = 100;
-
-  /* figure the number of threads while preventing pretty pointless threading overhead */
-  totthread = BKE_scene_num_threads(scene);
-  /* what if we got zillions of CPUs running but less to spread*/
-  while ((totpoint / totthread < lowpoints) && (totthread > 1)) {
-    totthread--;
-  }
+  SoftBody *sb = ob->soft;
+  SBSpatialHash *selfhash = NULL;
+  SBCalcForcesData data = {
+      .scene = scene,
+      .ob = ob,
+      .forcetime = forcetime,
+      .timenow = timenow,
+      .effectors = effectors,
+      .do_deflector = do_deflector,
+      .fieldfactor = fieldfactor,
+      .windfactor = windfactor,
+      .iks = 1.0f / (1.0f - sb->inspring) - 1.0f,
+  };
 
-  /* printf("sb_cf_threads_run spawning %d threads\n", totthread); */
+  /* check conditions for various options */
+  data.do_selfcollision = ((ob->softflag & OB_SB_EDGES) && (sb->bspring) &&
+                           (ob->softflag & OB_SB_SELF));
+  data.do_springcollision = do_deflector && (ob->softflag & OB_SB_EDGES) &&
+                            (ob->softflag & OB_SB_EDGECOLL);
+  data.do_aero = ((sb->aeroedge) && (ob->softflag & OB_SB_EDGES));
 
-  sb_threads = MEM_callocN(sizeof(SB_thread_context) * totthread, "SBThread");
-  memset(sb_threads, 0, sizeof(SB_thread_context) * totthread);
-  left = totpoint;
-  dec = totpoint / totthread + 1;
-  for (i = 0; i < totthread; i++) {
-    sb_threads[i].scene = scene;
-    sb_threads[i].ob = ob;
-    sb_threads[i].forcetime = forcetime;
-    sb_threads[i].timenow = timenow;
-    sb_threads[i].ilast = left;
-    left = left - dec;
-    if (left > 0) {
-      sb_threads[i].ifirst = left;
+  /* The positions are only read while the forces accumulate,
+   * so one grid over the points serves all threads. */
+  if (data.do_selfcollision) {
+    for (int a = 0; a < totpoint; a++) {
+      data.max_colball = max_ff(data.max_colball, sb->bpoint[a].colball);
     }
-    else {
-      sb_threads[i].ifirst = 0;
-    }
-    sb_threads[i].effectors = effectors;
-    sb_threads[i].do_deflector = do_deflector;
-    sb_threads[i].fieldfactor = fieldfactor;
-    sb_threads[i].windfactor = windfactor;
-    sb_threads[i].nr = i;
-    sb_threads[i].tot = totthread;
+    /* Without any collision ball no pair of points can ever be close enough. */
+    data.do_selfcollision = (data.max_colball > 0.0f);
+  }
+  if (data.do_selfcollision) {
+    selfhash = sb_spatial_hash_build(
+        sb->bpoint, sb_body_point_bounds, totpoint, 2.0f * data.max_colball);
+    data.selfhash = selfhash;
   }
 
-  if (totthread > 1) {
-    BLI_threadpool_init(&threads, exec_softbody_calc_forces, totthread);
-
-    for (i = 0; i < totthread; i++) {
-      BLI_threadpool_insert(&threads, &sb_threads[i]);
-    }
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (totpoint > SB_THREADING_LIMIT) && (BKE_scene_num_threads(scene) > 1);
+  BLI_task_parallel_range(0, totpoint, &data, softbody_calc_forces_cb, &settings);
 
-    BLI_threadpool_end(&threads);
-  }
-  else {
-    exec_softbody_calc_forces(&sb_threads[0]);
-  }
-  /* clean up */
-  MEM_freeN(sb_threads);
+  sb_spatial_hash_free(selfhash);
 }
 
 static void softbody_calc_forces(
@@ -2328,160 +2532,201 @@ static void softbody_calc_forces(
   BKE_effectors_free(effectors);
 }
 
-static void softbody_apply_forces(Object *ob, float forcetime, int mode, float *err, int mid_flags)
-{
-  /* time evolution */
-  /* actually does an explicit euler step mode == 0 */
-  /* or heun ~ 2nd order runge-kutta steps, mode 1, 2 */
-  SoftBody *sb = ob->soft; /* is supposed to be there */
-  BodyPoint *bp;
-  float dx[3] = {0}, dv[3], aabbmin[3], aabbmax[3], cm[3] = {0.0f, 0.0f, 0.0f};
-  float timeovermass /*, freezeloc=0.00001f, freezeforce=0.00000000001f*/;
-  float maxerrpos = 0.0f, maxerrvel = 0.0f;
-  int a, fuzzy = 0;
+typedef struct SBApplyForcesData {
+  Object *ob;
+  float forcetime;
+  int mode;
+  int mid_flags;
+} SBApplyForcesData;
 
-  forcetime *= sb_time_scale(ob);
+/* Per thread statistics, joined once all points are integrated. */
+typedef struct SBApplyForcesChunk {
+  float maxerrpos, maxerrvel;
+  float aabbmin[3], aabbmax[3];
+  bool fuzzy;
+} SBApplyForcesChunk;
 
-  aabbmin[0] = aabbmin[1] = aabbmin[2] = 1e20f;
-  aabbmax[0] = aabbmax[1] = aabbmax[2] = -1e20f;
+static void softbody_apply_forces_cb(void *__restrict userdata,
+                                     const int a,
+                                     const TaskParallelTLS *__restrict tls)
+{
+  const SBApplyForcesData *data = userdata;
+  SBApplyForcesChunk *chunk = tls->userdata_chunk;
+  Object *ob = data->ob;
+  SoftBody *sb = ob->soft;
+  BodyPoint *bp = &sb->bpoint[a];
+  const float forcetime = data->forcetime;
+  const int mode = data->mode;
+  const int mid_flags = data->mid_flags;
+  float dx[3] = {0}, dv[3];
+  float timeovermass /*, freezeloc=0.00001f, freezeforce=0.00000000001f*/;
 
-  /* old one with homogeneous masses  */
+  /* Now we have individual masses. */
   /* claim a minimum mass for vertex */
-#if 0
-  if (sb->nodemass > 0.009999f) {
-    timeovermass = forcetime / sb->nodemass;
+  if (_final_mass(ob, bp) > 0.009999f) {
+    timeovermass = forcetime / _final_mass(ob, bp);
   }
   else {
     timeovermass = forcetime / 0.009999f;
   }
-#endif
 
-  for (a = sb->totpoint, bp = sb->bpoint; a > 0; a--, bp++) {
-    /* Now we have individual masses. */
-    /* claim a minimum mass for vertex */
-    if (_final_mass(ob, bp) > 0.009999f) {
-      timeovermass = forcetime / _final_mass(ob, bp);
+  if (_final_goal(ob, bp) < SOFTGOALSNAP) {
+    /* this makes t~ = t */
+    if (mid_flags & MID_PRESERVE) {
+      copy_v3_v3(dx, bp->vec);
+    }
+
+    /**
+     * So here is:
+     * <pre>
+     * (v)' = a(cceleration) =
+     *     sum(F_springs)/m + gravitation + some friction forces + more forces.
+     * </pre>
+     *
+     * The ( ... )' operator denotes derivate respective time.
+     *
+     * The euler step for velocity then becomes:
+     * <pre>
+     * v(t + dt) = v(t) + a(t) * dt
+     * </pre>
+     */
+    mul_v3_fl(bp->force, timeovermass); /* individual mass of node here */
+    /* some nasty if's to have heun in here too */
+    copy_v3_v3(dv, bp->force);
+
+    if (mode == 1) {
+      copy_v3_v3(bp->prevvec, bp->vec);
+      copy_v3_v3(bp->prevdv, dv);
+    }
+
+    if (mode == 2) {
+      /* be optimistic and execute step */
+      bp->vec[0] = bp->prevvec[0] + 0.5f * (dv[0] + bp->prevdv[0]);
+      bp->vec[1] = bp->prevvec[1] + 0.5f * (dv[1] + bp->prevdv[1]);
+      bp->vec[2] = bp->prevvec[2] + 0.5f * (dv[2] + bp->prevdv[2]);
+      /* compare euler to heun to estimate error for step sizing */
+      chunk->maxerrvel = max_ff(chunk->maxerrvel, fabsf(dv[0] - bp->prevdv[0]));
+      chunk->maxerrvel = max_ff(chunk->maxerrvel, fabsf(dv[1] - bp->prevdv[1]));
+      chunk->maxerrvel = max_ff(chunk->maxerrvel, fabsf(dv[2] - bp->prevdv[2]));
     }
     else {
-      timeovermass = forcetime / 0.009999f;
+      add_v3_v3(bp->vec, bp->force);
     }
 
-    if (_final_goal(ob, bp) < SOFTGOALSNAP) {
-      /* this makes t~ = t */
-      if (mid_flags & MID_PRESERVE) {
-        copy_v3_v3(dx, bp->vec);
-      }
-
-      /**
-       * So here is:
-       * <pre>
-       * (v)' = a(cceleration) =
-       *     sum(F_springs)/m + gravitation + some friction forces + more forces.
-       * </pre>
-       *
-       * The ( ... )' operator denotes derivate respective time.
-       *
-       * The euler step for velocity then becomes:
-       * <pre>
-       * v(t + dt) = v(t) + a(t) * dt
-       * </pre>
-       */
-      mul_v3_fl(bp->force, timeovermass); /* individual mass of node here */
-      /* some nasty if's to have heun in here too */
-      copy_v3_v3(dv, bp->force);
-
-      if (mode == 1) {
-        copy_v3_v3(bp->prevvec, bp->vec);
-        copy_v3_v3(bp->prevdv, dv);
-      }
-
-      if (mode == 2) {
-        /* be optimistic and execute step */
-        bp->vec[0] = bp->prevvec[0] + 0.5f * (dv[0] + bp->prevdv[0]);
-        bp->vec[1] = bp->prevvec[1] + 0.5f * (dv[1] + bp->prevdv[1]);
-        bp->vec[2] = bp->prevvec[2] + 0.5f * (dv[2] + bp->prevdv[2]);
-        /* compare euler to heun to estimate error for step sizing */
-        maxerrvel = max_ff(maxerrvel, fabsf(dv[0] - bp->prevdv[0]));
-        maxerrvel = max_ff(maxerrvel, fabsf(dv[1] - bp->prevdv[1]));
-        maxerrvel = max_ff(maxerrvel, fabsf(dv[2] - bp->prevdv[2]));
-      }
-      else {
-        add_v3_v3(bp->vec, bp->force);
-      }
-
-      /* this makes t~ = t+dt */
-      if (!(mid_flags & MID_PRESERVE)) {
-        copy_v3_v3(dx, bp->vec);
-      }
+    /* this makes t~ = t+dt */
+    if (!(mid_flags & MID_PRESERVE)) {
+      copy_v3_v3(dx, bp->vec);
+    }
 
-      /* so here is (x)'= v(elocity) */
-      /* the euler step for location then becomes */
-      /* x(t + dt) = x(t) + v(t~) * dt */
-      mul_v3_fl(dx, forcetime);
+    /* so here is (x)'= v(elocity) */
+    /* the euler step for location then becomes */
+    /* x(t + dt) = x(t) + v(t~) * dt */
+    mul_v3_fl(dx, forcetime);
 
-      /* the freezer coming sooner or later */
+    /* the freezer coming sooner or later */
 #if 0
-      if ((dot_v3v3(dx, dx) < freezeloc) && (dot_v3v3(bp->force, bp->force) < freezeforce)) {
-        bp->frozen /= 2;
-      }
-      else {
-        bp->frozen = min_ff(bp->frozen * 1.05f, 1.0f);
-      }
-      mul_v3_fl(dx, bp->frozen);
+    if ((dot_v3v3(dx, dx) < freezeloc) && (dot_v3v3(bp->force, bp->force) < freezeforce)) {
+      bp->frozen /= 2;
+    }
+    else {
+      bp->frozen = min_ff(bp->frozen * 1.05f, 1.0f);
+    }
+    mul_v3_fl(dx, bp->frozen);
 #endif
-      /* again some nasty if's to have heun in here too */
-      if (mode == 1) {
-        copy_v3_v3(bp->prevpos, bp->pos);
-        copy_v3_v3(bp->prevdx, dx);
-      }
-
-      if (mode == 2) {
-        bp->pos[0] = bp->prevpos[0] + 0.5f * (dx[0] + bp->prevdx[0]);
-        bp->pos[1] = bp->prevpos[1] + 0.5f * (dx[1] + bp->prevdx[1]);
-        bp->pos[2] = bp->prevpos[2] + 0.5f * (dx[2] + bp->prevdx[2]);
-        maxerrpos = max_ff(maxerrpos, fabsf(dx[0] - bp->prevdx[0]));
-        maxerrpos = max_ff(maxerrpos, fabsf(dx[1] - bp->prevdx[1]));
-        maxerrpos = max_ff(maxerrpos, fabsf(dx[2] - bp->prevdx[2]));
-
-        /* bp->choke is set when we need to pull a vertex or edge out of the collider.
-         * the collider object signals to get out by pushing hard. on the other hand
-         * we don't want to end up in deep space so we add some <viscosity>
-         * to balance that out */
-        if (bp->choke2 > 0.0f) {
-          mul_v3_fl(bp->vec, (1.0f - bp->choke2));
-        }
-        if (bp->choke > 0.0f) {
-          mul_v3_fl(bp->vec, (1.0f - bp->choke));
-        }
+    /* again some nasty if's to have heun in here too */
+    if (mode == 1) {
+      copy_v3_v3(bp->prevpos, bp->pos);
+      copy_v3_v3(bp->prevdx, dx);
+    }
+
+    if (mode == 2) {
+      bp->pos[0] = bp->prevpos[0] + 0.5f * (dx[0] + bp->prevdx[0]);
+      bp->pos[1] = bp->prevpos[1] + 0.5f * (dx[1] + bp->prevdx[1]);
+      bp->pos[2] = bp->prevpos[2] + 0.5f * (dx[2] + bp->prevdx[2]);
+      chunk->maxerrpos = max_ff(chunk->maxerrpos, fabsf(dx[0] - bp->prevdx[0]));
+      chunk->maxerrpos = max_ff(chunk->maxerrpos, fabsf(dx[1] - bp->prevdx[1]));
+      chunk->maxerrpos = max_ff(chunk->maxerrpos, fabsf(dx[2] - bp->prevdx[2]));
+
+      /* bp->choke is set when we need to pull a vertex or edge out of the collider.
+       * the collider object signals to get out by pushing hard. on the other hand
+       * we don't want to end up in deep space so we add some <viscosity>
+       * to balance that out */
+      if (bp->choke2 > 0.0f) {
+        mul_v3_fl(bp->vec, (1.0f - bp->choke2));
       }
-      else {
-        add_v3_v3(bp->pos, dx);
+      if (bp->choke > 0.0f) {
+        mul_v3_fl(bp->vec, (1.0f - bp->choke));
       }
-    } /*snap*/
-    /* so while we are looping BPs anyway do statistics on the fly */
-    minmax_v3v3_v3(aabbmin, aabbmax, bp->pos);
-    if (bp->loc_flag & SBF_DOFUZZY) {
-      fuzzy = 1;
     }
-  } /*for*/
+    else {
+      add_v3_v3(bp->pos, dx);
+    }
+  } /*snap*/
+  /* so while we are looping BPs anyway do statistics on the fly */
+  minmax_v3v3_v3(chunk->aabbmin, chunk->aabbmax, bp->pos);
+  if (bp->loc_flag & SBF_DOFUZZY) {
+    chunk->fuzzy = true;
+  }
+}
+
+static void softbody_apply_forces_reduce(const void *__restrict UNUSED(userdata),
+                                         void *__restrict chunk_join,
+                                         void *__restrict chunk)
+{
+  SBApplyForcesChunk *join = chunk_join;
+  const SBApplyForcesChunk *stats = chunk;
+
+  join->maxerrpos = max_ff(join->maxerrpos, stats->maxerrpos);
+  join->maxerrvel = max_ff(join->maxerrvel, stats->maxerrvel);
+  minmax_v3v3_v3(join->aabbmin, join->aabbmax, stats->aabbmin);
+  minmax_v3v3_v3(join->aabbmin, join->aabbmax, stats->aabbmax);
+  join->fuzzy |= stats->fuzzy;
+}
+
+static void softbody_apply_forces(Object *ob, float forcetime, int mode, float *err, int mid_flags)
+{
+  /* time evolution */
+  /* actually does an explicit euler step mode == 0 */
+  /* or heun ~ 2nd order runge-kutta steps, mode 1, 2 */
+  SoftBody *sb = ob->soft; /* is supposed to be there */
+  float cm[3] = {0.0f, 0.0f, 0.0f};
+  SBApplyForcesData data = {
+      .ob = ob,
+      .forcetime = forcetime * sb_time_scale(ob),
+      .mode = mode,
+      .mid_flags = mid_flags,
+  };
+  SBApplyForcesChunk stats = {0};
+
+  stats.aabbmin[0] = stats.aabbmin[1] = stats.aabbmin[2] = 1e20f;
+  stats.aabbmax[0] = stats.aabbmax[1] = stats.aabbmax[2] = -1e20f;
+
+  /* Every point only touches its own state, the error estimate and bounds are reduced. */
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (sb->totpoint > SB_THREADING_LIMIT);
+  settings.userdata_chunk = &stats;
+  settings.userdata_chunk_size = sizeof(stats);
+  settings.func_reduce = softbody_apply_forces_reduce;
+  BLI_task_parallel_range(0, sb->totpoint, &data, softbody_apply_forces_cb, &settings);
 
   if (sb->totpoint) {
     mul_v3_fl(cm, 1.0f / sb->totpoint);
   }
   if (sb->scratch) {
-    copy_v3_v3(sb->scratch->aabbmin, aabbmin);
-    copy_v3_v3(sb->scratch->aabbmax, aabbmax);
+    copy_v3_v3(sb->scratch->aabbmin, stats.aabbmin);
+    copy_v3_v3(sb->scratch->aabbmax, stats.aabbmax);
   }
 
   if (err) { /* so step size will be controlled by biggest difference in slope */
     if (sb->solverflags & SBSO_OLDERR) {
-      *err = max_ff(maxerrpos, maxerrvel);
+      *err = max_ff(stats.maxerrpos, stats.maxerrvel);
     }
     else {
-      *err = maxerrpos;
+      *err = stats.maxerrpos;
     }
-    // printf("EP %f EV %f\n", maxerrpos, maxerrvel);
-    if (fuzzy) {
+    // printf("EP %f EV %f\n", stats.maxerrpos, stats.maxerrvel);
+    if (stats.fuzzy) {
       *err /= sb->fuzzyness;
     }
   }
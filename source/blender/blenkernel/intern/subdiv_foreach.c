@@ -115,9 +115,7 @@ typedef struct SubdivForeachTaskContext {
    *   evaluated and its position on limit is already known.
    */
   BLI_bitmap *coarse_vertices_used_map;
-  /* Bitmap indicating whether edge was used already or not. This includes:
-   * - During context initialization it indicates whether subdivided vertices
-   *   for corresponding edge were already calculated or not.
+  /* Bitmap indicating whether edge was used already or not.
    * - During patch evaluation it indicates whether vertices along this edge
    *   were already evaluated.
    */
@@ -158,78 +156,52 @@ static void subdiv_foreach_tls_free(SubdivForeachTaskContext *ctx, void *tls)
 /** \name Initialization
  * \{ */
 
-/* NOTE: Expects edge map to be zeroed. */
-static void subdiv_foreach_ctx_count(SubdivForeachTaskContext *ctx)
+/* Calculate amount of vertices, edges and polygons which are created by the given coarse
+ * polygon. They are stored in the offset arrays, which are turned into actual offsets later. */
+static void subdiv_foreach_ctx_count_poly_task(void *__restrict userdata,
+                                               const int poly_index,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  /* Reset counters. */
-  ctx->num_subdiv_vertices = 0;
-  ctx->num_subdiv_edges = 0;
-  ctx->num_subdiv_loops = 0;
-  ctx->num_subdiv_polygons = 0;
-  /* Static geometry counters. */
+  SubdivForeachTaskContext *ctx = userdata;
   const int resolution = ctx->settings->resolution;
+  const int resolution_2 = resolution - 2;
+  const int resolution_2_squared = resolution_2 * resolution_2;
   const int no_quad_patch_resolution = ((resolution >> 1) + 1);
+  const int num_irregular_vertices_per_patch = (no_quad_patch_resolution - 2) *
+                                               (no_quad_patch_resolution - 1);
   const int num_subdiv_vertices_per_coarse_edge = resolution - 2;
-  const int num_inner_vertices_per_quad = (resolution - 2) * (resolution - 2);
-  const int num_inner_vertices_per_noquad_patch = (no_quad_patch_resolution - 2) *
-                                                  (no_quad_patch_resolution - 2);
-  const Mesh *coarse_mesh = ctx->coarse_mesh;
-  const MLoop *coarse_mloop = coarse_mesh->mloop;
-  const MPoly *coarse_mpoly = coarse_mesh->mpoly;
-  ctx->num_subdiv_vertices = coarse_mesh->totvert;
-  ctx->num_subdiv_edges = coarse_mesh->totedge * (num_subdiv_vertices_per_coarse_edge + 1);
-  /* Calculate extra vertices and edges created by non-loose geometry. */
-  for (int poly_index = 0; poly_index < coarse_mesh->totpoly; poly_index++) {
-    const MPoly *coarse_poly = &coarse_mpoly[poly_index];
-    const int num_ptex_faces_per_poly = num_ptex_faces_per_poly_get(coarse_poly);
-    for (int corner = 0; corner < coarse_poly->totloop; corner++) {
-      const MLoop *loop = &coarse_mloop[coarse_poly->loopstart + corner];
-      const bool is_edge_used = BLI_BITMAP_TEST_BOOL(ctx->coarse_edges_used_map, loop->e);
-      /* Edges which aren't counted yet. */
-      if (!is_edge_used) {
-        BLI_BITMAP_ENABLE(ctx->coarse_edges_used_map, loop->e);
-        ctx->num_subdiv_vertices += num_subdiv_vertices_per_coarse_edge;
-      }
-    }
-    /* Inner vertices of polygon. */
-    if (num_ptex_faces_per_poly == 1) {
-      ctx->num_subdiv_vertices += num_inner_vertices_per_quad;
-      ctx->num_subdiv_edges += num_edges_per_ptex_face_get(resolution - 2) +
-                               4 * num_subdiv_vertices_per_coarse_edge;
-      ctx->num_subdiv_polygons += num_polys_per_ptex_get(resolution);
-    }
-    else {
-      ctx->num_subdiv_vertices += 1 + num_ptex_faces_per_poly * (no_quad_patch_resolution - 2) +
-                                  num_ptex_faces_per_poly * num_inner_vertices_per_noquad_patch;
-      ctx->num_subdiv_edges += num_ptex_faces_per_poly *
-                               (num_inner_edges_per_ptex_face_get(no_quad_patch_resolution - 1) +
-                                (no_quad_patch_resolution - 2) +
-                                num_subdiv_vertices_per_coarse_edge);
-      if (no_quad_patch_resolution >= 3) {
-        ctx->num_subdiv_edges += coarse_poly->totloop;
-      }
-      ctx->num_subdiv_polygons += num_ptex_faces_per_poly *
-                                  num_polys_per_ptex_get(no_quad_patch_resolution);
-    }
+  const MPoly *coarse_poly = &ctx->coarse_mesh->mpoly[poly_index];
+  const int num_ptex_faces_per_poly = num_ptex_faces_per_poly_get(coarse_poly);
+  int num_vertices, num_edges, num_polygons;
+  if (num_ptex_faces_per_poly == 1) {
+    num_vertices = resolution_2_squared;
+    num_edges = num_edges_per_ptex_face_get(resolution - 2) +
+                4 * num_subdiv_vertices_per_coarse_edge;
+    num_polygons = num_polys_per_ptex_get(resolution);
   }
-  /* Calculate extra vertices created by loose edges. */
-  for (int edge_index = 0; edge_index < coarse_mesh->totedge; edge_index++) {
-    if (!BLI_BITMAP_TEST_BOOL(ctx->coarse_edges_used_map, edge_index)) {
-      ctx->num_subdiv_vertices += num_subdiv_vertices_per_coarse_edge;
+  else {
+    num_vertices = 1 + num_ptex_faces_per_poly * num_irregular_vertices_per_patch;
+    num_edges = num_ptex_faces_per_poly *
+                (num_inner_edges_per_ptex_face_get(no_quad_patch_resolution - 1) +
+                 (no_quad_patch_resolution - 2) + num_subdiv_vertices_per_coarse_edge);
+    if (no_quad_patch_resolution >= 3) {
+      num_edges += coarse_poly->totloop;
     }
+    num_polygons = num_ptex_faces_per_poly * num_polys_per_ptex_get(no_quad_patch_resolution);
   }
-  ctx->num_subdiv_loops = ctx->num_subdiv_polygons * 4;
+  ctx->subdiv_vertex_offset[poly_index] = num_vertices;
+  ctx->subdiv_edge_offset[poly_index] = num_edges;
+  ctx->subdiv_polygon_offset[poly_index] = num_polygons;
 }
 
+/* Initialize offsets of all the geometry in the subdivided mesh, and calculate its total size.
+ *
+ * Every coarse vertex and every coarse edge (no matter whether it is loose or not) creates the
+ * same amount of subdivided vertices and edges, the rest is created by coarse polygons. */
 static void subdiv_foreach_ctx_init_offsets(SubdivForeachTaskContext *ctx)
 {
   const Mesh *coarse_mesh = ctx->coarse_mesh;
   const int resolution = ctx->settings->resolution;
-  const int resolution_2 = resolution - 2;
-  const int resolution_2_squared = resolution_2 * resolution_2;
-  const int no_quad_patch_resolution = ((resolution >> 1) + 1);
-  const int num_irregular_vertices_per_patch = (no_quad_patch_resolution - 2) *
-                                               (no_quad_patch_resolution - 1);
   const int num_subdiv_vertices_per_coarse_edge = resolution - 2;
   const int num_subdiv_edges_per_coarse_edge = resolution - 1;
   /* Constant offsets in arrays. */
@@ -241,33 +213,33 @@ static void subdiv_foreach_ctx_init_offsets(SubdivForeachTaskContext *ctx)
   ctx->edge_inner_offset = ctx->edge_boundary_offset +
                            coarse_mesh->totedge * num_subdiv_edges_per_coarse_edge;
   /* "Indexed" offsets. */
-  const MPoly *coarse_mpoly = coarse_mesh->mpoly;
+  TaskParallelSettings parallel_range_settings;
+  BLI_parallel_range_settings_defaults(&parallel_range_settings);
+  parallel_range_settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0,
+                          coarse_mesh->totpoly,
+                          ctx,
+                          subdiv_foreach_ctx_count_poly_task,
+                          &parallel_range_settings);
   int vertex_offset = 0;
   int edge_offset = 0;
   int polygon_offset = 0;
   for (int poly_index = 0; poly_index < coarse_mesh->totpoly; poly_index++) {
-    const MPoly *coarse_poly = &coarse_mpoly[poly_index];
-    const int num_ptex_faces_per_poly = num_ptex_faces_per_poly_get(coarse_poly);
+    const int num_vertices = ctx->subdiv_vertex_offset[poly_index];
+    const int num_edges = ctx->subdiv_edge_offset[poly_index];
+    const int num_polygons = ctx->subdiv_polygon_offset[poly_index];
     ctx->subdiv_vertex_offset[poly_index] = vertex_offset;
     ctx->subdiv_edge_offset[poly_index] = edge_offset;
     ctx->subdiv_polygon_offset[poly_index] = polygon_offset;
-    if (num_ptex_faces_per_poly == 1) {
-      vertex_offset += resolution_2_squared;
-      edge_offset += num_edges_per_ptex_face_get(resolution - 2) +
-                     4 * num_subdiv_vertices_per_coarse_edge;
-      polygon_offset += num_polys_per_ptex_get(resolution);
-    }
-    else {
-      vertex_offset += 1 + num_ptex_faces_per_poly * num_irregular_vertices_per_patch;
-      edge_offset += num_ptex_faces_per_poly *
-                     (num_inner_edges_per_ptex_face_get(no_quad_patch_resolution - 1) +
-                      (no_quad_patch_resolution - 2) + num_subdiv_vertices_per_coarse_edge);
-      if (no_quad_patch_resolution >= 3) {
-        edge_offset += coarse_poly->totloop;
-      }
-      polygon_offset += num_ptex_faces_per_poly * num_polys_per_ptex_get(no_quad_patch_resolution);
-    }
+    vertex_offset += num_vertices;
+    edge_offset += num_edges;
+    polygon_offset += num_polygons;
   }
+  /* Total size of the subdivided mesh. */
+  ctx->num_subdiv_vertices = ctx->vertices_inner_offset + vertex_offset;
+  ctx->num_subdiv_edges = ctx->edge_inner_offset + edge_offset;
+  ctx->num_subdiv_polygons = polygon_offset;
+  ctx->num_subdiv_loops = ctx->num_subdiv_polygons * 4;
 }
 
 static void subdiv_foreach_ctx_init(Subdiv *subdiv, SubdivForeachTaskContext *ctx)
@@ -282,12 +254,8 @@ static void subdiv_foreach_ctx_init(Subdiv *subdiv, SubdivForeachTaskContext *ct
       coarse_mesh->totpoly, sizeof(*ctx->subdiv_edge_offset), "subdiv_edge_offset");
   ctx->subdiv_polygon_offset = MEM_malloc_arrayN(
       coarse_mesh->totpoly, sizeof(*ctx->subdiv_polygon_offset), "subdiv_edge_offset");
-  /* Initialize all offsets. */
+  /* Initialize all offsets and calculate number of geometry in the result subdivision mesh. */
   subdiv_foreach_ctx_init_offsets(ctx);
-  /* Calculate number of geometry in the result subdivision mesh. */
-  subdiv_foreach_ctx_count(ctx);
-  /* Re-set maps which were used at this step. */
-  BLI_bitmap_set_all(ctx->coarse_edges_used_map, false, coarse_mesh->totedge);
   ctx->face_ptex_offset = BKE_subdiv_face_ptex_offset_get(subdiv);
 }
 
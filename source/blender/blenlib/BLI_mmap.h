@@ -49,6 +49,9 @@ bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length
 
 void *BLI_mmap_get_pointer(BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT;
 
+/* Granularity in which the OS maps files to memory and reads them in. */
+size_t BLI_mmap_page_size(void) ATTR_WARN_UNUSED_RESULT;
+
 void BLI_mmap_free(BLI_mmap_file *file) ATTR_NONNULL(1);
 
 #ifdef __cplusplus
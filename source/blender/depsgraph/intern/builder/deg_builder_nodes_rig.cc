@@ -48,6 +48,7 @@
 #include "DEG_depsgraph_build.h"
 
 #include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_pchanmap.h"
 #include "intern/depsgraph_type.h"
 #include "intern/eval/deg_eval_copy_on_write.h"
 #include "intern/node/deg_node.h"
@@ -223,6 +224,23 @@ void DepsgraphNodeBuilder::build_rig(Object *object, bool is_object_visible)
       OperationCode::POSE_DONE,
       [object_cow](::Depsgraph *depsgraph) { BKE_pose_eval_done(depsgraph, object_cow); });
   op_node->set_as_exit();
+  /* Simple bones are evaluated by a single operation, their own operations are kept as noops, so
+   * that relations to them can still be constructed. */
+  PoseChannelBatch pose_batch;
+  pose_batch.build(object);
+  if (!pose_batch.is_empty()) {
+    add_operation_node(&object->id,
+                       NodeType::EVAL_POSE,
+                       OperationCode::POSE_BONES_BATCH,
+                       [scene_cow, object_cow, pchan_indices = pose_batch.pchan_indices](
+                           ::Depsgraph *depsgraph) {
+                         BKE_pose_eval_bones_batch(depsgraph,
+                                                   scene_cow,
+                                                   object_cow,
+                                                   pchan_indices.data(),
+                                                   static_cast<int>(pchan_indices.size()));
+                       });
+  }
   /* Bones. */
   int pchan_index = 0;
   LISTBASE_FOREACH (bPoseChannel *, pchan, &object->pose->chanbase) {
@@ -231,24 +249,36 @@ void DepsgraphNodeBuilder::build_rig(Object *object, bool is_object_visible)
         &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_LOCAL);
     op_node->set_as_entry();
 
-    add_operation_node(&object->id,
-                       NodeType::BONE,
-                       pchan->name,
-                       OperationCode::BONE_POSE_PARENT,
-                       [scene_cow, object_cow, pchan_index](::Depsgraph *depsgraph) {
-                         BKE_pose_eval_bone(depsgraph, scene_cow, object_cow, pchan_index);
-                       });
+    if (pose_batch.contains(pchan)) {
+      add_operation_node(
+          &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_POSE_PARENT);
+    }
+    else {
+      add_operation_node(&object->id,
+                         NodeType::BONE,
+                         pchan->name,
+                         OperationCode::BONE_POSE_PARENT,
+                         [scene_cow, object_cow, pchan_index](::Depsgraph *depsgraph) {
+                           BKE_pose_eval_bone(depsgraph, scene_cow, object_cow, pchan_index);
+                         });
+    }
 
     /* NOTE: Dedicated noop for easier relationship construction. */
     add_operation_node(&object->id, NodeType::BONE, pchan->name, OperationCode::BONE_READY);
 
-    op_node = add_operation_node(&object->id,
-                                 NodeType::BONE,
-                                 pchan->name,
-                                 OperationCode::BONE_DONE,
-                                 [object_cow, pchan_index](::Depsgraph *depsgraph) {
-                                   BKE_pose_bone_done(depsgraph, object_cow, pchan_index);
-                                 });
+    if (pose_batch.contains(pchan)) {
+      op_node = add_operation_node(
+          &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_DONE);
+    }
+    else {
+      op_node = add_operation_node(&object->id,
+                                   NodeType::BONE,
+                                   pchan->name,
+                                   OperationCode::BONE_DONE,
+                                   [object_cow, pchan_index](::Depsgraph *depsgraph) {
+                                     BKE_pose_bone_done(depsgraph, object_cow, pchan_index);
+                                   });
+    }
 
     /* B-Bone shape computation - the real last step if present. */
     if (check_pchan_has_bbone(object, pchan)) {
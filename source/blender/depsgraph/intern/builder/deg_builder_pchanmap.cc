@@ -26,8 +26,20 @@
 #include <cstdio>
 #include <cstring>
 
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_string.h"
 #include "BLI_utildefines.h"
 
+#include "DNA_action_types.h"
+#include "DNA_anim_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_constraint_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_armature.h"
+
 namespace blender::deg {
 
 /* Debug contents of map */
@@ -69,4 +81,115 @@ bool RootPChanMap::has_common_root(const char *bone1, const char *bone2) const
   return Set<StringRefNull>::Intersects(*bone1_roots, *bone2_roots);
 }
 
+namespace {
+
+void pose_batch_tag_driven_bones(const AnimData *adt, Set<std::string> &r_driven_bones)
+{
+  if (adt == nullptr) {
+    return;
+  }
+  LISTBASE_FOREACH (const FCurve *, fcu, &adt->drivers) {
+    if (fcu->rna_path == nullptr) {
+      continue;
+    }
+    /* Covers both "pose.bones[...]" of the object and "bones[...]" of the armature. */
+    char *bone_name = BLI_str_quoted_substrN(fcu->rna_path, "bones[");
+    if (bone_name != nullptr) {
+      r_driven_bones.add(bone_name);
+      MEM_freeN(bone_name);
+    }
+  }
+}
+
+/* Tag every channel from the solver's owner up to and including the chain root, which is found
+ * the same way as when the solver operations are built. */
+void pose_batch_tag_solver_chain(const bPoseChannel *pchan,
+                                 const bPoseChannel *rootchan,
+                                 Set<const bPoseChannel *> &r_excluded)
+{
+  if (rootchan == nullptr) {
+    return;
+  }
+  for (const bPoseChannel *parchan = pchan; parchan != nullptr; parchan = parchan->parent) {
+    r_excluded.add(parchan);
+    if (parchan == rootchan) {
+      break;
+    }
+  }
+}
+
+}  // namespace
+
+void PoseChannelBatch::build(Object *object)
+{
+  const bArmature *armature = (const bArmature *)object->data;
+  pchan_indices.clear();
+  pchans_.clear();
+  /* Channels which require their own operations. */
+  Set<const bPoseChannel *> excluded;
+  Set<std::string> driven_bones;
+  pose_batch_tag_driven_bones(object->adt, driven_bones);
+  pose_batch_tag_driven_bones(armature->adt, driven_bones);
+  Map<const bPoseChannel *, int> pchan_index_map;
+  int pchan_index = 0;
+  LISTBASE_FOREACH (const bPoseChannel *, pchan, &object->pose->chanbase) {
+    pchan_index_map.add_new(pchan, pchan_index++);
+    if (pchan->constraints.first != nullptr || driven_bones.contains(pchan->name)) {
+      excluded.add(pchan);
+    }
+    LISTBASE_FOREACH (const bConstraint *, con, &pchan->constraints) {
+      if (con->type == CONSTRAINT_TYPE_KINEMATIC) {
+        bKinematicConstraint *data = (bKinematicConstraint *)con->data;
+        pose_batch_tag_solver_chain(
+            pchan,
+            BKE_armature_ik_solver_find_root(const_cast<bPoseChannel *>(pchan), data),
+            excluded);
+      }
+      else if (con->type == CONSTRAINT_TYPE_SPLINEIK) {
+        bSplineIKConstraint *data = (bSplineIKConstraint *)con->data;
+        pose_batch_tag_solver_chain(
+            pchan,
+            BKE_armature_splineik_solver_find_root(const_cast<bPoseChannel *>(pchan), data),
+            excluded);
+      }
+    }
+  }
+  /* Walk every channel up to the root, so that the whole chain is either batched or not, and
+   * parents are added to the batch before their children. */
+  Vector<const bPoseChannel *> chain;
+  LISTBASE_FOREACH (const bPoseChannel *, pchan, &object->pose->chanbase) {
+    chain.clear();
+    bool is_batched = true;
+    for (const bPoseChannel *parchan = pchan; parchan != nullptr; parchan = parchan->parent) {
+      if (excluded.contains(parchan)) {
+        is_batched = false;
+        break;
+      }
+      if (pchans_.contains(parchan)) {
+        break;
+      }
+      chain.append(parchan);
+    }
+    if (!is_batched) {
+      /* None of the visited channels can be batched, avoid walking them again. */
+      excluded.add_multiple(chain);
+      continue;
+    }
+    for (int i = chain.size() - 1; i >= 0; i--) {
+      pchans_.add_new(chain[i]);
+      pchan_indices.append(pchan_index_map.lookup(chain[i]));
+    }
+  }
+}
+
+bool PoseChannelBatch::contains(const bPoseChannel *pchan) const
+{
+  return pchans_.contains(pchan);
+}
+
+bool PoseChannelBatch::is_empty() const
+{
+  return pchan_indices.is_empty();
+}
+
 }  // namespace blender::deg
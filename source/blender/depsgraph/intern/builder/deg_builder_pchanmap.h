@@ -25,6 +25,9 @@
 
 #include "intern/depsgraph_type.h"
 
+struct Object;
+struct bPoseChannel;
+
 namespace blender {
 namespace deg {
 
@@ -46,5 +49,26 @@ struct RootPChanMap {
   Map<StringRefNull, Set<StringRefNull>> map_;
 };
 
+/* Pose channels which are evaluated by a single POSE_BONES_BATCH operation instead of dedicated
+ * per-bone operations.
+ *
+ * A channel is batched when it has no constraints, is not part of an IK or Spline IK chain, is not
+ * driven, and its parent (if any) is batched as well. Such chains only need the parent matrix to
+ * be evaluated, so evaluating them together does not lose any parallelism which matters, but it
+ * saves scheduling of a few operations per bone. */
+struct PoseChannelBatch {
+  /* Fill in the batch from the pose of the given armature object. */
+  void build(Object *object);
+
+  bool contains(const bPoseChannel *pchan) const;
+  bool is_empty() const;
+
+  /* Indices of the channels in the pose channel array, parents go before their children. */
+  Vector<int> pchan_indices;
+
+ protected:
+  Set<const bPoseChannel *> pchans_;
+};
+
 }  // namespace deg
 }  // namespace blender
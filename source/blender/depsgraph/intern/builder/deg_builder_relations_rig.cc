@@ -352,6 +352,11 @@ void DepsgraphRelationBuilder::build_rig(Object *object)
     ComponentKey local_transform_key(&object->id, NodeType::TRANSFORM);
     add_relation(local_transform_key, pose_key, "Local Transforms");
   }
+  /* Simple bones evaluated by a single operation. It goes after local transforms of all batched
+   * bones, and their pose operations (which are noops) go after it. */
+  PoseChannelBatch pose_batch;
+  pose_batch.build(object);
+  OperationKey pose_batch_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_BONES_BATCH);
   /* Links between operations for each bone. */
   LISTBASE_FOREACH (bPoseChannel *, pchan, &object->pose->chanbase) {
     build_idproperties(pchan->prop);
@@ -366,7 +371,13 @@ void DepsgraphRelationBuilder::build_rig(Object *object)
     /* Pose init to bone local. */
     add_relation(pose_init_key, bone_local_key, "Pose Init - Bone Local", RELATION_FLAG_GODMODE);
     /* Local to pose parenting operation. */
-    add_relation(bone_local_key, bone_pose_key, "Bone Local - Bone Pose");
+    if (pose_batch.contains(pchan)) {
+      add_relation(bone_local_key, pose_batch_key, "Bone Local - Bones Batch");
+      add_relation(pose_batch_key, bone_pose_key, "Bones Batch - Bone Pose");
+    }
+    else {
+      add_relation(bone_local_key, bone_pose_key, "Bone Local - Bone Pose");
+    }
     /* Parent relation. */
     if (pchan->parent != nullptr) {
       OperationCode parent_key_opcode;
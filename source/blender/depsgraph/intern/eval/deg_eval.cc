@@ -25,12 +25,15 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+
 #include "PIL_time.h"
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_gsqueue.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_global.h"
 
@@ -68,9 +71,35 @@ void schedule_children(DepsgraphEvalState *state,
                        ScheduleFunction *schedule_function,
                        ScheduleFunctionArgs... schedule_function_args);
 
-void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
+/* Operations which are known to take less time than this (in seconds) are evaluated by the task
+ * which made them ready, instead of paying the overhead of a separate task. */
+constexpr float CHEAP_OPERATION_COST = 5e-6f;
+/* Cost which is assumed for operations which were never evaluated yet. */
+constexpr float UNKNOWN_OPERATION_COST = 1e-4f;
+
+/* Operations which became ready for evaluation. */
+using ReadyOperations = Vector<OperationNode *, 16>;
+
+void schedule_node_to_ready_list(OperationNode *node,
+                                 const int /*thread_id*/,
+                                 ReadyOperations *ready_operations)
+{
+  ready_operations->append(node);
+}
+
+bool is_cheap_operation(const OperationNode *node)
+{
+  return node->eval_cost >= 0.0f && node->eval_cost < CHEAP_OPERATION_COST;
+}
+
+/* Order operations so that the ones on the most expensive path through the graph come first. */
+void sort_ready_operations(ReadyOperations &ready_operations)
 {
-  BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
+  std::sort(ready_operations.begin(),
+            ready_operations.end(),
+            [](const OperationNode *a, const OperationNode *b) {
+              return a->critical_path_cost > b->critical_path_cost;
+            });
 }
 
 /* Denotes which part of dependency graph is being evaluated. */
@@ -103,14 +132,29 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
 
   /* Sanity checks. */
   BLI_assert(!operation_node->is_noop() && "NOOP nodes should not actually be scheduled");
-  /* Perform operation. */
+  /* Perform operation. The timing is always measured, it is used by the scheduler to prioritize
+   * operations and to batch cheap ones. */
+  const double start_time = PIL_check_seconds_timer();
+  operation_node->evaluate(depsgraph);
+  const double time = PIL_check_seconds_timer() - start_time;
   if (state->do_stats) {
-    const double start_time = PIL_check_seconds_timer();
-    operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += PIL_check_seconds_timer() - start_time;
+    operation_node->stats.current_time += time;
+  }
+  /* Operation is only evaluated once per graph evaluation, so there is no concurrent access. */
+  if (operation_node->eval_cost < 0.0f) {
+    operation_node->eval_cost = (float)time;
   }
   else {
-    operation_node->evaluate(depsgraph);
+    operation_node->eval_cost = operation_node->eval_cost * 0.75f + (float)time * 0.25f;
+  }
+}
+
+/* Push operations to the pool, in the order of their priority. */
+void push_ready_operations_to_pool(TaskPool *pool, ReadyOperations &ready_operations)
+{
+  sort_ready_operations(ready_operations);
+  for (OperationNode *operation_node : ready_operations) {
+    BLI_task_pool_push(pool, deg_task_run_func, operation_node, false, nullptr);
   }
 }
 
@@ -119,15 +163,49 @@ void deg_task_run_func(TaskPool *pool, void *taskdata)
   void *userdata_v = BLI_task_pool_user_data(pool);
   DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
 
-  /* Evaluate node. */
-  OperationNode *operation_node = reinterpret_cast<OperationNode *>(taskdata);
-  evaluate_node(state, operation_node);
+  /* Operations which are evaluated by this task, without going through the pool. */
+  ReadyOperations local_operations;
+  ReadyOperations ready_operations;
+  local_operations.append(reinterpret_cast<OperationNode *>(taskdata));
+
+  while (!local_operations.is_empty()) {
+    /* Evaluate the operation with the highest priority first. */
+    int64_t best_index = 0;
+    for (int64_t i = 1; i < local_operations.size(); i++) {
+      if (local_operations[i]->critical_path_cost >
+          local_operations[best_index]->critical_path_cost) {
+        best_index = i;
+      }
+    }
+    OperationNode *operation_node = local_operations[best_index];
+    local_operations.remove_and_reorder(best_index);
+
+    evaluate_node(state, operation_node);
 
-  /* Schedule children. */
-  schedule_children(state, operation_node, schedule_node_to_pool, pool);
+    /* Schedule children. */
+    ready_operations.clear();
+    schedule_children(state, operation_node, schedule_node_to_ready_list, &ready_operations);
+    if (ready_operations.is_empty()) {
+      continue;
+    }
+    sort_ready_operations(ready_operations);
+    /* The most important child is evaluated by this thread, which avoids task overhead and keeps
+     * the data of the parent operation in the cache. Cheap children are batched here as well,
+     * everything else is handed over to other threads. */
+    local_operations.append(ready_operations[0]);
+    for (int64_t i = 1; i < ready_operations.size(); i++) {
+      OperationNode *child = ready_operations[i];
+      if (is_cheap_operation(child)) {
+        local_operations.append(child);
+      }
+      else {
+        BLI_task_pool_push(pool, deg_task_run_func, child, false, nullptr);
+      }
+    }
+  }
 }
 
-bool check_operation_node_visible(OperationNode *op_node)
+bool check_operation_node_visible(const OperationNode *op_node)
 {
   const ComponentNode *comp_node = op_node->owner;
   /* Special exception, copy on write component is to be always evaluated,
@@ -177,10 +255,77 @@ void calculate_pending_parents(Depsgraph *graph)
   }
 }
 
+bool need_evaluate_operation(const OperationNode *node)
+{
+  return check_operation_node_visible(node) && (node->flag & DEPSOP_FLAG_NEEDS_UPDATE);
+}
+
+/* Check whether the relation is to be respected by the scheduler during this evaluation. */
+bool is_evaluated_relation(const Relation *rel)
+{
+  if (rel->from->type != NodeType::OPERATION || rel->to->type != NodeType::OPERATION) {
+    return false;
+  }
+  if (rel->flag & RELATION_FLAG_CYCLIC) {
+    return false;
+  }
+  return need_evaluate_operation((const OperationNode *)rel->from) &&
+         need_evaluate_operation((const OperationNode *)rel->to);
+}
+
+float get_operation_cost(const OperationNode *node)
+{
+  if (node->is_noop()) {
+    return 0.0f;
+  }
+  if (node->eval_cost < 0.0f) {
+    return UNKNOWN_OPERATION_COST;
+  }
+  return node->eval_cost;
+}
+
+/* Calculate critical path cost of all operations which are to be evaluated, using the costs
+ * measured during the previous evaluations. Operations are visited starting from the leaves of
+ * the graph, custom_flags is used to count children which are not visited yet. */
+void calculate_critical_path_costs(Depsgraph *graph)
+{
+  Vector<OperationNode *> queue;
+  for (OperationNode *node : graph->operations) {
+    node->critical_path_cost = 0.0f;
+    node->custom_flags = 0;
+    if (!need_evaluate_operation(node)) {
+      continue;
+    }
+    for (Relation *rel : node->outlinks) {
+      if (is_evaluated_relation(rel)) {
+        ++node->custom_flags;
+      }
+    }
+    if (node->custom_flags == 0) {
+      queue.append(node);
+    }
+  }
+  while (!queue.is_empty()) {
+    OperationNode *node = queue.pop_last();
+    node->critical_path_cost += get_operation_cost(node);
+    for (Relation *rel : node->inlinks) {
+      if (!is_evaluated_relation(rel)) {
+        continue;
+      }
+      OperationNode *from = (OperationNode *)rel->from;
+      from->critical_path_cost = std::max(from->critical_path_cost, node->critical_path_cost);
+      if (--from->custom_flags == 0) {
+        queue.append(from);
+      }
+    }
+  }
+}
+
 void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
   const bool do_stats = state->do_stats;
   calculate_pending_parents(graph);
+  calculate_critical_path_costs(graph);
   /* Clear tags and other things which needs to be clear. */
   for (OperationNode *node : graph->operations) {
     if (do_stats) {
@@ -384,16 +529,20 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
 
   /* Do actual evaluation now. */
   /* First, process all Copy-On-Write nodes. */
+  ReadyOperations ready_operations;
   state.stage = EvaluationStage::COPY_ON_WRITE;
   TaskPool *task_pool = deg_evaluate_task_pool_create(&state);
-  schedule_graph(&state, schedule_node_to_pool, task_pool);
+  schedule_graph(&state, schedule_node_to_ready_list, &ready_operations);
+  push_ready_operations_to_pool(task_pool, ready_operations);
   BLI_task_pool_work_and_wait(task_pool);
   BLI_task_pool_free(task_pool);
 
   /* After that, process all other nodes. */
+  ready_operations.clear();
   state.stage = EvaluationStage::THREADED_EVALUATION;
   task_pool = deg_evaluate_task_pool_create(&state);
-  schedule_graph(&state, schedule_node_to_pool, task_pool);
+  schedule_graph(&state, schedule_node_to_ready_list, &ready_operations);
+  push_ready_operations_to_pool(task_pool, ready_operations);
   BLI_task_pool_work_and_wait(task_pool);
   BLI_task_pool_free(task_pool);
 
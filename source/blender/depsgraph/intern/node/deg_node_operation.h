@@ -126,6 +126,8 @@ enum class OperationCode {
   /* IK/Spline Solvers */
   POSE_IK_SOLVER,
   POSE_SPLINE_IK_SOLVER,
+  /* Combined evaluation of bones which have no constraints and are not in IK chains. */
+  POSE_BONES_BATCH,
 
   /* Bone. ---------------------------------------------------------------- */
   /* Bone local transforms - entry point */
@@ -265,6 +267,13 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Smoothed time in seconds the callback took during previous evaluations.
+   * Negative when the operation was never evaluated yet. */
+  float eval_cost;
+  /* Estimated time needed to evaluate this operation and the most expensive chain of operations
+   * which depends on it. Used to prioritize operations on the critical path of the graph. */
+  float critical_path_cost;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
@@ -31,6 +31,8 @@
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BLT_translation.h"
 
@@ -907,6 +909,8 @@ typedef struct MeshDeformBind {
 
   /* grids */
   MemArena *memarena;
+  /* guards allocations from memarena while tagging boundary cells in parallel */
+  SpinLock memarena_lock;
   MDefBoundIsect *(*boundisect)[6];
   int *semibound;
   int *tag;
@@ -997,44 +1001,60 @@ static void harmonic_ray_callback(void *userdata,
   }
 }
 
-static MDefBoundIsect *meshdeform_ray_tree_intersect(MeshDeformBind *mdb,
-                                                     const float co1[3],
-                                                     const float co2[3])
+/**
+ * Cast a ray from \a co1 to \a co2 against the cage, without allocating anything
+ * so it can be called from multiple threads at once.
+ *
+ * \return the index of the hit looptri or -1.
+ */
+static int meshdeform_ray_tree_cast(MeshDeformBind *mdb,
+                                    const float co1[3],
+                                    const float co2[3],
+                                    MeshDeformIsect *r_isect_mdef)
 {
   BVHTreeRayHit hit;
-  MeshDeformIsect isect_mdef;
   struct MeshRayCallbackData data = {
       mdb,
-      &isect_mdef,
+      r_isect_mdef,
   };
   float end[3], vec_normal[3];
 
   /* happens binding when a cage has no faces */
   if (UNLIKELY(mdb->bvhtree == NULL)) {
-    return NULL;
+    return -1;
   }
 
   /* setup isec */
-  memset(&isect_mdef, 0, sizeof(isect_mdef));
-  isect_mdef.lambda = 1e10f;
+  memset(r_isect_mdef, 0, sizeof(*r_isect_mdef));
+  r_isect_mdef->lambda = 1e10f;
 
-  copy_v3_v3(isect_mdef.start, co1);
+  copy_v3_v3(r_isect_mdef->start, co1);
   copy_v3_v3(end, co2);
-  sub_v3_v3v3(isect_mdef.vec, end, isect_mdef.start);
-  isect_mdef.vec_length = normalize_v3_v3(vec_normal, isect_mdef.vec);
+  sub_v3_v3v3(r_isect_mdef->vec, end, r_isect_mdef->start);
+  r_isect_mdef->vec_length = normalize_v3_v3(vec_normal, r_isect_mdef->vec);
 
   hit.index = -1;
   hit.dist = BVH_RAYCAST_DIST_MAX;
-  if (BLI_bvhtree_ray_cast_ex(mdb->bvhtree,
-                              isect_mdef.start,
-                              vec_normal,
-                              0.0,
-                              &hit,
-                              harmonic_ray_callback,
-                              &data,
-                              BVH_RAYCAST_WATERTIGHT) != -1) {
+  return BLI_bvhtree_ray_cast_ex(mdb->bvhtree,
+                                 r_isect_mdef->start,
+                                 vec_normal,
+                                 0.0,
+                                 &hit,
+                                 harmonic_ray_callback,
+                                 &data,
+                                 BVH_RAYCAST_WATERTIGHT);
+}
+
+static MDefBoundIsect *meshdeform_ray_tree_intersect(MeshDeformBind *mdb,
+                                                     const float co1[3],
+                                                     const float co2[3])
+{
+  MeshDeformIsect isect_mdef;
+  const int hit_index = meshdeform_ray_tree_cast(mdb, co1, co2, &isect_mdef);
+
+  if (hit_index != -1) {
     const MLoop *mloop = mdb->cagemesh_cache.mloop;
-    const MLoopTri *lt = &mdb->cagemesh_cache.looptri[hit.index];
+    const MLoopTri *lt = &mdb->cagemesh_cache.looptri[hit_index];
     const MPoly *mp = &mdb->cagemesh_cache.mpoly[lt->poly];
     const float(*cagecos)[3] = mdb->cagecos;
     const float len = isect_mdef.lambda;
@@ -1043,7 +1063,9 @@ static MDefBoundIsect *meshdeform_ray_tree_intersect(MeshDeformBind *mdb,
     float(*mp_cagecos)[3] = BLI_array_alloca(mp_cagecos, mp->totloop);
 
     /* create MDefBoundIsect, and extra for 'poly_weights[]' */
+    BLI_spin_lock(&mdb->memarena_lock);
     isect = BLI_memarena_alloc(mdb->memarena, sizeof(*isect) + (sizeof(float) * mp->totloop));
+    BLI_spin_unlock(&mdb->memarena_lock);
 
     /* compute intersection coordinate */
     madd_v3_v3v3fl(isect->co, co1, isect_mdef.vec, len);
@@ -1067,9 +1089,9 @@ static MDefBoundIsect *meshdeform_ray_tree_intersect(MeshDeformBind *mdb,
   return NULL;
 }
 
-static int meshdeform_inside_cage(MeshDeformBind *mdb, float *co)
+static int meshdeform_inside_cage(MeshDeformBind *mdb, const float co[3])
 {
-  MDefBoundIsect *isect;
+  MeshDeformIsect isect_mdef;
   float outside[3], start[3], dir[3];
   int i;
 
@@ -1082,8 +1104,7 @@ static int meshdeform_inside_cage(MeshDeformBind *mdb, float *co)
     sub_v3_v3v3(dir, outside, start);
     normalize_v3(dir);
 
-    isect = meshdeform_ray_tree_intersect(mdb, start, outside);
-    if (isect && !isect->facing) {
+    if (meshdeform_ray_tree_cast(mdb, start, outside, &isect_mdef) != -1 && !isect_mdef.isect) {
       return 1;
     }
   }
@@ -1451,10 +1472,121 @@ static void meshdeform_matrix_add_exterior_phi(
   }
 }
 
+/* Threaded passes over the bind data. Grid passes handle one z slice of cells per
+ * iteration, so no two threads ever write the same cell. */
+
+typedef struct MeshDeformBindTaskData {
+  MeshDeformBind *mdb;
+  LinearSolver *context;
+  int cagevert;
+} MeshDeformBindTaskData;
+
+static void meshdeform_inside_cage_cb(void *__restrict userdata,
+                                      const int a,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshDeformBindTaskData *data = userdata;
+  MeshDeformBind *mdb = data->mdb;
+
+  mdb->inside[a] = meshdeform_inside_cage(mdb, mdb->vertexcos[a]);
+}
+
+static void meshdeform_add_intersections_cb(void *__restrict userdata,
+                                            const int z,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshDeformBindTaskData *data = userdata;
+  MeshDeformBind *mdb = data->mdb;
+
+  for (int y = 0; y < mdb->size; y++) {
+    for (int x = 0; x < mdb->size; x++) {
+      meshdeform_add_intersections(mdb, x, y, z);
+    }
+  }
+}
+
+static void meshdeform_matrix_add_rhs_cb(void *__restrict userdata,
+                                         const int z,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshDeformBindTaskData *data = userdata;
+  MeshDeformBind *mdb = data->mdb;
+
+  /* Each cell only adds to its own variable, which is safe once the matrix is built. */
+  for (int y = 0; y < mdb->size; y++) {
+    for (int x = 0; x < mdb->size; x++) {
+      meshdeform_matrix_add_rhs(mdb, data->context, x, y, z, data->cagevert);
+    }
+  }
+}
+
+static void meshdeform_matrix_add_semibound_phi_cb(void *__restrict userdata,
+                                                   const int z,
+                                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshDeformBindTaskData *data = userdata;
+  MeshDeformBind *mdb = data->mdb;
+
+  for (int y = 0; y < mdb->size; y++) {
+    for (int x = 0; x < mdb->size; x++) {
+      meshdeform_matrix_add_semibound_phi(mdb, x, y, z, data->cagevert);
+    }
+  }
+}
+
+static void meshdeform_matrix_add_exterior_phi_cb(void *__restrict userdata,
+                                                  const int z,
+                                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshDeformBindTaskData *data = userdata;
+  MeshDeformBind *mdb = data->mdb;
+
+  /* Only reads semi-bound cells, which are never written here. */
+  for (int y = 0; y < mdb->size; y++) {
+    for (int x = 0; x < mdb->size; x++) {
+      meshdeform_matrix_add_exterior_phi(mdb, x, y, z, data->cagevert);
+    }
+  }
+}
+
+static void meshdeform_matrix_get_phi_cb(void *__restrict userdata,
+                                         const int b,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshDeformBindTaskData *data = userdata;
+  MeshDeformBind *mdb = data->mdb;
+
+  if (mdb->tag[b] != MESHDEFORM_TAG_EXTERIOR) {
+    mdb->phi[b] = EIG_linear_solver_variable_get(data->context, 0, mdb->varidx[b]);
+  }
+  mdb->totalphi[b] += mdb->phi[b];
+}
+
+static void meshdeform_static_weights_cb(void *__restrict userdata,
+                                         const int b,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshDeformBindTaskData *data = userdata;
+  MeshDeformBind *mdb = data->mdb;
+  float vec[3], gridvec[3];
+
+  if (!mdb->inside[b]) {
+    return;
+  }
+
+  copy_v3_v3(vec, mdb->vertexcos[b]);
+  gridvec[0] = (vec[0] - mdb->min[0] - mdb->halfwidth[0]) / mdb->width[0];
+  gridvec[1] = (vec[1] - mdb->min[1] - mdb->halfwidth[1]) / mdb->width[1];
+  gridvec[2] = (vec[2] - mdb->min[2] - mdb->halfwidth[2]) / mdb->width[2];
+
+  mdb->weights[b * mdb->totcagevert + data->cagevert] = meshdeform_interp_w(
+      mdb, gridvec, vec, data->cagevert);
+}
+
 static void meshdeform_matrix_solve(MeshDeformModifierData *mmd, MeshDeformBind *mdb)
 {
   LinearSolver *context;
-  float vec[3], gridvec[3];
+  TaskParallelSettings settings, settings_grid, settings_verts;
   int a, b, x, y, z, totvar;
   char message[256];
 
@@ -1483,53 +1615,41 @@ static void meshdeform_matrix_solve(MeshDeformModifierData *mmd, MeshDeformBind
     }
   }
 
+  /* The matrix is factorized once on the first solve, after that each cage vert only
+   * needs a new right hand side and a back substitution, so the per-cage-vert passes
+   * over the grid and the bound vertices are what is worth spreading over threads. */
+  MeshDeformBindTaskData data = {
+      .mdb = mdb,
+      .context = context,
+  };
+
+  BLI_parallel_range_settings_defaults(&settings_grid);
+  settings_grid.min_iter_per_thread = 1;
+
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 4096;
+
+  BLI_parallel_range_settings_defaults(&settings_verts);
+  settings_verts.min_iter_per_thread = 1024;
+
   /* solve for each cage vert */
   for (a = 0; a < mdb->totcagevert; a++) {
+    data.cagevert = a;
+
     /* fill in right hand side and solve */
-    for (z = 0; z < mdb->size; z++) {
-      for (y = 0; y < mdb->size; y++) {
-        for (x = 0; x < mdb->size; x++) {
-          meshdeform_matrix_add_rhs(mdb, context, x, y, z, a);
-        }
-      }
-    }
+    BLI_task_parallel_range(0, mdb->size, &data, meshdeform_matrix_add_rhs_cb, &settings_grid);
 
     if (EIG_linear_solver_solve(context)) {
-      for (z = 0; z < mdb->size; z++) {
-        for (y = 0; y < mdb->size; y++) {
-          for (x = 0; x < mdb->size; x++) {
-            meshdeform_matrix_add_semibound_phi(mdb, x, y, z, a);
-          }
-        }
-      }
-
-      for (z = 0; z < mdb->size; z++) {
-        for (y = 0; y < mdb->size; y++) {
-          for (x = 0; x < mdb->size; x++) {
-            meshdeform_matrix_add_exterior_phi(mdb, x, y, z, a);
-          }
-        }
-      }
-
-      for (b = 0; b < mdb->size3; b++) {
-        if (mdb->tag[b] != MESHDEFORM_TAG_EXTERIOR) {
-          mdb->phi[b] = EIG_linear_solver_variable_get(context, 0, mdb->varidx[b]);
-        }
-        mdb->totalphi[b] += mdb->phi[b];
-      }
+      BLI_task_parallel_range(
+          0, mdb->size, &data, meshdeform_matrix_add_semibound_phi_cb, &settings_grid);
+      BLI_task_parallel_range(
+          0, mdb->size, &data, meshdeform_matrix_add_exterior_phi_cb, &settings_grid);
+      BLI_task_parallel_range(0, mdb->size3, &data, meshdeform_matrix_get_phi_cb, &settings);
 
       if (mdb->weights) {
         /* static bind : compute weights for each vertex */
-        for (b = 0; b < mdb->totvert; b++) {
-          if (mdb->inside[b]) {
-            copy_v3_v3(vec, mdb->vertexcos[b]);
-            gridvec[0] = (vec[0] - mdb->min[0] - mdb->halfwidth[0]) / mdb->width[0];
-            gridvec[1] = (vec[1] - mdb->min[1] - mdb->halfwidth[1]) / mdb->width[1];
-            gridvec[2] = (vec[2] - mdb->min[2] - mdb->halfwidth[2]) / mdb->width[2];
-
-            mdb->weights[b * mdb->totcagevert + a] = meshdeform_interp_w(mdb, gridvec, vec, a);
-          }
-        }
+        BLI_task_parallel_range(
+            0, mdb->totvert, &data, meshdeform_static_weights_cb, &settings_verts);
       }
       else {
         MDefBindInfluence *inf;
@@ -1584,7 +1704,7 @@ static void harmonic_coordinates_bind(MeshDeformModifierData *mmd, MeshDeformBin
   MDefBindInfluence *inf;
   MDefInfluence *mdinf;
   MDefCell *cell;
-  float center[3], vec[3], maxwidth, totweight;
+  float center[3], maxwidth, totweight;
   int a, b, x, y, z, totinside, offset;
 
   /* compute bounding box of the cage mesh */
@@ -1649,32 +1769,34 @@ static void harmonic_coordinates_bind(MeshDeformModifierData *mmd, MeshDeformBin
 
   progress_bar(0, "Setting up mesh deform system");
 
+  MeshDeformBindTaskData data = {
+      .mdb = mdb,
+  };
+  TaskParallelSettings settings;
+
+  /* the inside test casts six rays per vertex without allocating anything */
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 64;
+  BLI_task_parallel_range(0, mdb->totvert, &data, meshdeform_inside_cage_cb, &settings);
+
   totinside = 0;
   for (a = 0; a < mdb->totvert; a++) {
-    copy_v3_v3(vec, mdb->vertexcos[a]);
-    mdb->inside[a] = meshdeform_inside_cage(mdb, vec);
     if (mdb->inside[a]) {
       totinside++;
     }
   }
 
-  /* free temporary MDefBoundIsects */
-  BLI_memarena_free(mdb->memarena);
-  mdb->memarena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, "harmonic coords arena");
-
   /* start with all cells untyped */
   for (a = 0; a < mdb->size3; a++) {
     mdb->tag[a] = MESHDEFORM_TAG_UNTYPED;
   }
 
   /* detect intersections and tag boundary cells */
-  for (z = 0; z < mdb->size; z++) {
-    for (y = 0; y < mdb->size; y++) {
-      for (x = 0; x < mdb->size; x++) {
-        meshdeform_add_intersections(mdb, x, y, z);
-      }
-    }
-  }
+  BLI_spin_init(&mdb->memarena_lock);
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, mdb->size, &data, meshdeform_add_intersections_cb, &settings);
+  BLI_spin_end(&mdb->memarena_lock);
 
   /* compute exterior and interior tags */
   meshdeform_bind_floodfill(mdb);
@@ -363,6 +363,7 @@ static void dynamicPaint_bakeImageSequence(DynamicPaintBakeJob *job)
   DynamicPaintCanvasSettings *canvas = surface->canvas;
   Scene *input_scene = DEG_get_input_scene(job->depsgraph);
   Scene *scene = job->scene;
+  struct DynamicPaintImageWriter *writer;
   int frame = 1, orig_frame;
   int frames;
 
@@ -387,6 +388,9 @@ static void dynamicPaint_bakeImageSequence(DynamicPaintBakeJob *job)
     return;
   }
 
+  /* Images are saved in the background while the following frames are calculated. */
+  writer = dynamicPaint_imageWriter_new();
+
   /* Loop through selected frames */
   for (frame = surface->start_frame; frame <= surface->end_frame; frame++) {
     /* The first 10% are for createUVSurface... */
@@ -396,7 +400,7 @@ static void dynamicPaint_bakeImageSequence(DynamicPaintBakeJob *job)
     /* If user requested stop, quit baking */
     if (G.is_break) {
       job->success = 0;
-      return;
+      break;
     }
 
     /* Update progress bar */
@@ -408,7 +412,7 @@ static void dynamicPaint_bakeImageSequence(DynamicPaintBakeJob *job)
     ED_update_for_newframe(job->bmain, job->depsgraph);
     if (!dynamicPaint_calculateFrame(surface, job->depsgraph, scene, cObject, frame)) {
       job->success = 0;
-      return;
+      break;
     }
 
     /*
@@ -425,7 +429,7 @@ static void dynamicPaint_bakeImageSequence(DynamicPaintBakeJob *job)
         BLI_path_frame(filename, frame, 4);
 
         /* save image */
-        dynamicPaint_outputSurfaceImage(surface, filename, 0);
+        dynamicPaint_outputSurfaceImage(surface, filename, 0, writer);
       }
       /* secondary output */
       if (surface->flags & MOD_DPAINT_OUT2 && surface->type == MOD_DPAINT_SURFACE_T_PAINT) {
@@ -435,11 +439,17 @@ static void dynamicPaint_bakeImageSequence(DynamicPaintBakeJob *job)
         BLI_path_frame(filename, frame, 4);
 
         /* save image */
-        dynamicPaint_outputSurfaceImage(surface, filename, 1);
+        dynamicPaint_outputSurfaceImage(surface, filename, 1, writer);
       }
     }
   }
 
+  dynamicPaint_imageWriter_free(writer);
+
+  if (!job->success) {
+    return;
+  }
+
   input_scene->r.cfra = orig_frame;
   ED_update_for_newframe(job->bmain, job->depsgraph);
 }
@@ -37,6 +37,14 @@ extern "C" {
 struct ImBuf;
 struct MovieCache;
 
+/* Usage statistics of a single cache since its creation. */
+typedef struct MovieCacheStats {
+  size_t hits;
+  size_t misses;
+  /* Buffers freed by the global memory limiter to make room for other buffers. */
+  size_t evictions;
+} MovieCacheStats;
+
 typedef void (*MovieCacheGetKeyDataFP)(void *userkey, int *framenr, int *proxy, int *render_flags);
 
 typedef void *(*MovieCacheGetPriorityDataFP)(void *userkey);
@@ -70,6 +78,8 @@ void IMB_moviecache_cleanup(struct MovieCache *cache,
                                                    void *userdata),
                             void *userdata);
 
+void IMB_moviecache_get_stats(struct MovieCache *cache, MovieCacheStats *r_stats);
+
 void IMB_moviecache_get_cache_segments(
     struct MovieCache *cache, int proxy, int render_flags, int *r_totseg, int **r_points);
 
@@ -1507,6 +1507,29 @@ static void display_buffer_init_handle(void *handle_v,
   handle->float_colorspace = init_data->float_colorspace;
 }
 
+/* Convert a chunk of the display buffer to scene linear. Uses the processor cached on the
+ * color space instead of creating a new OCIO processor for every chunk of every update. */
+static void display_buffer_to_scene_linear(float *buffer,
+                                           int width,
+                                           int height,
+                                           int channels,
+                                           const char *from_colorspace,
+                                           bool predivide)
+{
+  if (from_colorspace == NULL || from_colorspace[0] == '\0' ||
+      STREQ(from_colorspace, global_role_scene_linear)) {
+    return;
+  }
+
+  ColorSpace *colorspace = colormanage_colorspace_get_named(from_colorspace);
+  if (colorspace == NULL) {
+    return;
+  }
+
+  IMB_colormanagement_colorspace_to_scene_linear(
+      buffer, width, height, channels, colorspace, predivide);
+}
+
 static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
                                                    int height,
                                                    float *linear_buffer,
@@ -1525,7 +1548,6 @@ static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
     unsigned char *byte_buffer = handle->byte_buffer;
 
     const char *from_colorspace = handle->byte_colorspace;
-    const char *to_colorspace = global_role_scene_linear;
 
     float *fp;
     unsigned char *cp;
@@ -1548,8 +1570,8 @@ static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
 
     if (!is_data && !is_data_display) {
       /* convert float buffer to scene linear space */
-      IMB_colormanagement_transform(
-          linear_buffer, width, height, channels, from_colorspace, to_colorspace, false);
+      display_buffer_to_scene_linear(
+          linear_buffer, width, height, channels, from_colorspace, false);
     }
 
     *is_straight_alpha = true;
@@ -1562,13 +1584,12 @@ static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
      */
 
     const char *from_colorspace = handle->float_colorspace;
-    const char *to_colorspace = global_role_scene_linear;
 
     memcpy(linear_buffer, handle->buffer, buffer_size * sizeof(float));
 
     if (!is_data && !is_data_display) {
-      IMB_colormanagement_transform(
-          linear_buffer, width, height, channels, from_colorspace, to_colorspace, predivide);
+      display_buffer_to_scene_linear(
+          linear_buffer, width, height, channels, from_colorspace, predivide);
     }
 
     *is_straight_alpha = false;
@@ -3914,15 +3935,20 @@ void IMB_colormanagement_processor_apply_byte(
    * but for now it's not so important.
    */
   BLI_assert(channels == 4);
-  float pixel[4];
+
+  /* Convert a scanline at a time, so OCIO processes whole rows rather than single pixels. */
+  float *row = MEM_mallocN(sizeof(float[4]) * width, "colormanagement byte row");
   for (int y = 0; y < height; y++) {
+    unsigned char *row_buffer = buffer + channels * ((size_t)y) * width;
+    for (int x = 0; x < width; x++) {
+      rgba_uchar_to_float(row + 4 * x, row_buffer + channels * x);
+    }
+    IMB_colormanagement_processor_apply(cm_processor, row, width, 1, 4, false);
     for (int x = 0; x < width; x++) {
-      size_t offset = channels * (((size_t)y) * width + x);
-      rgba_uchar_to_float(pixel, buffer + offset);
-      IMB_colormanagement_processor_apply_v4(cm_processor, pixel);
-      rgba_float_to_uchar(buffer + offset, pixel);
+      rgba_float_to_uchar(row_buffer + channels * x, row + 4 * x);
     }
   }
+  MEM_freeN(row);
 }
 
 void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
@@ -30,6 +30,7 @@
 #include "BLI_math.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 #ifdef _WIN32
@@ -879,6 +880,19 @@ static void index_rebuild_ffmpeg_finish(FFmpegIndexBuilderContext *context, int
   MEM_freeN(context);
 }
 
+typedef struct ProxyOutputTaskData {
+  FFmpegIndexBuilderContext *context;
+  AVFrame *in_frame;
+} ProxyOutputTaskData;
+
+static void index_rebuild_ffmpeg_proxy_output_task(void *__restrict userdata,
+                                                   const int i,
+                                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ProxyOutputTaskData *data = userdata;
+  add_to_proxy_output_ffmpeg(data->context->proxy_ctx[i], data->in_frame);
+}
+
 static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *context,
                                                     AVPacket *curr_packet,
                                                     AVFrame *in_frame)
@@ -888,9 +902,21 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
   uint64_t s_dts = context->seek_pos_dts;
   uint64_t pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
 
+  /* The frame is decoded once, every proxy size has its own scaler and encoder so they can be
+   * fed in parallel. */
+  ProxyOutputTaskData data = {
+      .context = context,
+      .in_frame = in_frame,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  int num_outputs = 0;
   for (i = 0; i < context->num_proxy_sizes; i++) {
-    add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+    num_outputs += (context->proxy_ctx[i] != NULL);
   }
+  settings.use_threading = (num_outputs > 1);
+  BLI_task_parallel_range(
+      0, context->num_proxy_sizes, &data, index_rebuild_ffmpeg_proxy_output_task, &settings);
 
   if (!context->start_pts_set) {
     context->start_pts = pts;
@@ -29,6 +29,8 @@
 #include "MEM_CacheLimiterC-Api.h"
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_ghash.h"
 #include "BLI_mempool.h"
 #include "BLI_string.h"
@@ -75,6 +77,9 @@ typedef struct MovieCache {
 
   int totseg, *points, proxy, render_flags; /* for visual statistics optimization */
   int pad;
+
+  /* Usage statistics, updated atomically since lookups are not done under #limitor_lock. */
+  size_t hits, misses, evictions;
 } MovieCache;
 
 typedef struct MovieCacheKey {
@@ -178,6 +183,8 @@ static void IMB_moviecache_destructor(void *p)
     item->ibuf = NULL;
     item->c_handle = NULL;
 
+    atomic_add_and_fetch_z(&cache->evictions, 1);
+
     /* force cached segments to be updated */
     if (cache->points) {
       MEM_freeN(cache->points);
@@ -412,10 +419,14 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
 
       IMB_refImBuf(item->ibuf);
 
+      atomic_add_and_fetch_z(&cache->hits, 1);
+
       return item->ibuf;
     }
   }
 
+  atomic_add_and_fetch_z(&cache->misses, 1);
+
   return NULL;
 }
 
@@ -476,6 +487,13 @@ void IMB_moviecache_cleanup(MovieCache *cache,
   }
 }
 
+void IMB_moviecache_get_stats(MovieCache *cache, MovieCacheStats *r_stats)
+{
+  r_stats->hits = cache->hits;
+  r_stats->misses = cache->misses;
+  r_stats->evictions = cache->evictions;
+}
+
 /* get segments of cached frames. useful for debugging cache policies */
 void IMB_moviecache_get_cache_segments(
     MovieCache *cache, int proxy, int render_flags, int *r_totseg, int **r_points)
@@ -22,6 +22,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cstddef>
 #include <cstdio>
@@ -78,6 +79,7 @@ _CRTIMP void __cdecl _invalid_parameter_noinfo(void)
 }
 #include "BLI_blenlib.h"
 #include "BLI_math_color.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_idprop.h"
@@ -1205,6 +1207,96 @@ void IMB_exrtile_write_channels(
   }
 }
 
+/* Read the channels of a single part that have a rect set. Parts without any such channel are
+ * skipped entirely. Returns false on error. */
+static bool imb_exr_read_part(ExrHandle *data, const int part, const bool flip)
+{
+  /* Read part header. */
+  InputPart in(*data->ifile, part);
+  Header header = in.header();
+  Box2i dw = header.dataWindow();
+
+  /* Insert all requested channels of the part into frame-buffer. */
+  FrameBuffer frameBuffer;
+  ExrChannel *echan;
+  int totchannel = 0;
+
+  for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
+    if (echan->m->part_number != part) {
+      continue;
+    }
+
+    exr_printf("%d %-6s %-22s \"%s\"\n",
+               echan->m->part_number,
+               echan->m->view.c_str(),
+               echan->m->name.c_str(),
+               echan->m->internal_name.c_str());
+
+    if (echan->rect) {
+      float *rect = echan->rect;
+      size_t xstride = echan->xstride * sizeof(float);
+      size_t ystride = echan->ystride * sizeof(float);
+
+      if (!flip) {
+        /* Inverse correct first pixel for data-window coordinates. */
+        rect -= echan->xstride * (dw.min.x - dw.min.y * data->width);
+        /* move to last scanline to flip to Blender convention */
+        rect += echan->xstride * (data->height - 1) * data->width;
+        ystride = -ystride;
+      }
+      else {
+        /* Inverse correct first pixel for data-window coordinates. */
+        rect -= echan->xstride * (dw.min.x + dw.min.y * data->width);
+      }
+
+      frameBuffer.insert(echan->m->internal_name,
+                         Slice(Imf::FLOAT, (char *)rect, xstride, ystride));
+      totchannel++;
+    }
+  }
+
+  /* Nothing requested from this part, don't read and decompress its pixels. */
+  if (totchannel == 0) {
+    return true;
+  }
+
+  /* Read pixels. Scan-line chunks hold all channels of the part, so those still have to be
+   * decompressed, but only requested channels are converted into rects. */
+  try {
+    in.setFrameBuffer(frameBuffer);
+    exr_printf("readPixels:readPixels[%d]: min.y: %d, max.y: %d\n", part, dw.min.y, dw.max.y);
+    in.readPixels(dw.min.y, dw.max.y);
+  }
+  catch (const std::exception &exc) {
+    std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+struct ExrReadPartsData {
+  ExrHandle *data;
+  bool flip;
+  /* Set when reading a part failed, the remaining parts are skipped then. */
+  std::atomic<bool> failed;
+};
+
+static void imb_exr_read_part_task(void *__restrict userdata,
+                                   const int part,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ExrReadPartsData *parts_data = (ExrReadPartsData *)userdata;
+  if (parts_data->failed) {
+    return;
+  }
+  if (!imb_exr_read_part(parts_data->data, part, parts_data->flip)) {
+    parts_data->failed = true;
+  }
+}
+
+/* Only channels with a rect, as set by #IMB_exr_set_channel or when reading a multi-layer file
+ * from memory, are read. */
 void IMB_exr_read_channels(void *handle)
 {
   ExrHandle *data = (ExrHandle *)handle;
@@ -1225,63 +1317,21 @@ void IMB_exr_read_channels(void *handle)
       "name",
       "internal_name");
 
-  for (int i = 0; i < numparts; i++) {
-    /* Read part header. */
-    InputPart in(*data->ifile, i);
-    Header header = in.header();
-    Box2i dw = header.dataWindow();
-
-    /* Insert all matching channel into frame-buffer. */
-    FrameBuffer frameBuffer;
-    ExrChannel *echan;
-
-    for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
-      if (echan->m->part_number != i) {
-        continue;
-      }
-
-      exr_printf("%d %-6s %-22s \"%s\"\n",
-                 echan->m->part_number,
-                 echan->m->view.c_str(),
-                 echan->m->name.c_str(),
-                 echan->m->internal_name.c_str());
-
-      if (echan->rect) {
-        float *rect = echan->rect;
-        size_t xstride = echan->xstride * sizeof(float);
-        size_t ystride = echan->ystride * sizeof(float);
-
-        if (!flip) {
-          /* Inverse correct first pixel for data-window coordinates. */
-          rect -= echan->xstride * (dw.min.x - dw.min.y * data->width);
-          /* move to last scanline to flip to Blender convention */
-          rect += echan->xstride * (data->height - 1) * data->width;
-          ystride = -ystride;
-        }
-        else {
-          /* Inverse correct first pixel for data-window coordinates. */
-          rect -= echan->xstride * (dw.min.x + dw.min.y * data->width);
-        }
-
-        frameBuffer.insert(echan->m->internal_name,
-                           Slice(Imf::FLOAT, (char *)rect, xstride, ystride));
-      }
-      else {
-        printf("warning, channel with no rect set %s\n", echan->m->internal_name.c_str());
-      }
-    }
-
-    /* Read pixels. */
-    try {
-      in.setFrameBuffer(frameBuffer);
-      exr_printf("readPixels:readPixels[%d]: min.y: %d, max.y: %d\n", i, dw.min.y, dw.max.y);
-      in.readPixels(dw.min.y, dw.max.y);
-    }
-    catch (const std::exception &exc) {
-      std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
-      break;
-    }
+  if (numparts == 1) {
+    imb_exr_read_part(data, 0, flip);
+    return;
   }
+
+  /* Multi-part files (one part per view or per layer, as written by other applications) are
+   * read part-parallel. Parts share the input stream, which OpenEXR guards internally, while
+   * decompression of every part still runs on the OpenEXR thread pool. */
+  ExrReadPartsData parts_data;
+  parts_data.data = data;
+  parts_data.flip = flip != 0;
+  parts_data.failed = false;
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, numparts, &parts_data, imb_exr_read_part_task, &settings);
 }
 
 void IMB_exr_multilayer_convert(void *handle,
@@ -24,8 +24,11 @@
 
 #include <math.h>
 
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
 #include "BLI_math_interp.h"
+#include "BLI_math_vector.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "MEM_guardedalloc.h"
 
@@ -1615,6 +1618,221 @@ static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
   }
 }
 
+/* ******** one-pass area downscaling ******** */
+
+/* Per-axis filter footprint of a box (area) filter: every destination pixel covers a run of
+ * source pixels, the first and last of which may only be partially covered. */
+typedef struct ScaleDownAxis {
+  /* First source pixel and number of source pixels contributing to each destination pixel. */
+  int *start;
+  int *len;
+  /* Normalized coverage weights, `max_len` entries per destination pixel. */
+  float *weights;
+  int max_len;
+} ScaleDownAxis;
+
+static void scaledown_axis_init(ScaleDownAxis *axis, int src_len, int dst_len)
+{
+  const double scale = (double)src_len / dst_len;
+
+  axis->max_len = (int)ceil(scale) + 1;
+  axis->start = MEM_mallocN(sizeof(int) * dst_len, "scaledown axis start");
+  axis->len = MEM_mallocN(sizeof(int) * dst_len, "scaledown axis len");
+  axis->weights = MEM_mallocN(sizeof(float) * dst_len * axis->max_len, "scaledown axis weights");
+
+  for (int i = 0; i < dst_len; i++) {
+    const double f_start = i * scale;
+    const double f_end = min_dd((i + 1) * scale, src_len);
+    const int start = (int)f_start;
+    const int end = min_ii((int)ceil(f_end), src_len);
+    float *weights = axis->weights + (size_t)i * axis->max_len;
+    double total = 0.0;
+    int len = 0;
+
+    for (int j = start; j < end; j++) {
+      const double w = min_dd(j + 1, f_end) - max_dd(j, f_start);
+      weights[len++] = (float)w;
+      total += w;
+    }
+    BLI_assert(len > 0 && len <= axis->max_len);
+
+    for (int j = 0; j < len; j++) {
+      weights[j] = (float)(weights[j] / total);
+    }
+
+    axis->start[i] = start;
+    axis->len[i] = len;
+  }
+}
+
+static void scaledown_axis_free(ScaleDownAxis *axis)
+{
+  MEM_freeN(axis->start);
+  MEM_freeN(axis->len);
+  MEM_freeN(axis->weights);
+}
+
+typedef struct ScaleDownData {
+  const ImBuf *ibuf;
+  int newx;
+
+  ScaleDownAxis axis_x;
+  ScaleDownAxis axis_y;
+
+  uchar *byte_buffer;
+  float *float_buffer;
+} ScaleDownData;
+
+typedef struct ScaleDownTLS {
+  /* Float accumulation row for the byte buffer, allocated on first use by each thread. */
+  float *row;
+} ScaleDownTLS;
+
+static void scaledown_area_row(void *__restrict userdata,
+                               const int y,
+                               const TaskParallelTLS *__restrict tls)
+{
+  ScaleDownData *data = userdata;
+  ScaleDownTLS *tls_data = tls->userdata_chunk;
+  const ImBuf *ibuf = data->ibuf;
+  const ScaleDownAxis *axis_x = &data->axis_x;
+  const ScaleDownAxis *axis_y = &data->axis_y;
+  const int newx = data->newx;
+  const int ystart = axis_y->start[y];
+  const int ylen = axis_y->len[y];
+  const float *weights_y = axis_y->weights + (size_t)y * axis_y->max_len;
+
+  if (data->byte_buffer) {
+    if (tls_data->row == NULL) {
+      tls_data->row = MEM_mallocN(sizeof(float[4]) * newx, "scaledown row");
+    }
+    float *row = tls_data->row;
+    memset(row, 0, sizeof(float[4]) * newx);
+
+    for (int j = 0; j < ylen; j++) {
+      const uchar *src_row = (const uchar *)ibuf->rect + (size_t)(ystart + j) * ibuf->x * 4;
+      const float weight_y = weights_y[j];
+
+      for (int x = 0; x < newx; x++) {
+        const uchar *src = src_row + (size_t)axis_x->start[x] * 4;
+        const float *weights_x = axis_x->weights + (size_t)x * axis_x->max_len;
+        const int xlen = axis_x->len[x];
+        float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+        for (int i = 0; i < xlen; i++, src += 4) {
+          const float w = weights_x[i];
+          acc[0] += w * src[0];
+          acc[1] += w * src[1];
+          acc[2] += w * src[2];
+          acc[3] += w * src[3];
+        }
+        madd_v4_v4fl(row + x * 4, acc, weight_y);
+      }
+    }
+
+    uchar *dst = data->byte_buffer + (size_t)y * newx * 4;
+    for (int i = 0; i < newx * 4; i++) {
+      dst[i] = round_fl_to_uchar_clamp(row[i]);
+    }
+  }
+
+  if (data->float_buffer) {
+    /* Accumulate straight into the destination row. */
+    float *dst = data->float_buffer + (size_t)y * newx * 4;
+    memset(dst, 0, sizeof(float[4]) * newx);
+
+    for (int j = 0; j < ylen; j++) {
+      const float *src_row = ibuf->rect_float + (size_t)(ystart + j) * ibuf->x * 4;
+      const float weight_y = weights_y[j];
+
+      for (int x = 0; x < newx; x++) {
+        const float *src = src_row + (size_t)axis_x->start[x] * 4;
+        const float *weights_x = axis_x->weights + (size_t)x * axis_x->max_len;
+        const int xlen = axis_x->len[x];
+        float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+        for (int i = 0; i < xlen; i++, src += 4) {
+          madd_v4_v4fl(acc, src, weights_x[i]);
+        }
+        madd_v4_v4fl(dst + x * 4, acc, weight_y);
+      }
+    }
+  }
+}
+
+static void scaledown_area_free(const void *__restrict UNUSED(userdata), void *__restrict chunk)
+{
+  ScaleDownTLS *tls_data = chunk;
+  MEM_SAFE_FREE(tls_data->row);
+}
+
+/**
+ * Shrink both axes in a single multi-threaded pass using the same area filter as #scaledownx
+ * and #scaledowny, without the intermediate buffer and without rounding intermediate byte values.
+ *
+ * Returns false when the buffer layout is not supported, the caller then falls back to the
+ * separate passes.
+ */
+static bool scaledown_area(struct ImBuf *ibuf, int newx, int newy)
+{
+  const bool do_rect = (ibuf->rect != NULL);
+  const bool do_float = (ibuf->rect_float != NULL);
+
+  if (do_float && ibuf->channels != 4) {
+    return false;
+  }
+
+  ScaleDownData data = {
+      .ibuf = ibuf,
+      .newx = newx,
+  };
+
+  if (do_rect) {
+    data.byte_buffer = MEM_mallocN(sizeof(uchar[4]) * newx * newy, "scaledown area");
+    if (data.byte_buffer == NULL) {
+      return false;
+    }
+  }
+  if (do_float) {
+    data.float_buffer = MEM_mallocN(sizeof(float[4]) * newx * newy, "scaledown area f");
+    if (data.float_buffer == NULL) {
+      MEM_SAFE_FREE(data.byte_buffer);
+      return false;
+    }
+  }
+
+  scaledown_axis_init(&data.axis_x, ibuf->x, newx);
+  scaledown_axis_init(&data.axis_y, ibuf->y, newy);
+
+  ScaleDownTLS tls_data = {NULL};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = ((size_t)ibuf->x * ibuf->y >= 256 * 256);
+  settings.min_iter_per_thread = 8;
+  settings.userdata_chunk = &tls_data;
+  settings.userdata_chunk_size = sizeof(tls_data);
+  settings.func_free = scaledown_area_free;
+  BLI_task_parallel_range(0, newy, &data, scaledown_area_row, &settings);
+
+  scaledown_axis_free(&data.axis_x);
+  scaledown_axis_free(&data.axis_y);
+
+  if (do_rect) {
+    imb_freerectImBuf(ibuf);
+    ibuf->mall |= IB_rect;
+    ibuf->rect = (unsigned int *)data.byte_buffer;
+  }
+  if (do_float) {
+    imb_freerectfloatImBuf(ibuf);
+    ibuf->mall |= IB_rectfloat;
+    ibuf->rect_float = data.float_buffer;
+  }
+
+  ibuf->x = newx;
+  ibuf->y = newy;
+  return true;
+}
+
 /**
  * Return true if \a ibuf is modified.
  */
@@ -1641,6 +1859,12 @@ bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
     return true;
   }
 
+  /* Shrinking both axes is by far the most common case (thumbnails, proxies, texture limits),
+   * do it in one threaded pass. */
+  if (newx && newy && (newx < ibuf->x) && (newy < ibuf->y) && scaledown_area(ibuf, newx, newy)) {
+    return true;
+  }
+
   if (newx && (newx < ibuf->x)) {
     scaledownx(ibuf, newx);
   }
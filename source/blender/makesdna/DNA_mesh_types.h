@@ -127,6 +127,11 @@ typedef struct Mesh_Runtime {
   /** Needed in case we need to lazily initialize the mesh. */
   CustomData_MeshMasks cd_mask_extra;
 
+  /**
+   * Unique value assigned whenever the mesh data is created or copied, including copy-on-write
+   * updates. Lets caches detect a changed input without looking at the data.
+   */
+  uint64_t data_stamp;
 } Mesh_Runtime;
 
 typedef struct Mesh {
@@ -148,6 +148,11 @@ typedef enum {
    * Only one modifier on an object should have this flag set.
    */
   eModifierFlag_Active = (1 << 2),
+  /**
+   * Keep the result of this modifier in the evaluated object, so editing modifiers further
+   * down the stack doesn't have to evaluate it again.
+   */
+  eModifierFlag_CacheOutput = (1 << 3),
 } ModifierFlag;
 
 /* not a real modifier */
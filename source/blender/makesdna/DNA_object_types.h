@@ -49,6 +49,7 @@ struct GeometrySet;
 struct Ipo;
 struct Material;
 struct Mesh;
+struct MeshModifierStackCache;
 struct Object;
 struct PartDeflect;
 struct Path;
@@ -174,6 +175,12 @@ typedef struct Object_Runtime {
    */
   void *geometry_set_previews;
 
+  /**
+   * Results of modifiers that cache their output (#eModifierFlag_CacheOutput),
+   * kept between evaluations of the modifier stack.
+   */
+  struct MeshModifierStackCache *modifier_stack_cache;
+
   /**
    * Mesh structure created during object evaluation.
    * It has deformation only modifiers applied on it.
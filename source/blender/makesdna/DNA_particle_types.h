@@ -356,7 +356,8 @@ typedef struct ParticleSystem {
 
   /** Used for instancing. */
   float imat[4][4];
-  float cfra, tree_frame, bvhtree_frame;
+  float cfra, bvhtree_frame;
+  char _pad2[4];
   int seed, child_seed;
   int flag, totpart, totunexist, totchild, totcached, totchildcache;
   /* NOTE: Recalc is one of ID_RECALC_PSYS_ALL flags.
@@ -384,8 +385,6 @@ typedef struct ParticleSystem {
   ParticleSpring *fluid_springs;
   int tot_fluidsprings, alloc_fluidsprings;
 
-  /** Used for interactions with self and other systems. */
-  struct KDTree_3d *tree;
   /** Used for interactions with self and other systems. */
   struct BVHTree *bvhtree;
 
@@ -561,6 +561,35 @@ static void rna_def_cloth_solver_result(BlenderRNA *brna)
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
   RNA_def_property_ui_text(prop, "Average Iterations", "Average iterations during substeps");
 
+  prop = RNA_def_property(srna, "self_collision_builds", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "selfcol_builds");
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Self Collision Builds",
+                           "Number of substeps in which self collision pairs were searched");
+
+  prop = RNA_def_property(srna, "self_collision_reuses", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "selfcol_reuses");
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop,
+      "Self Collision Reuses",
+      "Number of substeps in which self collision pairs of a previous substep were reused");
+
+  prop = RNA_def_property(srna, "self_collision_max_pairs", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "selfcol_max_pairs");
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Self Collision Maximum Pairs",
+                           "Maximum number of triangle pairs tested for self collision");
+
+  prop = RNA_def_property(srna, "self_collision_max_contacts", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "selfcol_max_contacts");
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Self Collision Maximum Contacts",
+                           "Maximum number of colliding triangle pairs during substeps");
+
   RNA_define_verify_sdna(1);
 }
 
@@ -71,6 +71,7 @@ static const EnumPropertyItem image_source_items[] = {
 
 #  include "IMB_imbuf.h"
 #  include "IMB_imbuf_types.h"
+#  include "IMB_moviecache.h"
 
 #  include "ED_node.h"
 
@@ -406,6 +407,30 @@ static void rna_Image_resolution_set(PointerRNA *ptr, const float *values)
   BKE_image_release_ibuf(im, ibuf, lock);
 }
 
+static int rna_Image_cache_hits_get(PointerRNA *ptr)
+{
+  Image *image = (Image *)ptr->owner_id;
+  MovieCacheStats stats;
+  BKE_image_get_cache_stats(image, &stats);
+  return (int)MIN2(stats.hits, INT_MAX);
+}
+
+static int rna_Image_cache_misses_get(PointerRNA *ptr)
+{
+  Image *image = (Image *)ptr->owner_id;
+  MovieCacheStats stats;
+  BKE_image_get_cache_stats(image, &stats);
+  return (int)MIN2(stats.misses, INT_MAX);
+}
+
+static int rna_Image_cache_evictions_get(PointerRNA *ptr)
+{
+  Image *image = (Image *)ptr->owner_id;
+  MovieCacheStats stats;
+  BKE_image_get_cache_stats(image, &stats);
+  return (int)MIN2(stats.evictions, INT_MAX);
+}
+
 static int rna_Image_bindcode_get(PointerRNA *ptr)
 {
   Image *ima = (Image *)ptr->data;
@@ -1080,6 +1105,26 @@ static void rna_def_image(BlenderRNA *brna)
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
   RNA_def_property_ui_text(prop, "Has Data", "True if the image data is loaded into memory");
 
+  prop = RNA_def_property(srna, "cache_hits", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_Image_cache_hits_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Cache Hits", "Number of image buffer lookups found in the cache");
+
+  prop = RNA_def_property(srna, "cache_misses", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_Image_cache_misses_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Cache Misses", "Number of image buffer lookups which were not in the cache");
+
+  prop = RNA_def_property(srna, "cache_evictions", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_Image_cache_evictions_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop,
+      "Cache Evictions",
+      "Number of image buffers freed from the cache to stay within the memory cache limit");
+
   prop = RNA_def_property(srna, "depth", PROP_INT, PROP_UNSIGNED);
   RNA_def_property_int_funcs(prop, "rna_Image_depth_get", NULL, NULL);
   RNA_def_property_ui_text(prop, "Depth", "Image bit depth");
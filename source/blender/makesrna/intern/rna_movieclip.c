@@ -49,6 +49,8 @@
 #  include "DNA_screen_types.h"
 #  include "DNA_space_types.h"
 
+#  include "IMB_moviecache.h"
+
 #  include "SEQ_relations.h"
 
 static void rna_MovieClip_reload_update(Main *UNUSED(bmain), Scene *UNUSED(scene), PointerRNA *ptr)
@@ -72,6 +74,30 @@ static float rna_MovieClip_fps_get(PointerRNA *ptr)
   return BKE_movieclip_get_fps(clip);
 }
 
+static int rna_MovieClip_cache_hits_get(PointerRNA *ptr)
+{
+  MovieClip *clip = (MovieClip *)ptr->owner_id;
+  MovieCacheStats stats;
+  BKE_movieclip_get_cache_stats(clip, &stats);
+  return (int)MIN2(stats.hits, INT_MAX);
+}
+
+static int rna_MovieClip_cache_misses_get(PointerRNA *ptr)
+{
+  MovieClip *clip = (MovieClip *)ptr->owner_id;
+  MovieCacheStats stats;
+  BKE_movieclip_get_cache_stats(clip, &stats);
+  return (int)MIN2(stats.misses, INT_MAX);
+}
+
+static int rna_MovieClip_cache_evictions_get(PointerRNA *ptr)
+{
+  MovieClip *clip = (MovieClip *)ptr->owner_id;
+  MovieCacheStats stats;
+  BKE_movieclip_get_cache_stats(clip, &stats);
+  return (int)MIN2(stats.evictions, INT_MAX);
+}
+
 static void rna_MovieClip_use_proxy_update(Main *bmain, Scene *UNUSED(scene), PointerRNA *ptr)
 {
   MovieClip *clip = (MovieClip *)ptr->owner_id;
@@ -360,6 +386,25 @@ static void rna_def_movieclip(BlenderRNA *brna)
   RNA_def_property_int_funcs(prop, "rna_MovieClip_size_get", NULL, NULL);
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
 
+  prop = RNA_def_property(srna, "cache_hits", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_MovieClip_cache_hits_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop, "Cache Hits", "Number of frame lookups found in the cache");
+
+  prop = RNA_def_property(srna, "cache_misses", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_MovieClip_cache_misses_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Cache Misses", "Number of frame lookups which were not in the cache");
+
+  prop = RNA_def_property(srna, "cache_evictions", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_MovieClip_cache_evictions_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop,
+      "Cache Evictions",
+      "Number of frames freed from the cache to stay within the memory cache limit");
+
   prop = RNA_def_property(srna, "display_aspect", PROP_FLOAT, PROP_XYZ);
   RNA_def_property_float_sdna(prop, NULL, "aspx");
   RNA_def_property_array(prop, 2);
@@ -37,6 +37,7 @@
 #include "BKE_sound.h"
 
 #include "IMB_metadata.h"
+#include "IMB_moviecache.h"
 
 #include "MEM_guardedalloc.h"
 
@@ -1124,6 +1125,30 @@ static void rna_SequenceEditor_overlay_frame_set(PointerRNA *ptr, int value)
   }
 }
 
+static int rna_SequenceEditor_cache_hits_get(PointerRNA *ptr)
+{
+  Scene *scene = (Scene *)ptr->owner_id;
+  MovieCacheStats stats;
+  SEQ_cache_get_stats(scene, &stats);
+  return (int)MIN2(stats.hits, INT_MAX);
+}
+
+static int rna_SequenceEditor_cache_misses_get(PointerRNA *ptr)
+{
+  Scene *scene = (Scene *)ptr->owner_id;
+  MovieCacheStats stats;
+  SEQ_cache_get_stats(scene, &stats);
+  return (int)MIN2(stats.misses, INT_MAX);
+}
+
+static int rna_SequenceEditor_cache_evictions_get(PointerRNA *ptr)
+{
+  Scene *scene = (Scene *)ptr->owner_id;
+  MovieCacheStats stats;
+  SEQ_cache_get_stats(scene, &stats);
+  return (int)MIN2(stats.evictions, INT_MAX);
+}
+
 static int modifier_seq_cmp_fn(Sequence *seq, void *arg_pt)
 {
   SequenceSearchData *data = arg_pt;
@@ -2102,6 +2127,25 @@ static void rna_def_editor(BlenderRNA *brna)
       "Prefetch Frames",
       "Render frames ahead of current frame in the background for faster playback");
   RNA_def_property_update(prop, NC_SCENE | ND_SEQUENCER, NULL);
+
+  prop = RNA_def_property(srna, "cache_hits", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_hits_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop, "Cache Hits", "Number of image lookups found in the cache");
+
+  prop = RNA_def_property(srna, "cache_misses", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_misses_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Cache Misses", "Number of image lookups which were not in the memory cache");
+
+  prop = RNA_def_property(srna, "cache_evictions", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_evictions_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop,
+      "Cache Evictions",
+      "Number of frames freed from the cache to stay within the memory cache limit");
 }
 
 static void rna_def_filter_video(StructRNA *srna)
@@ -26,6 +26,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -43,6 +44,7 @@
 #include "BKE_editmesh.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_mesh_wrapper.h"
 #include "BKE_screen.h"
 
@@ -177,11 +179,88 @@ static void mesh_get_boundaries(Mesh *mesh, float *smooth_weights)
   MEM_freeN(boundaries);
 }
 
+/* -------------------------------------------------------------------- */
+/* Smoothing Iterations
+ *
+ * Each iteration reads the coordinates of the previous one and writes into a second buffer,
+ * so vertices can be smoothed in parallel. The neighbors of every vertex are gathered through
+ * a vertex to vertex map, which gives the same result as accumulating along edges.
+ */
+
+/* Don't bother with threading for small meshes. */
+#define SMOOTH_PARALLEL_MIN_VERTS 1024
+
+typedef struct SmoothIterData {
+  const MeshElemMap *vert_to_vert;
+  const float (*co_src)[3];
+  float (*co_dst)[3];
+  /* Per vertex factor (simple smoothing), or per vertex weight (length weighted smoothing). */
+  const float *vertex_factor;
+  float lambda;
+} SmoothIterData;
+
+static MeshElemMap *smooth_vert_to_vert_map_create(Mesh *mesh, uint numVerts, int **r_mem)
+{
+  MeshElemMap *vert_to_vert;
+  BKE_mesh_vert_edge_vert_map_create(
+      &vert_to_vert, r_mem, mesh->medge, (int)numVerts, mesh->totedge);
+  return vert_to_vert;
+}
+
+static void smooth_iter_run(SmoothIterData *data,
+                            float (*vertexCos)[3],
+                            uint numVerts,
+                            uint iterations,
+                            TaskParallelRangeFunc func)
+{
+  float(*co_tmp)[3] = MEM_malloc_arrayN(numVerts, sizeof(float[3]), __func__);
+  float(*co_src)[3] = vertexCos;
+  float(*co_dst)[3] = co_tmp;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (numVerts > SMOOTH_PARALLEL_MIN_VERTS);
+  settings.min_iter_per_thread = SMOOTH_PARALLEL_MIN_VERTS;
+
+  while (iterations--) {
+    data->co_src = (const float(*)[3])co_src;
+    data->co_dst = co_dst;
+    BLI_task_parallel_range(0, (int)numVerts, data, func, &settings);
+    float(*co_swap)[3] = co_src;
+    co_src = co_dst;
+    co_dst = co_swap;
+  }
+
+  if (co_src != vertexCos) {
+    memcpy(vertexCos, co_src, sizeof(float[3]) * numVerts);
+  }
+  MEM_freeN(co_tmp);
+}
+
 /* -------------------------------------------------------------------- */
 /* Simple Weighted Smoothing
  *
  * (average of surrounding verts)
  */
+static void smooth_iter__simple_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SmoothIterData *data = userdata;
+  const MeshElemMap *map = &data->vert_to_vert[i];
+  const float *co = data->co_src[i];
+  float delta[3] = {0.0f, 0.0f, 0.0f};
+
+  for (int j = 0; j < map->count; j++) {
+    const float *co_other = data->co_src[map->indices[j]];
+    delta[0] += co_other[0] - co[0];
+    delta[1] += co_other[1] - co[1];
+    delta[2] += co_other[2] - co[2];
+  }
+
+  madd_v3_v3v3fl(data->co_dst[i], co, delta, data->vertex_factor[i]);
+}
+
 static void smooth_iter__simple(CorrectiveSmoothModifierData *csmd,
                                 Mesh *mesh,
                                 float (*vertexCos)[3],
@@ -192,72 +271,75 @@ static void smooth_iter__simple(CorrectiveSmoothModifierData *csmd,
   const float lambda = csmd->lambda;
   uint i;
 
-  const uint numEdges = (uint)mesh->totedge;
-  const MEdge *edges = mesh->medge;
   float *vertex_edge_count_div;
+  int *vert_to_vert_mem;
+  MeshElemMap *vert_to_vert = smooth_vert_to_vert_map_create(mesh, numVerts, &vert_to_vert_mem);
 
-  struct SmoothingData_Simple {
-    float delta[3];
-  } *smooth_data = MEM_calloc_arrayN(numVerts, sizeof(*smooth_data), __func__);
-
-  vertex_edge_count_div = MEM_calloc_arrayN(numVerts, sizeof(float), __func__);
-
-  /* calculate as floats to avoid int->float conversion in #smooth_iter */
-  for (i = 0; i < numEdges; i++) {
-    vertex_edge_count_div[edges[i].v1] += 1.0f;
-    vertex_edge_count_div[edges[i].v2] += 1.0f;
-  }
+  vertex_edge_count_div = MEM_malloc_arrayN(numVerts, sizeof(float), __func__);
 
   /* a little confusing, but we can include 'lambda' and smoothing weight
    * here to avoid multiplying for every iteration */
-  if (smooth_weights == NULL) {
-    for (i = 0; i < numVerts; i++) {
-      vertex_edge_count_div[i] = lambda * (vertex_edge_count_div[i] ?
-                                               (1.0f / vertex_edge_count_div[i]) :
-                                               1.0f);
-    }
-  }
-  else {
-    for (i = 0; i < numVerts; i++) {
-      vertex_edge_count_div[i] = smooth_weights[i] * lambda *
-                                 (vertex_edge_count_div[i] ? (1.0f / vertex_edge_count_div[i]) :
-                                                             1.0f);
+  for (i = 0; i < numVerts; i++) {
+    const float count = (float)vert_to_vert[i].count;
+    vertex_edge_count_div[i] = lambda * (count ? (1.0f / count) : 1.0f);
+    if (smooth_weights != NULL) {
+      vertex_edge_count_div[i] *= smooth_weights[i];
     }
   }
 
   /* -------------------------------------------------------------------- */
   /* Main Smoothing Loop */
 
-  while (iterations--) {
-    for (i = 0; i < numEdges; i++) {
-      struct SmoothingData_Simple *sd_v1;
-      struct SmoothingData_Simple *sd_v2;
-      float edge_dir[3];
-
-      sub_v3_v3v3(edge_dir, vertexCos[edges[i].v2], vertexCos[edges[i].v1]);
-
-      sd_v1 = &smooth_data[edges[i].v1];
-      sd_v2 = &smooth_data[edges[i].v2];
-
-      add_v3_v3(sd_v1->delta, edge_dir);
-      sub_v3_v3(sd_v2->delta, edge_dir);
-    }
-
-    for (i = 0; i < numVerts; i++) {
-      struct SmoothingData_Simple *sd = &smooth_data[i];
-      madd_v3_v3fl(vertexCos[i], sd->delta, vertex_edge_count_div[i]);
-      /* zero for the next iteration (saves memset on entire array) */
-      memset(sd, 0, sizeof(*sd));
-    }
-  }
+  SmoothIterData data = {
+      .vert_to_vert = vert_to_vert,
+      .vertex_factor = vertex_edge_count_div,
+      .lambda = lambda,
+  };
+  smooth_iter_run(&data, vertexCos, numVerts, iterations, smooth_iter__simple_cb);
 
   MEM_freeN(vertex_edge_count_div);
-  MEM_freeN(smooth_data);
+  MEM_freeN(vert_to_vert);
+  MEM_freeN(vert_to_vert_mem);
 }
 
 /* -------------------------------------------------------------------- */
 /* Edge-Length Weighted Smoothing
  */
+static void smooth_iter__length_weight_cb(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const float eps = FLT_EPSILON * 10.0f;
+  const SmoothIterData *data = userdata;
+  const MeshElemMap *map = &data->vert_to_vert[i];
+  const float *co = data->co_src[i];
+  float delta[3] = {0.0f, 0.0f, 0.0f};
+  float edge_length_sum = 0.0f;
+
+  for (int j = 0; j < map->count; j++) {
+    float edge_dir[3];
+    sub_v3_v3v3(edge_dir, data->co_src[map->indices[j]], co);
+    const float edge_dist = len_v3(edge_dir);
+
+    /* weight by distance */
+    madd_v3_v3fl(delta, edge_dir, edge_dist);
+    edge_length_sum += edge_dist;
+  }
+
+  /* Divide by sum of all neighbor distances (weighted) and amount of neighbors,
+   * (mean average). */
+  const float div = edge_length_sum * (float)map->count;
+  if (div > eps) {
+    const float lambda_w = (data->vertex_factor != NULL) ?
+                               data->lambda * data->vertex_factor[i] :
+                               data->lambda;
+    madd_v3_v3v3fl(data->co_dst[i], co, delta, lambda_w / div);
+  }
+  else {
+    copy_v3_v3(data->co_dst[i], co);
+  }
+}
+
 static void smooth_iter__length_weight(CorrectiveSmoothModifierData *csmd,
                                        Mesh *mesh,
                                        float (*vertexCos)[3],
@@ -265,91 +347,24 @@ static void smooth_iter__length_weight(CorrectiveSmoothModifierData *csmd,
                                        const float *smooth_weights,
                                        uint iterations)
 {
-  const float eps = FLT_EPSILON * 10.0f;
-  const uint numEdges = (uint)mesh->totedge;
   /* note: the way this smoothing method works, its approx half as strong as the simple-smooth,
    * and 2.0 rarely spikes, double the value for consistent behavior. */
   const float lambda = csmd->lambda * 2.0f;
-  const MEdge *edges = mesh->medge;
-  float *vertex_edge_count;
-  uint i;
-
-  struct SmoothingData_Weighted {
-    float delta[3];
-    float edge_length_sum;
-  } *smooth_data = MEM_calloc_arrayN(numVerts, sizeof(*smooth_data), __func__);
-
-  /* calculate as floats to avoid int->float conversion in #smooth_iter */
-  vertex_edge_count = MEM_calloc_arrayN(numVerts, sizeof(float), __func__);
-  for (i = 0; i < numEdges; i++) {
-    vertex_edge_count[edges[i].v1] += 1.0f;
-    vertex_edge_count[edges[i].v2] += 1.0f;
-  }
+  int *vert_to_vert_mem;
+  MeshElemMap *vert_to_vert = smooth_vert_to_vert_map_create(mesh, numVerts, &vert_to_vert_mem);
 
   /* -------------------------------------------------------------------- */
   /* Main Smoothing Loop */
 
-  while (iterations--) {
-    for (i = 0; i < numEdges; i++) {
-      struct SmoothingData_Weighted *sd_v1;
-      struct SmoothingData_Weighted *sd_v2;
-      float edge_dir[3];
-      float edge_dist;
-
-      sub_v3_v3v3(edge_dir, vertexCos[edges[i].v2], vertexCos[edges[i].v1]);
-      edge_dist = len_v3(edge_dir);
-
-      /* weight by distance */
-      mul_v3_fl(edge_dir, edge_dist);
-
-      sd_v1 = &smooth_data[edges[i].v1];
-      sd_v2 = &smooth_data[edges[i].v2];
-
-      add_v3_v3(sd_v1->delta, edge_dir);
-      sub_v3_v3(sd_v2->delta, edge_dir);
-
-      sd_v1->edge_length_sum += edge_dist;
-      sd_v2->edge_length_sum += edge_dist;
-    }
-
-    if (smooth_weights == NULL) {
-      /* fast-path */
-      for (i = 0; i < numVerts; i++) {
-        struct SmoothingData_Weighted *sd = &smooth_data[i];
-        /* Divide by sum of all neighbor distances (weighted) and amount of neighbors,
-         * (mean average). */
-        const float div = sd->edge_length_sum * vertex_edge_count[i];
-        if (div > eps) {
-#if 0
-          /* first calculate the new location */
-          mul_v3_fl(sd->delta, 1.0f / div);
-          /* then interpolate */
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda);
-#else
-          /* do this in one step */
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda / div);
-#endif
-        }
-        /* zero for the next iteration (saves memset on entire array) */
-        memset(sd, 0, sizeof(*sd));
-      }
-    }
-    else {
-      for (i = 0; i < numVerts; i++) {
-        struct SmoothingData_Weighted *sd = &smooth_data[i];
-        const float div = sd->edge_length_sum * vertex_edge_count[i];
-        if (div > eps) {
-          const float lambda_w = lambda * smooth_weights[i];
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda_w / div);
-        }
-
-        memset(sd, 0, sizeof(*sd));
-      }
-    }
-  }
+  SmoothIterData data = {
+      .vert_to_vert = vert_to_vert,
+      .vertex_factor = smooth_weights,
+      .lambda = lambda,
+  };
+  smooth_iter_run(&data, vertexCos, numVerts, iterations, smooth_iter__length_weight_cb);
 
-  MEM_freeN(vertex_edge_count);
-  MEM_freeN(smooth_data);
+  MEM_freeN(vert_to_vert);
+  MEM_freeN(vert_to_vert_mem);
 }
 
 static void smooth_iter(CorrectiveSmoothModifierData *csmd,
@@ -577,6 +592,28 @@ static void calc_deltas(CorrectiveSmoothModifierData *csmd,
   MEM_freeN(smooth_vertex_coords);
 }
 
+typedef struct ApplyDeltasData {
+  float (*tangent_spaces)[3][3];
+  const float (*deltas)[3];
+  float (*vertexCos)[3];
+  float scale;
+} ApplyDeltasData;
+
+static void apply_deltas_cb(void *__restrict userdata,
+                            const int i,
+                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ApplyDeltasData *data = userdata;
+  float delta[3];
+
+#ifdef USE_TANGENT_CALC_INLINE
+  calc_tangent_ortho(data->tangent_spaces[i]);
+#endif
+
+  mul_v3_m3v3(delta, data->tangent_spaces[i], data->deltas[i]);
+  madd_v3_v3fl(data->vertexCos[i], delta, data->scale);
+}
+
 static void correctivesmooth_modifier_do(ModifierData *md,
                                          Depsgraph *depsgraph,
                                          Object *ob,
@@ -703,25 +740,23 @@ static void correctivesmooth_modifier_do(ModifierData *md,
   smooth_verts(csmd, mesh, dvert, defgrp_index, vertexCos, numVerts);
 
   {
-    uint i;
-
     float(*tangent_spaces)[3][3];
-    const float scale = csmd->scale;
     /* calloc, since values are accumulated */
     tangent_spaces = MEM_calloc_arrayN(numVerts, sizeof(float[3][3]), __func__);
 
     calc_tangent_spaces(mesh, vertexCos, tangent_spaces);
 
-    for (i = 0; i < numVerts; i++) {
-      float delta[3];
-
-#ifdef USE_TANGENT_CALC_INLINE
-      calc_tangent_ortho(tangent_spaces[i]);
-#endif
-
-      mul_v3_m3v3(delta, tangent_spaces[i], csmd->delta_cache.deltas[i]);
-      madd_v3_v3fl(vertexCos[i], delta, scale);
-    }
+    ApplyDeltasData data = {
+        .tangent_spaces = tangent_spaces,
+        .deltas = (const float(*)[3])csmd->delta_cache.deltas,
+        .vertexCos = vertexCos,
+        .scale = csmd->scale,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (numVerts > SMOOTH_PARALLEL_MIN_VERTS);
+    settings.min_iter_per_thread = SMOOTH_PARALLEL_MIN_VERTS;
+    BLI_task_parallel_range(0, (int)numVerts, &data, apply_deltas_cb, &settings);
 
     MEM_freeN(tangent_spaces);
   }
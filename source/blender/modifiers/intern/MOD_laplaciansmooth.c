@@ -24,6 +24,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -157,52 +158,114 @@ static LaplacianSystem *init_laplacian_system(int a_numEdges,
   return sys;
 }
 
+/* Don't bother with threading for small meshes. */
+#define LAPLACIAN_PARALLEL_MIN_ITER 1024
+
+static void laplacian_parallel_range_settings(TaskParallelSettings *settings, int num_items)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->use_threading = (num_items > LAPLACIAN_PARALLEL_MIN_ITER);
+  settings->min_iter_per_thread = LAPLACIAN_PARALLEL_MIN_ITER;
+}
+
+typedef struct VolumeData {
+  const float *center;
+  float (*vertexCos)[3];
+  const MPoly *mpoly;
+  const MLoop *mloop;
+} VolumeData;
+
+static void compute_volume_cb(void *__restrict userdata,
+                              const int i,
+                              const TaskParallelTLS *__restrict tls)
+{
+  const VolumeData *data = userdata;
+  float *vol = tls->userdata_chunk;
+  const MPoly *mp = &data->mpoly[i];
+  const MLoop *l_first = &data->mloop[mp->loopstart];
+  const MLoop *l_prev = l_first + 1;
+  const MLoop *l_curr = l_first + 2;
+  const MLoop *l_term = l_first + mp->totloop;
+
+  for (; l_curr != l_term; l_prev = l_curr, l_curr++) {
+    *vol += volume_tetrahedron_signed_v3(data->center,
+                                         data->vertexCos[l_first->v],
+                                         data->vertexCos[l_prev->v],
+                                         data->vertexCos[l_curr->v]);
+  }
+}
+
+static void compute_volume_reduce(const void *__restrict UNUSED(userdata),
+                                  void *__restrict chunk_join,
+                                  void *__restrict chunk)
+{
+  *(float *)chunk_join += *(const float *)chunk;
+}
+
 static float compute_volume(const float center[3],
                             float (*vertexCos)[3],
                             const MPoly *mpoly,
                             int numPolys,
                             const MLoop *mloop)
 {
-  int i;
   float vol = 0.0f;
+  VolumeData data = {
+      .center = center,
+      .vertexCos = vertexCos,
+      .mpoly = mpoly,
+      .mloop = mloop,
+  };
+
+  TaskParallelSettings settings;
+  laplacian_parallel_range_settings(&settings, numPolys);
+  settings.userdata_chunk = &vol;
+  settings.userdata_chunk_size = sizeof(vol);
+  settings.func_reduce = compute_volume_reduce;
+  BLI_task_parallel_range(0, numPolys, &data, compute_volume_cb, &settings);
+
+  return fabsf(vol);
+}
 
-  for (i = 0; i < numPolys; i++) {
-    const MPoly *mp = &mpoly[i];
-    const MLoop *l_first = &mloop[mp->loopstart];
-    const MLoop *l_prev = l_first + 1;
-    const MLoop *l_curr = l_first + 2;
-    const MLoop *l_term = l_first + mp->totloop;
+typedef struct VolumePreservationData {
+  LaplacianSystem *sys;
+  float beta;
+  short flag;
+} VolumePreservationData;
 
-    for (; l_curr != l_term; l_prev = l_curr, l_curr++) {
-      vol += volume_tetrahedron_signed_v3(
-          center, vertexCos[l_first->v], vertexCos[l_prev->v], vertexCos[l_curr->v]);
-    }
+static void volume_preservation_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const VolumePreservationData *data = userdata;
+  LaplacianSystem *sys = data->sys;
+  const float beta = data->beta;
+  const short flag = data->flag;
+
+  if (flag & MOD_LAPLACIANSMOOTH_X) {
+    sys->vertexCos[i][0] = (sys->vertexCos[i][0] - sys->vert_centroid[0]) * beta +
+                           sys->vert_centroid[0];
+  }
+  if (flag & MOD_LAPLACIANSMOOTH_Y) {
+    sys->vertexCos[i][1] = (sys->vertexCos[i][1] - sys->vert_centroid[1]) * beta +
+                           sys->vert_centroid[1];
+  }
+  if (flag & MOD_LAPLACIANSMOOTH_Z) {
+    sys->vertexCos[i][2] = (sys->vertexCos[i][2] - sys->vert_centroid[2]) * beta +
+                           sys->vert_centroid[2];
   }
-
-  return fabsf(vol);
 }
 
 static void volume_preservation(LaplacianSystem *sys, float vini, float vend, short flag)
 {
-  float beta;
-  int i;
-
   if (vend != 0.0f) {
-    beta = pow(vini / vend, 1.0f / 3.0f);
-    for (i = 0; i < sys->numVerts; i++) {
-      if (flag & MOD_LAPLACIANSMOOTH_X) {
-        sys->vertexCos[i][0] = (sys->vertexCos[i][0] - sys->vert_centroid[0]) * beta +
-                               sys->vert_centroid[0];
-      }
-      if (flag & MOD_LAPLACIANSMOOTH_Y) {
-        sys->vertexCos[i][1] = (sys->vertexCos[i][1] - sys->vert_centroid[1]) * beta +
-                               sys->vert_centroid[1];
-      }
-      if (flag & MOD_LAPLACIANSMOOTH_Z) {
-        sys->vertexCos[i][2] = (sys->vertexCos[i][2] - sys->vert_centroid[2]) * beta +
-                               sys->vert_centroid[2];
-      }
-    }
+    VolumePreservationData data = {
+        .sys = sys,
+        .beta = pow(vini / vend, 1.0f / 3.0f),
+        .flag = flag,
+    };
+    TaskParallelSettings settings;
+    laplacian_parallel_range_settings(&settings, sys->numVerts);
+    BLI_task_parallel_range(0, sys->numVerts, &data, volume_preservation_cb, &settings);
   }
 }
 
@@ -347,34 +410,59 @@ static void fill_laplacian_matrix(LaplacianSystem *sys)
   }
 }
 
-static void validate_solution(LaplacianSystem *sys, short flag, float lambda, float lambda_border)
+typedef struct ValidateSolutionData {
+  LaplacianSystem *sys;
+  short flag;
+  float lambda;
+  float lambda_border;
+} ValidateSolutionData;
+
+static void validate_solution_cb(void *__restrict userdata,
+                                 const int i,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  int i;
+  const ValidateSolutionData *data = userdata;
+  LaplacianSystem *sys = data->sys;
+  const short flag = data->flag;
   float lam;
+
+  if (sys->zerola[i] == 0) {
+    lam = sys->numNeEd[i] == sys->numNeFa[i] ? (data->lambda >= 0.0f ? 1.0f : -1.0f) :
+                                               (data->lambda_border >= 0.0f ? 1.0f : -1.0f);
+    if (flag & MOD_LAPLACIANSMOOTH_X) {
+      sys->vertexCos[i][0] += lam * ((float)EIG_linear_solver_variable_get(sys->context, 0, i) -
+                                     sys->vertexCos[i][0]);
+    }
+    if (flag & MOD_LAPLACIANSMOOTH_Y) {
+      sys->vertexCos[i][1] += lam * ((float)EIG_linear_solver_variable_get(sys->context, 1, i) -
+                                     sys->vertexCos[i][1]);
+    }
+    if (flag & MOD_LAPLACIANSMOOTH_Z) {
+      sys->vertexCos[i][2] += lam * ((float)EIG_linear_solver_variable_get(sys->context, 2, i) -
+                                     sys->vertexCos[i][2]);
+    }
+  }
+}
+
+static void validate_solution(LaplacianSystem *sys, short flag, float lambda, float lambda_border)
+{
   float vini = 0.0f, vend = 0.0f;
 
   if (flag & MOD_LAPLACIANSMOOTH_PRESERVE_VOLUME) {
     vini = compute_volume(
         sys->vert_centroid, sys->vertexCos, sys->mpoly, sys->numPolys, sys->mloop);
   }
-  for (i = 0; i < sys->numVerts; i++) {
-    if (sys->zerola[i] == 0) {
-      lam = sys->numNeEd[i] == sys->numNeFa[i] ? (lambda >= 0.0f ? 1.0f : -1.0f) :
-                                                 (lambda_border >= 0.0f ? 1.0f : -1.0f);
-      if (flag & MOD_LAPLACIANSMOOTH_X) {
-        sys->vertexCos[i][0] += lam * ((float)EIG_linear_solver_variable_get(sys->context, 0, i) -
-                                       sys->vertexCos[i][0]);
-      }
-      if (flag & MOD_LAPLACIANSMOOTH_Y) {
-        sys->vertexCos[i][1] += lam * ((float)EIG_linear_solver_variable_get(sys->context, 1, i) -
-                                       sys->vertexCos[i][1]);
-      }
-      if (flag & MOD_LAPLACIANSMOOTH_Z) {
-        sys->vertexCos[i][2] += lam * ((float)EIG_linear_solver_variable_get(sys->context, 2, i) -
-                                       sys->vertexCos[i][2]);
-      }
-    }
-  }
+
+  ValidateSolutionData data = {
+      .sys = sys,
+      .flag = flag,
+      .lambda = lambda,
+      .lambda_border = lambda_border,
+  };
+  TaskParallelSettings settings;
+  laplacian_parallel_range_settings(&settings, sys->numVerts);
+  BLI_task_parallel_range(0, sys->numVerts, &data, validate_solution_cb, &settings);
+
   if (flag & MOD_LAPLACIANSMOOTH_PRESERVE_VOLUME) {
     vend = compute_volume(
         sys->vert_centroid, sys->vertexCos, sys->mpoly, sys->numPolys, sys->mloop);
@@ -382,6 +470,25 @@ static void validate_solution(LaplacianSystem *sys, short flag, float lambda, fl
   }
 }
 
+typedef struct SolverInputData {
+  LinearSolver *context;
+  float (*vertexCos)[3];
+} SolverInputData;
+
+/* Pass current coordinates to the solver. Only used once the matrix has been constructed,
+ * at that point setting variables and right hand side of different vertices is independent. */
+static void solver_input_set_cb(void *__restrict userdata,
+                                const int i,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SolverInputData *data = userdata;
+  const float *co = data->vertexCos[i];
+  for (int axis = 0; axis < 3; axis++) {
+    EIG_linear_solver_variable_set(data->context, axis, i, co[axis]);
+    EIG_linear_solver_right_hand_side_add(data->context, axis, i, co[axis]);
+  }
+}
+
 static void laplaciansmoothModifier_do(
     LaplacianSmoothModifierData *smd, Object *ob, Mesh *mesh, float (*vertexCos)[3], int numVerts)
 {
@@ -415,24 +522,22 @@ static void laplaciansmoothModifier_do(
   init_laplacian_matrix(sys);
 
   for (iter = 0; iter < smd->repeat; iter++) {
-    for (i = 0; i < numVerts; i++) {
-      EIG_linear_solver_variable_set(sys->context, 0, i, vertexCos[i][0]);
-      EIG_linear_solver_variable_set(sys->context, 1, i, vertexCos[i][1]);
-      EIG_linear_solver_variable_set(sys->context, 2, i, vertexCos[i][2]);
-      if (iter == 0) {
+    if (iter == 0) {
+      for (i = 0; i < numVerts; i++) {
+        EIG_linear_solver_variable_set(sys->context, 0, i, vertexCos[i][0]);
+        EIG_linear_solver_variable_set(sys->context, 1, i, vertexCos[i][1]);
+        EIG_linear_solver_variable_set(sys->context, 2, i, vertexCos[i][2]);
         add_v3_v3(sys->vert_centroid, vertexCos[i]);
       }
-    }
-    if (iter == 0 && numVerts > 0) {
-      mul_v3_fl(sys->vert_centroid, 1.0f / (float)numVerts);
-    }
+      if (numVerts > 0) {
+        mul_v3_fl(sys->vert_centroid, 1.0f / (float)numVerts);
+      }
 
-    dv = dvert;
-    for (i = 0; i < numVerts; i++) {
-      EIG_linear_solver_right_hand_side_add(sys->context, 0, i, vertexCos[i][0]);
-      EIG_linear_solver_right_hand_side_add(sys->context, 1, i, vertexCos[i][1]);
-      EIG_linear_solver_right_hand_side_add(sys->context, 2, i, vertexCos[i][2]);
-      if (iter == 0) {
+      dv = dvert;
+      for (i = 0; i < numVerts; i++) {
+        EIG_linear_solver_right_hand_side_add(sys->context, 0, i, vertexCos[i][0]);
+        EIG_linear_solver_right_hand_side_add(sys->context, 1, i, vertexCos[i][1]);
+        EIG_linear_solver_right_hand_side_add(sys->context, 2, i, vertexCos[i][2]);
         if (dv) {
           wpaint = invert_vgroup ? 1.0f - BKE_defvert_find_weight(dv, defgrp_index) :
                                    BKE_defvert_find_weight(dv, defgrp_index);
@@ -479,11 +584,19 @@ static void laplaciansmoothModifier_do(
           EIG_linear_solver_matrix_add(sys->context, i, i, 1.0f);
         }
       }
-    }
 
-    if (iter == 0) {
       fill_laplacian_matrix(sys);
     }
+    else {
+      /* The matrix is constructed, only coordinates change between iterations. */
+      SolverInputData data = {
+          .context = sys->context,
+          .vertexCos = vertexCos,
+      };
+      TaskParallelSettings settings;
+      laplacian_parallel_range_settings(&settings, numVerts);
+      BLI_task_parallel_range(0, numVerts, &data, solver_input_set_cb, &settings);
+    }
 
     if (EIG_linear_solver_solve(sys->context)) {
       validate_solution(sys, smd->flag, smd->lambda, smd->lambda_border);
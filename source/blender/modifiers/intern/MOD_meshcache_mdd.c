@@ -18,20 +18,17 @@
  * \ingroup modifiers
  */
 
-#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
 
-#include "BLI_fileops.h"
 #include "BLI_math.h"
 #ifdef __LITTLE_ENDIAN__
 #  include "BLI_endian_switch.h"
 #endif
-#ifdef WIN32
-#  include "BLI_winstuff.h"
-#endif
 
 #include "DNA_modifier_types.h"
 
@@ -42,12 +39,12 @@ typedef struct MDDHead {
   int verts_tot;
 } MDDHead; /* frames, verts */
 
-static bool meshcache_read_mdd_head(FILE *fp,
+static bool meshcache_read_mdd_head(MeshCacheFile *file,
                                     const int verts_tot,
                                     MDDHead *mdd_head,
                                     const char **err_str)
 {
-  if (!fread(mdd_head, sizeof(*mdd_head), 1, fp)) {
+  if (!MOD_meshcache_file_read(file, mdd_head, 0, sizeof(*mdd_head))) {
     *err_str = "Missing header";
     return false;
   }
@@ -65,36 +62,18 @@ static bool meshcache_read_mdd_head(FILE *fp,
     *err_str = "Invalid frame total";
     return false;
   }
-  /* Intentionally don't seek back. */
 
   return true;
 }
 
-/**
- * Gets the index range and factor.
- */
-static bool meshcache_read_mdd_range(FILE *fp,
-                                     const int verts_tot,
-                                     const float frame,
-                                     const char interp,
-                                     int r_index_range[2],
-                                     float *r_factor,
-                                     const char **err_str)
+/* Frames follow the header and a time-stamp per frame. */
+BLI_INLINE size_t meshcache_mdd_frame_offset(const MDDHead *mdd_head, const int index)
 {
-  MDDHead mdd_head;
-
-  /* first check interpolation and get the vert locations */
-
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
-    return false;
-  }
-
-  MOD_meshcache_calc_range(frame, interp, mdd_head.frame_tot, r_index_range, r_factor);
-
-  return true;
+  return sizeof(*mdd_head) + sizeof(float) * (size_t)mdd_head->frame_tot +
+         sizeof(float[3]) * (size_t)index * (size_t)mdd_head->verts_tot;
 }
 
-static bool meshcache_read_mdd_range_from_time(FILE *fp,
+static bool meshcache_read_mdd_range_from_time(MeshCacheFile *file,
                                                const int verts_tot,
                                                const float time,
                                                const float UNUSED(fps),
@@ -106,29 +85,29 @@ static bool meshcache_read_mdd_range_from_time(FILE *fp,
   float f_time, f_time_prev = FLT_MAX;
   float frame;
 
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
+  if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
     return false;
   }
 
-  size_t num_frames_read = 0;
-  size_t num_frames_expect = mdd_head.frame_tot;
-  errno = 0;
-  for (i = 0; i < mdd_head.frame_tot; i++) {
-    num_frames_read += fread(&f_time, sizeof(float), 1, fp);
+  float *times = MEM_malloc_arrayN(mdd_head.frame_tot, sizeof(float), __func__);
+  if (!MOD_meshcache_file_read(
+          file, times, sizeof(mdd_head), sizeof(float) * (size_t)mdd_head.frame_tot)) {
+    MEM_freeN(times);
+    *err_str = "Timestamp read failed";
+    return false;
+  }
 #ifdef __LITTLE_ENDIAN__
-    BLI_endian_switch_float(&f_time);
+  BLI_endian_switch_float_array(times, mdd_head.frame_tot);
 #endif
+
+  for (i = 0; i < mdd_head.frame_tot; i++) {
+    f_time = times[i];
     if (f_time >= time) {
-      num_frames_expect = i + 1;
       break;
     }
     f_time_prev = f_time;
   }
-
-  if (num_frames_read != num_frames_expect) {
-    *err_str = errno ? strerror(errno) : "Timestamp read failed";
-    return false;
-  }
+  MEM_freeN(times);
 
   if (i == mdd_head.frame_tot) {
     frame = (float)(mdd_head.frame_tot - 1);
@@ -151,7 +130,7 @@ static bool meshcache_read_mdd_range_from_time(FILE *fp,
   return true;
 }
 
-bool MOD_meshcache_read_mdd_index(FILE *fp,
+bool MOD_meshcache_read_mdd_index(MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const int index,
@@ -160,116 +139,76 @@ bool MOD_meshcache_read_mdd_index(FILE *fp,
 {
   MDDHead mdd_head;
 
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
-    return false;
-  }
-
-  if (BLI_fseek(fp, mdd_head.frame_tot * sizeof(int), SEEK_CUR) != 0) {
-    *err_str = "Header seek failed";
+  if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
     return false;
   }
 
-  if (BLI_fseek(fp, sizeof(float[3]) * index * mdd_head.verts_tot, SEEK_CUR) != 0) {
-    *err_str = "Failed to seek frame";
-    return false;
-  }
+  /* Read the whole frame at once, blending reads into a temporary buffer. */
+  const size_t frame_size = sizeof(float[3]) * (size_t)mdd_head.verts_tot;
+  float(*frame_cos)[3] = (factor >= 1.0f) ? vertexCos : MEM_mallocN(frame_size, __func__);
 
-  size_t num_verts_read = 0;
-  errno = 0;
-  if (factor >= 1.0f) {
-#if 1
-    float *vco = *vertexCos;
-    uint i;
-    for (i = mdd_head.verts_tot; i != 0; i--, vco += 3) {
-      num_verts_read += fread(vco, sizeof(float[3]), 1, fp);
-
-#  ifdef __LITTLE_ENDIAN__
-      BLI_endian_switch_float(vco + 0);
-      BLI_endian_switch_float(vco + 1);
-      BLI_endian_switch_float(vco + 2);
-#  endif /* __LITTLE_ENDIAN__ */
+  if (!MOD_meshcache_file_read(
+          file, frame_cos, meshcache_mdd_frame_offset(&mdd_head, index), frame_size)) {
+    if (frame_cos != vertexCos) {
+      MEM_freeN(frame_cos);
     }
-#else
-    /* no blending */
-    if (!fread(vertexCos, sizeof(float[3]), mdd_head.verts_tot, f)) {
-      *err_str = errno ? strerror(errno) : "Failed to read frame";
-      return false;
-    }
-#  ifdef __LITTLE_ENDIAN__
-    BLI_endian_switch_float_array(vertexCos[0], mdd_head.verts_tot * 3);
-#  endif
-#endif
+    *err_str = "Vertex coordinate read failed";
+    return false;
   }
-  else {
-    const float ifactor = 1.0f - factor;
-    float *vco = *vertexCos;
-    uint i;
-    for (i = mdd_head.verts_tot; i != 0; i--, vco += 3) {
-      float tvec[3];
-      num_verts_read += fread(tvec, sizeof(float[3]), 1, fp);
 
 #ifdef __LITTLE_ENDIAN__
-      BLI_endian_switch_float(tvec + 0);
-      BLI_endian_switch_float(tvec + 1);
-      BLI_endian_switch_float(tvec + 2);
+  BLI_endian_switch_float_array(*frame_cos, mdd_head.verts_tot * 3);
 #endif
 
-      vco[0] = (vco[0] * ifactor) + (tvec[0] * factor);
-      vco[1] = (vco[1] * ifactor) + (tvec[1] * factor);
-      vco[2] = (vco[2] * ifactor) + (tvec[2] * factor);
-    }
-  }
-
-  if (num_verts_read != mdd_head.verts_tot) {
-    *err_str = errno ? strerror(errno) : "Vertex coordinate read failed";
-    return false;
+  if (frame_cos != vertexCos) {
+    interp_vn_vn(*vertexCos, *frame_cos, factor, mdd_head.verts_tot * 3);
+    MEM_freeN(frame_cos);
   }
 
   return true;
 }
 
-bool MOD_meshcache_read_mdd_frame(FILE *fp,
+bool MOD_meshcache_read_mdd_frame(MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
                                   const float frame,
                                   const char **err_str)
 {
+  MDDHead mdd_head;
   int index_range[2];
   float factor;
 
-  if (meshcache_read_mdd_range(fp,
-                               verts_tot,
-                               frame,
-                               interp,
-                               index_range,
-                               &factor, /* read into these values */
-                               err_str) == false) {
+  /* first check interpolation and get the vert locations */
+  if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
     return false;
   }
 
-  if (index_range[0] == index_range[1]) {
-    /* read single */
-    if ((BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-        MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[0], 1.0f, err_str)) {
-      return true;
-    }
+  MOD_meshcache_calc_range(frame, interp, mdd_head.frame_tot, index_range, &factor);
 
+  if (!MOD_meshcache_read_mdd_index(file, vertexCos, verts_tot, index_range[0], 1.0f, err_str)) {
+    return false;
+  }
+  if ((index_range[0] != index_range[1]) &&
+      !MOD_meshcache_read_mdd_index(
+          file, vertexCos, verts_tot, index_range[1], factor, err_str)) {
     return false;
   }
 
-  /* read both and interpolate */
-  if ((BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-      MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[0], 1.0f, err_str) &&
-      (BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-      MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[1], factor, err_str)) {
-    return true;
+  /* Page in the frames most likely needed next during playback. */
+  const int prefetch_start = index_range[1] + 1;
+  const int prefetch_end = min_ii(prefetch_start + MESHCACHE_PREFETCH_FRAMES,
+                                  mdd_head.frame_tot);
+  if (prefetch_start < prefetch_end) {
+    const size_t offset = meshcache_mdd_frame_offset(&mdd_head, prefetch_start);
+    MOD_meshcache_file_prefetch(
+        file, offset, meshcache_mdd_frame_offset(&mdd_head, prefetch_end) - offset);
   }
 
-  return false;
+  return true;
 }
 
-bool MOD_meshcache_read_mdd_times(const char *filepath,
+bool MOD_meshcache_read_mdd_times(MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -280,14 +219,6 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
 {
   float frame;
 
-  FILE *fp = BLI_fopen(filepath, "rb");
-  bool ok;
-
-  if (fp == NULL) {
-    *err_str = errno ? strerror(errno) : "Unknown error opening file";
-    return false;
-  }
-
   switch (time_mode) {
     case MOD_MESHCACHE_TIME_FRAME: {
       frame = time;
@@ -295,29 +226,23 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
     }
     case MOD_MESHCACHE_TIME_SECONDS: {
       /* we need to find the closest time */
-      if (meshcache_read_mdd_range_from_time(fp, verts_tot, time, fps, &frame, err_str) == false) {
-        fclose(fp);
+      if (meshcache_read_mdd_range_from_time(file, verts_tot, time, fps, &frame, err_str) ==
+          false) {
         return false;
       }
-      rewind(fp);
       break;
     }
     case MOD_MESHCACHE_TIME_FACTOR:
     default: {
       MDDHead mdd_head;
-      if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
-        fclose(fp);
+      if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
         return false;
       }
 
       frame = CLAMPIS(time, 0.0f, 1.0f) * (float)mdd_head.frame_tot;
-      rewind(fp);
       break;
     }
   }
 
-  ok = MOD_meshcache_read_mdd_frame(fp, vertexCos, verts_tot, interp, frame, err_str);
-
-  fclose(fp);
-  return ok;
+  return MOD_meshcache_read_mdd_frame(file, vertexCos, verts_tot, interp, frame, err_str);
 }
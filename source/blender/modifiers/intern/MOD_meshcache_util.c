@@ -18,14 +18,219 @@
  * \ingroup modifiers
  */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
 
+#include "BLI_fileops.h"
 #include "BLI_math.h"
+#include "BLI_mmap.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#ifdef WIN32
+#  include "BLI_winstuff.h"
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
 
 #include "DNA_modifier_types.h"
 
 #include "MOD_meshcache_util.h"
 
+/* -------------------------------------------------------------------- */
+/** \name Cache File Access
+ *
+ * Cache files stay open for as long as the modifier uses them, frames following the last one
+ * read are paged in from a background task. Files are only memory mapped for the duration of
+ * a read: a mapping that stays around keeps other programs from rewriting the file on Windows.
+ * \{ */
+
+struct MeshCacheFile {
+  char filepath[FILE_MAX];
+  /* Used to detect the file being overwritten while it is open. */
+  BLI_stat_t stat;
+
+  int fd;
+  /* Mapping and regular reads both move the file offset. */
+  ThreadMutex fd_lock;
+
+  TaskPool *prefetch_pool;
+  ThreadMutex prefetch_lock;
+  bool prefetch_pending;
+};
+
+typedef struct MeshCachePrefetch {
+  size_t offset;
+  size_t length;
+} MeshCachePrefetch;
+
+static MeshCacheFile *meshcache_file_open(const char *filepath,
+                                          const BLI_stat_t *stat,
+                                          const char **err_str)
+{
+  errno = 0;
+  const int fd = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+  if (fd == -1) {
+    *err_str = errno ? strerror(errno) : "Unknown error opening file";
+    return NULL;
+  }
+
+  MeshCacheFile *file = MEM_callocN(sizeof(*file), __func__);
+  BLI_strncpy(file->filepath, filepath, sizeof(file->filepath));
+  file->stat = *stat;
+  file->fd = fd;
+
+  BLI_mutex_init(&file->fd_lock);
+  BLI_mutex_init(&file->prefetch_lock);
+  return file;
+}
+
+/**
+ * Return an open handle for \a filepath, reusing \a file when it still refers to the same
+ * file on disk and freeing it otherwise.
+ */
+MeshCacheFile *MOD_meshcache_file_ensure(MeshCacheFile *file,
+                                         const char *filepath,
+                                         const char **err_str)
+{
+  BLI_stat_t stat;
+
+  errno = 0;
+  if (BLI_stat(filepath, &stat) != 0) {
+    if (file) {
+      MOD_meshcache_file_free(file);
+    }
+    *err_str = errno ? strerror(errno) : "Unknown error opening file";
+    return NULL;
+  }
+
+  if (file) {
+    if (STREQ(file->filepath, filepath) && (file->stat.st_size == stat.st_size) &&
+        (file->stat.st_mtime == stat.st_mtime)) {
+      return file;
+    }
+    MOD_meshcache_file_free(file);
+  }
+
+  return meshcache_file_open(filepath, &stat, err_str);
+}
+
+void MOD_meshcache_file_free(MeshCacheFile *file)
+{
+  if (file->prefetch_pool) {
+    BLI_task_pool_cancel(file->prefetch_pool);
+    BLI_task_pool_free(file->prefetch_pool);
+  }
+  BLI_mutex_end(&file->prefetch_lock);
+  BLI_mutex_end(&file->fd_lock);
+
+  close(file->fd);
+
+  MEM_freeN(file);
+}
+
+static BLI_mmap_file *meshcache_file_map(MeshCacheFile *file)
+{
+  BLI_mutex_lock(&file->fd_lock);
+  BLI_mmap_file *mmap_file = BLI_mmap_open(file->fd);
+  BLI_mutex_unlock(&file->fd_lock);
+  return mmap_file;
+}
+
+bool MOD_meshcache_file_read(MeshCacheFile *file, void *dest, size_t offset, size_t length)
+{
+  BLI_mmap_file *mmap_file = meshcache_file_map(file);
+  if (mmap_file) {
+    const bool ok = BLI_mmap_read(mmap_file, dest, offset, length);
+    BLI_mmap_free(mmap_file);
+    return ok;
+  }
+
+  /* The file can't be mapped, fall back to regular reads. */
+  bool ok = true;
+  BLI_mutex_lock(&file->fd_lock);
+  if (BLI_lseek(file->fd, (int64_t)offset, SEEK_SET) != (int64_t)offset) {
+    ok = false;
+  }
+  char *dest_iter = dest;
+  while (ok && length > 0) {
+    const int64_t len_read = read(file->fd, dest_iter, length);
+    if (len_read <= 0) {
+      ok = false;
+      break;
+    }
+    dest_iter += len_read;
+    length -= (size_t)len_read;
+  }
+  BLI_mutex_unlock(&file->fd_lock);
+  return ok;
+}
+
+static void meshcache_prefetch_task(TaskPool *__restrict pool, void *taskdata)
+{
+  MeshCacheFile *file = BLI_task_pool_user_data(pool);
+  const MeshCachePrefetch *prefetch = taskdata;
+
+  /* Touching a byte of every page is enough for the OS to read it in, the pages stay cached
+   * after the mapping is gone. */
+  BLI_mmap_file *mmap_file = meshcache_file_map(file);
+  if (mmap_file) {
+    const size_t page_size = BLI_mmap_page_size();
+    for (size_t offset = prefetch->offset; offset < prefetch->offset + prefetch->length;
+         offset += page_size) {
+      char dummy;
+      if (BLI_task_pool_current_canceled(pool) ||
+          !BLI_mmap_read(mmap_file, &dummy, offset, 1)) {
+        break;
+      }
+    }
+    BLI_mmap_free(mmap_file);
+  }
+
+  BLI_mutex_lock(&file->prefetch_lock);
+  file->prefetch_pending = false;
+  BLI_mutex_unlock(&file->prefetch_lock);
+}
+
+/**
+ * Read the given range in the background, so it's already in memory by the time the
+ * modifier evaluates those frames. Requests are dropped while a previous one is still being
+ * read.
+ */
+void MOD_meshcache_file_prefetch(MeshCacheFile *file, size_t offset, size_t length)
+{
+  if (length == 0) {
+    return;
+  }
+
+  BLI_mutex_lock(&file->prefetch_lock);
+  const bool is_pending = file->prefetch_pending;
+  file->prefetch_pending = true;
+  BLI_mutex_unlock(&file->prefetch_lock);
+  if (is_pending) {
+    return;
+  }
+
+  if (file->prefetch_pool == NULL) {
+    file->prefetch_pool = BLI_task_pool_create_background(file, TASK_PRIORITY_LOW);
+  }
+
+  MeshCachePrefetch *prefetch = MEM_mallocN(sizeof(*prefetch), __func__);
+  prefetch->offset = offset;
+  prefetch->length = length;
+  BLI_task_pool_push(file->prefetch_pool, meshcache_prefetch_task, prefetch, true, NULL);
+}
+
+/** \} */
+
 void MOD_meshcache_calc_range(const float frame,
                               const char interp,
                               const int frame_tot,
@@ -20,20 +20,22 @@
 
 #pragma once
 
+typedef struct MeshCacheFile MeshCacheFile;
+
 /* MOD_meshcache_mdd.c */
-bool MOD_meshcache_read_mdd_index(FILE *fp,
+bool MOD_meshcache_read_mdd_index(MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int vertex_tot,
                                   const int index,
                                   const float factor,
                                   const char **err_str);
-bool MOD_meshcache_read_mdd_frame(FILE *fp,
+bool MOD_meshcache_read_mdd_frame(MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
                                   const float frame,
                                   const char **err_str);
-bool MOD_meshcache_read_mdd_times(const char *filepath,
+bool MOD_meshcache_read_mdd_times(MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -43,19 +45,19 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
                                   const char **err_str);
 
 /* MOD_meshcache_pc2.c */
-bool MOD_meshcache_read_pc2_index(FILE *fp,
+bool MOD_meshcache_read_pc2_index(MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const int index,
                                   const float factor,
                                   const char **err_str);
-bool MOD_meshcache_read_pc2_frame(FILE *fp,
+bool MOD_meshcache_read_pc2_frame(MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
                                   const float frame,
                                   const char **err_str);
-bool MOD_meshcache_read_pc2_times(const char *filepath,
+bool MOD_meshcache_read_pc2_times(MeshCacheFile *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -65,6 +67,13 @@ bool MOD_meshcache_read_pc2_times(const char *filepath,
                                   const char **err_str);
 
 /* MOD_meshcache_util.c */
+MeshCacheFile *MOD_meshcache_file_ensure(MeshCacheFile *file,
+                                         const char *filepath,
+                                         const char **err_str);
+void MOD_meshcache_file_free(MeshCacheFile *file);
+bool MOD_meshcache_file_read(MeshCacheFile *file, void *dest, size_t offset, size_t length);
+void MOD_meshcache_file_prefetch(MeshCacheFile *file, size_t offset, size_t length);
+
 void MOD_meshcache_calc_range(const float frame,
                               const char interp,
                               const int frame_tot,
@@ -72,3 +81,6 @@ void MOD_meshcache_calc_range(const float frame,
                               float *r_factor);
 
 #define FRAME_SNAP_EPS 0.0001f
+
+/* Number of frames following the current one to read ahead of time. */
+#define MESHCACHE_PREFETCH_FRAMES 8
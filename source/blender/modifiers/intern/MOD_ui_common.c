@@ -261,6 +261,12 @@ static void modifier_ops_extra_draw(bContext *C, uiLayout *layout, void *md_v)
           0,
           "OBJECT_OT_modifier_copy_to_selected");
 
+  /* Cache output, only used by the mesh modifier stack. */
+  const ModifierTypeInfo *mti = BKE_modifier_get_info(md->type);
+  if (ob->type == OB_MESH && mti->type != eModifierTypeType_OnlyDeform) {
+    uiItemR(layout, &ptr, "use_cache_output", 0, NULL, ICON_NONE);
+  }
+
   uiItemS(layout);
 
   /* Move to first. */
@@ -48,6 +48,7 @@ void SEQ_proxy_rebuild(struct SeqIndexBuildContext *context,
                        short *do_update,
                        float *progress);
 void SEQ_proxy_rebuild_finish(struct SeqIndexBuildContext *context, bool stop);
+bool SEQ_proxy_rebuild_supports_threading(const struct SeqIndexBuildContext *context);
 void SEQ_proxy_set(struct Sequence *seq, bool value);
 bool SEQ_can_use_proxy(const struct SeqRenderData *context, struct Sequence *seq, int psize);
 int SEQ_rendersize_to_proxysize(int render_size);
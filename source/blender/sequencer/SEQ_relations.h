@@ -29,6 +29,7 @@ extern "C" {
 
 struct ListBase;
 struct Main;
+struct MovieCacheStats;
 struct MovieClip;
 struct ReportList;
 struct Scene;
@@ -65,6 +66,7 @@ void SEQ_cache_iterate(
     void *userdata,
     bool callback_init(void *userdata, size_t item_count),
     bool callback_iter(void *userdata, struct Sequence *seq, int timeline_frame, int cache_type));
+void SEQ_cache_get_stats(struct Scene *scene, struct MovieCacheStats *r_stats);
 #ifdef __cplusplus
 }
 #endif
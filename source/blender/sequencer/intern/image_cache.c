@@ -33,6 +33,7 @@
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
+#include "IMB_moviecache.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_endian_switch.h"
@@ -148,6 +149,8 @@ typedef struct SeqCache {
   struct BLI_mempool *items_pool;
   struct SeqCacheKey *last_key;
   SeqDiskCache *disk_cache;
+  /* Usage statistics of the RAM cache, protected by #iterator_mutex. */
+  size_t hits, misses, evictions;
 } SeqCache;
 
 typedef struct SeqCacheItem {
@@ -1082,6 +1085,7 @@ bool seq_cache_recycle_item(Scene *scene)
 
     if (finalkey) {
       seq_cache_recycle_linked(scene, finalkey);
+      cache->evictions++;
     }
     else {
       seq_cache_unlock(scene);
@@ -1367,6 +1371,12 @@ struct ImBuf *seq_cache_get(const SeqRenderData *context,
   if (cache && seq) {
     seq_cache_populate_key(&key, context, seq, timeline_frame, type);
     ibuf = seq_cache_get_ex(cache, &key);
+    if (ibuf) {
+      cache->hits++;
+    }
+    else {
+      cache->misses++;
+    }
   }
   seq_cache_unlock(scene);
 
@@ -1498,6 +1508,24 @@ void SEQ_cache_iterate(
   seq_cache_unlock(scene);
 }
 
+/* Usage statistics of the RAM cache, all zero when nothing was cached yet. Frames read from the
+ * disk cache count as misses. */
+void SEQ_cache_get_stats(Scene *scene, MovieCacheStats *r_stats)
+{
+  memset(r_stats, 0, sizeof(*r_stats));
+
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return;
+  }
+
+  seq_cache_lock(scene);
+  r_stats->hits = cache->hits;
+  r_stats->misses = cache->misses;
+  r_stats->evictions = cache->evictions;
+  seq_cache_unlock(scene);
+}
+
 bool seq_cache_is_full(void)
 {
   return seq_cache_get_mem_total() < MEM_get_memory_in_use();
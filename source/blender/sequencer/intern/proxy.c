@@ -560,6 +560,15 @@ void SEQ_proxy_rebuild(SeqIndexBuildContext *context,
   }
 }
 
+/**
+ * Movie strips are rebuilt from their own decoder and file handles without touching the sequencer
+ * render state, so several of them can be rebuilt at the same time.
+ */
+bool SEQ_proxy_rebuild_supports_threading(const SeqIndexBuildContext *context)
+{
+  return context->seq->type == SEQ_TYPE_MOVIE;
+}
+
 void SEQ_proxy_rebuild_finish(SeqIndexBuildContext *context, bool stop)
 {
   if (context->index_context) {
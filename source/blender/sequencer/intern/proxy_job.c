@@ -26,8 +26,11 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
+#include "BLI_task.h"
 #include "BLI_timecode.h"
 
 #include "DNA_scene_types.h"
@@ -57,15 +60,87 @@ static void proxy_freejob(void *pjv)
   MEM_freeN(pj);
 }
 
+typedef struct ProxyJobThreadedData {
+  struct SeqIndexBuildContext **contexts;
+  int contexts_num;
+  int contexts_done;
+
+  short *stop;
+  short *do_update;
+  float *progress;
+} ProxyJobThreadedData;
+
+static void proxy_rebuild_task(void *__restrict userdata,
+                               const int index,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ProxyJobThreadedData *data = userdata;
+  /* Progress of a single movie is not reported, the job progresses as movies are finished. */
+  float movie_progress = 0.0f;
+
+  SEQ_proxy_rebuild(data->contexts[index], data->stop, data->do_update, &movie_progress);
+
+  const int contexts_done = atomic_add_and_fetch_int32(&data->contexts_done, 1);
+  *data->progress = (float)contexts_done / data->contexts_num;
+  *data->do_update = true;
+}
+
+/* Rebuild all movie proxies and timecodes, each file on its own thread. */
+static void proxy_rebuild_threaded(ProxyJob *pj, short *stop, short *do_update, float *progress)
+{
+  ProxyJobThreadedData data = {NULL};
+  LinkData *link;
+
+  const int queue_len = BLI_listbase_count(&pj->queue);
+  if (queue_len == 0) {
+    return;
+  }
+
+  data.contexts = MEM_mallocN(sizeof(*data.contexts) * queue_len, __func__);
+  for (link = pj->queue.first; link; link = link->next) {
+    if (SEQ_proxy_rebuild_supports_threading(link->data)) {
+      data.contexts[data.contexts_num++] = link->data;
+    }
+  }
+
+  if (data.contexts_num == 1) {
+    SEQ_proxy_rebuild(data.contexts[0], stop, do_update, progress);
+  }
+  else if (data.contexts_num > 1) {
+    data.stop = stop;
+    data.do_update = do_update;
+    data.progress = progress;
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    BLI_task_parallel_range(0, data.contexts_num, &data, proxy_rebuild_task, &settings);
+  }
+
+  MEM_freeN(data.contexts);
+}
+
 /* Only this runs inside thread. */
 static void proxy_startjob(void *pjv, short *stop, short *do_update, float *progress)
 {
   ProxyJob *pj = pjv;
   LinkData *link;
 
+  proxy_rebuild_threaded(pj, stop, do_update, progress);
+
+  if (*stop) {
+    pj->stop = 1;
+    fprintf(stderr, "Canceling proxy rebuild on users request...\n");
+    return;
+  }
+
+  /* Other strips are rendered through the sequencer, one at a time. */
   for (link = pj->queue.first; link; link = link->next) {
     struct SeqIndexBuildContext *context = link->data;
 
+    if (SEQ_proxy_rebuild_supports_threading(context)) {
+      continue;
+    }
+
     SEQ_proxy_rebuild(context, stop, do_update, progress);
 
     if (*stop) {
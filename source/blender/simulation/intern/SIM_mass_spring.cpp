@@ -1225,6 +1225,8 @@ static void cloth_clear_result(ClothModifierData *clmd)
   sres->max_error = sres->min_error = sres->avg_error = 0.0f;
   sres->max_iterations = sres->min_iterations = 0;
   sres->avg_iterations = 0.0f;
+  sres->selfcol_builds = sres->selfcol_reuses = 0;
+  sres->selfcol_max_pairs = sres->selfcol_max_contacts = 0;
 }
 
 static void cloth_record_result(ClothModifierData *clmd, ImplicitSolverResult *result, float dt)
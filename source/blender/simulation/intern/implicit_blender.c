@@ -34,6 +34,7 @@
 #  include "DNA_texture_types.h"
 
 #  include "BLI_math.h"
+#  include "BLI_task.h"
 #  include "BLI_utildefines.h"
 
 #  include "BKE_cloth.h"
@@ -50,6 +51,12 @@
 #    define CLOTH_OPENMP_LIMIT 512
 #  endif
 
+/* Minimum number of vertices for the solver to use multiple threads. */
+#  define CLOTH_PARALLEL_LIMIT 1024
+/* Number of vertices processed by each parallel task. Reductions are summed per chunk and the
+ * chunk sums are added in order, so results don't depend on the number of threads. */
+#  define CLOTH_PARALLEL_CHUNK 512
+
 //#define DEBUG_TIME
 
 #  ifdef DEBUG_TIME
@@ -193,20 +200,70 @@ DO_INLINE void submul_lfvectorS(float (*to)[3],
   }
 }
 /* dot product for big vector */
+DO_INLINE float dot_lfvector_serial(float (*fLongVectorA)[3],
+                                    float (*fLongVectorB)[3],
+                                    unsigned int start,
+                                    unsigned int end)
+{
+  float temp = 0.0;
+  for (unsigned int i = start; i < end; i++) {
+    temp += dot_v3v3(fLongVectorA[i], fLongVectorB[i]);
+  }
+  return temp;
+}
+
+typedef struct DotLongVectorData {
+  float (*a)[3];
+  float (*b)[3];
+  unsigned int verts;
+  float *chunk_sums;
+} DotLongVectorData;
+
+static void dot_lfvector_chunk_cb(void *__restrict userdata,
+                                  const int chunk,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DotLongVectorData *data = userdata;
+  const unsigned int start = (unsigned int)chunk * CLOTH_PARALLEL_CHUNK;
+  const unsigned int end = MIN2(start + CLOTH_PARALLEL_CHUNK, data->verts);
+  data->chunk_sums[chunk] = dot_lfvector_serial(data->a, data->b, start, end);
+}
+
+/* Sum the partial results of a parallel reduction in a fixed order. */
+DO_INLINE float sum_chunks(const float *chunk_sums, int num_chunks)
+{
+  float temp = 0.0f;
+  for (int i = 0; i < num_chunks; i++) {
+    temp += chunk_sums[i];
+  }
+  return temp;
+}
+
+DO_INLINE int num_parallel_chunks(unsigned int verts)
+{
+  return (int)((verts + CLOTH_PARALLEL_CHUNK - 1) / CLOTH_PARALLEL_CHUNK);
+}
+
 DO_INLINE float dot_lfvector(float (*fLongVectorA)[3],
                              float (*fLongVectorB)[3],
                              unsigned int verts)
 {
-  long i = 0;
-  float temp = 0.0;
-  /* XXX brecht, disabled this for now (first schedule line was already disabled),
-   * due to non-commutative nature of floating point ops this makes the sim give
-   * different results each time you run it!
-   * schedule(guided, 2) */
-  //#pragma omp parallel for reduction(+: temp) if (verts > CLOTH_OPENMP_LIMIT)
-  for (i = 0; i < (long)verts; i++) {
-    temp += dot_v3v3(fLongVectorA[i], fLongVectorB[i]);
+  /* Floating point addition is not associative, so the sum is computed in fixed size chunks
+   * which are added in order. This keeps the result the same for any number of threads. */
+  if (verts < CLOTH_PARALLEL_LIMIT) {
+    return dot_lfvector_serial(fLongVectorA, fLongVectorB, 0, verts);
   }
+
+  const int num_chunks = num_parallel_chunks(verts);
+  float *chunk_sums = MEM_mallocN(sizeof(float) * num_chunks, __func__);
+  DotLongVectorData data = {fLongVectorA, fLongVectorB, verts, chunk_sums};
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, num_chunks, &data, dot_lfvector_chunk_cb, &settings);
+
+  float temp = sum_chunks(chunk_sums, num_chunks);
+  MEM_freeN(chunk_sums);
   return temp;
 }
 /* A = B + C  --> for big vector */
@@ -644,6 +701,103 @@ DO_INLINE void mul_bfmatrix_lfvector(float (*to)[3], fmatrix3x3 *from, lfVector
   del_lfvector(temp);
 }
 
+/* Index of the off-diagonal blocks of a sparse symmetric big matrix by row, which allows rows of
+ * a matrix-vector product to be computed independently. All big matrices of the solver with
+ * spring blocks share the same structure, it only needs to be rebuilt when springs change. */
+typedef struct BlockRowIndex {
+  unsigned int vcount;
+  unsigned int num_blocks;
+  /* Start of each row in entries, vcount + 1 items. */
+  unsigned int *row_offsets;
+  /* Block index times two, plus one if the block is applied transposed. */
+  unsigned int *entries;
+} BlockRowIndex;
+
+static void block_row_index_free(BlockRowIndex *rows)
+{
+  MEM_SAFE_FREE(rows->row_offsets);
+  MEM_SAFE_FREE(rows->entries);
+  rows->num_blocks = 0;
+}
+
+static void block_row_index_build(BlockRowIndex *rows, fmatrix3x3 *matrix, int num_blocks)
+{
+  const unsigned int vcount = matrix[0].vcount;
+
+  block_row_index_free(rows);
+  rows->vcount = vcount;
+  rows->num_blocks = (unsigned int)num_blocks;
+  rows->row_offsets = MEM_callocN(sizeof(unsigned int) * (vcount + 1), __func__);
+  rows->entries = MEM_mallocN(sizeof(unsigned int) * max_ii(2 * num_blocks, 1), __func__);
+
+  /* A spring block (r, c) contributes to row r with M * v[c] and to row c with M^T * v[r]. */
+  unsigned int *row_offsets = rows->row_offsets;
+  for (unsigned int i = vcount; i < vcount + rows->num_blocks; i++) {
+    row_offsets[matrix[i].r + 1]++;
+    row_offsets[matrix[i].c + 1]++;
+  }
+  for (unsigned int i = 0; i < vcount; i++) {
+    row_offsets[i + 1] += row_offsets[i];
+  }
+
+  unsigned int *fill = MEM_dupallocN(row_offsets);
+  for (unsigned int i = vcount; i < vcount + rows->num_blocks; i++) {
+    rows->entries[fill[matrix[i].r]++] = i * 2;
+    rows->entries[fill[matrix[i].c]++] = i * 2 + 1;
+  }
+  MEM_freeN(fill);
+}
+
+typedef struct MulBlockRowsData {
+  float (*to)[3];
+  fmatrix3x3 *matrix;
+  const BlockRowIndex *rows;
+  lfVector *vector;
+} MulBlockRowsData;
+
+static void mul_bfmatrix_lfvector_rows_cb(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MulBlockRowsData *data = userdata;
+  const fmatrix3x3 *matrix = data->matrix;
+  const unsigned int *entries = data->rows->entries;
+  lfVector *vector = data->vector;
+  float sum[3];
+
+  mul_v3_m3v3(sum, matrix[i].m, vector[i]);
+
+  for (unsigned int j = data->rows->row_offsets[i]; j < data->rows->row_offsets[i + 1]; j++) {
+    const fmatrix3x3 *block = &matrix[entries[j] >> 1];
+    if (entries[j] & 1) {
+      muladd_fmatrixT_fvector(sum, block->m, vector[block->r]);
+    }
+    else {
+      muladd_fmatrix_fvector(sum, block->m, vector[block->c]);
+    }
+  }
+
+  copy_v3_v3(data->to[i], sum);
+}
+
+/* SPARSE SYMMETRIC multiply big matrix with long vector, using a row index of the blocks.
+ * Every row is written by one task only, so no synchronization is needed. */
+static void mul_bfmatrix_lfvector_rows(float (*to)[3],
+                                       fmatrix3x3 *from,
+                                       const BlockRowIndex *rows,
+                                       lfVector *fLongVector)
+{
+  BLI_assert(rows->vcount == from[0].vcount);
+
+  MulBlockRowsData data = {to, from, rows, fLongVector};
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (from[0].vcount >= CLOTH_PARALLEL_LIMIT);
+  settings.min_iter_per_thread = CLOTH_PARALLEL_CHUNK;
+  BLI_task_parallel_range(0, (int)from[0].vcount, &data, mul_bfmatrix_lfvector_rows_cb, &settings);
+}
+
 /* SPARSE SYMMETRIC sub big matrix with big matrix*/
 /* A -= B * float + C * float --> for big matrix */
 /* VERIFIED */
@@ -683,6 +837,10 @@ typedef struct Implicit_Data {
   lfVector *z;          /* target velocity in constrained directions */
   fmatrix3x3 *S;        /* filtering matrix for constraints */
   fmatrix3x3 *P, *Pinv; /* pre-conditioning matrix */
+
+  /* Spring blocks by row, shared by all matrices (rebuilt when springs change). */
+  BlockRowIndex block_rows;
+  bool block_rows_dirty;
 } Implicit_Data;
 
 Implicit_Data *SIM_mass_spring_solver_create(int numverts, int numsprings)
@@ -710,6 +868,8 @@ Implicit_Data *SIM_mass_spring_solver_create(int numverts, int numsprings)
 
   initdiag_bfmatrix(id->bigI, I);
 
+  id->block_rows_dirty = true;
+
   return id;
 }
 
@@ -734,6 +894,8 @@ void SIM_mass_spring_solver_free(Implicit_Data *id)
   del_lfvector(id->dV);
   del_lfvector(id->z);
 
+  block_row_index_free(&id->block_rows);
+
   MEM_freeN(id);
 }
 
@@ -850,8 +1012,77 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 }
 #  endif
 
+/* Jacobi pre-conditioner. A scalar per vertex is used rather than the inverse of the diagonal
+ * blocks, so that it commutes with the constraint filter of each vertex. */
+static float *cg_jacobi_preconditioner(fmatrix3x3 *lA)
+{
+  unsigned int numverts = lA[0].vcount;
+  float *Pinv = MEM_mallocN(sizeof(float) * numverts, __func__);
+
+  for (unsigned int i = 0; i < numverts; i++) {
+    const float diag = (lA[i].m[0][0] + lA[i].m[1][1] + lA[i].m[2][2]) / 3.0f;
+    Pinv[i] = (diag > FLT_EPSILON) ? 1.0f / diag : 1.0f;
+  }
+
+  return Pinv;
+}
+
+/* to = P^-1 * from */
+DO_INLINE void mul_precond_lfvector(float (*to)[3],
+                                    const float *Pinv,
+                                    float (*from)[3],
+                                    unsigned int verts)
+{
+  for (unsigned int i = 0; i < verts; i++) {
+    mul_v3_v3fl(to[i], from[i], Pinv[i]);
+  }
+}
+
+typedef struct CGStepData {
+  float (*ldV)[3], (*r)[3], (*c)[3], (*q)[3], (*s)[3];
+  const float *Pinv;
+  float alpha;
+  unsigned int verts;
+  float *chunk_sums;
+} CGStepData;
+
+static void cg_step_chunk_cb(void *__restrict userdata,
+                             const int chunk,
+                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGStepData *data = userdata;
+  const unsigned int start = (unsigned int)chunk * CLOTH_PARALLEL_CHUNK;
+  const unsigned int end = MIN2(start + CLOTH_PARALLEL_CHUNK, data->verts);
+  float delta = 0.0f;
+
+  for (unsigned int i = start; i < end; i++) {
+    /* dV += alpha * c, r -= alpha * q, s = P^-1 * r */
+    madd_v3_v3fl(data->ldV[i], data->c[i], data->alpha);
+    madd_v3_v3fl(data->r[i], data->q[i], -data->alpha);
+    mul_v3_v3fl(data->s[i], data->r[i], data->Pinv[i]);
+    delta += dot_v3v3(data->r[i], data->s[i]);
+  }
+
+  data->chunk_sums[chunk] = delta;
+}
+
+/* Update solution and residual of one CG iteration, returning the new r^T * P^-1 * r.
+ * The vector updates and the dot product are fused into a single pass over the data. */
+static float cg_step_update(CGStepData *data)
+{
+  const int num_chunks = num_parallel_chunks(data->verts);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (data->verts >= CLOTH_PARALLEL_LIMIT);
+  BLI_task_parallel_range(0, num_chunks, data, cg_step_chunk_cb, &settings);
+
+  return sum_chunks(data->chunk_sums, num_chunks);
+}
+
 static int cg_filtered(lfVector *ldV,
                        fmatrix3x3 *lA,
+                       const BlockRowIndex *rows,
                        lfVector *lB,
                        lfVector *z,
                        fmatrix3x3 *S,
@@ -868,23 +1099,26 @@ static int cg_filtered(lfVector *ldV,
   lfVector *c = create_lfvector(numverts);
   lfVector *q = create_lfvector(numverts);
   lfVector *s = create_lfvector(numverts);
+  float *Pinv = cg_jacobi_preconditioner(lA);
+  float *chunk_sums = MEM_mallocN(sizeof(float) * num_parallel_chunks(numverts), __func__);
   float bnorm2, delta_new, delta_old, delta_target, alpha;
 
   cp_lfvector(ldV, z, numverts);
 
-  /* d0 = filter(B)^T * P * filter(B) */
+  /* d0 = filter(B)^T * P^-1 * filter(B) */
   cp_lfvector(fB, lB, numverts);
   filter(fB, S);
-  bnorm2 = dot_lfvector(fB, fB, numverts);
+  mul_precond_lfvector(AdV, Pinv, fB, numverts);
+  bnorm2 = dot_lfvector(fB, AdV, numverts);
   delta_target = conjgrad_epsilon * conjgrad_epsilon * bnorm2;
 
   /* r = filter(B - A * dV) */
-  mul_bfmatrix_lfvector(AdV, lA, ldV);
+  mul_bfmatrix_lfvector_rows(AdV, lA, rows, ldV);
   sub_lfvector_lfvector(r, lB, AdV, numverts);
   filter(r, S);
 
   /* c = filter(P^-1 * r) */
-  cp_lfvector(c, r, numverts);
+  mul_precond_lfvector(c, Pinv, r, numverts);
   filter(c, S);
 
   /* delta = r^T * c */
@@ -901,20 +1135,18 @@ static int cg_filtered(lfVector *ldV,
   print_bfmatrix(S);
 #  endif
 
+  CGStepData step_data = {ldV, r, c, q, s, Pinv, 0.0f, numverts, chunk_sums};
+
   while (delta_new > delta_target && conjgrad_loopcount < conjgrad_looplimit) {
-    mul_bfmatrix_lfvector(q, lA, c);
+    mul_bfmatrix_lfvector_rows(q, lA, rows, c);
     filter(q, S);
 
     alpha = delta_new / dot_lfvector(c, q, numverts);
 
-    add_lfvector_lfvectorS(ldV, ldV, c, alpha, numverts);
-
-    add_lfvector_lfvectorS(r, r, q, -alpha, numverts);
-
-    /* s = P^-1 * r */
-    cp_lfvector(s, r, numverts);
+    /* dV += alpha * c, r -= alpha * q, s = P^-1 * r */
+    step_data.alpha = alpha;
     delta_old = delta_new;
-    delta_new = dot_lfvector(r, s, numverts);
+    delta_new = cg_step_update(&step_data);
 
     add_lfvector_lfvectorS(c, s, c, delta_new / delta_old, numverts);
     filter(c, S);
@@ -934,6 +1166,8 @@ static int cg_filtered(lfVector *ldV,
   del_lfvector(c);
   del_lfvector(q);
   del_lfvector(s);
+  MEM_freeN(Pinv);
+  MEM_freeN(chunk_sums);
   // printf("W/O conjgrad_loopcount: %d\n", conjgrad_loopcount);
 
   result->status = conjgrad_loopcount < conjgrad_looplimit ? SIM_SOLVER_SUCCESS :
@@ -1162,7 +1396,14 @@ bool SIM_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 
   subadd_bfmatrixS_bfmatrixS(data->A, data->dFdV, dt, data->dFdX, (dt * dt));
 
-  mul_bfmatrix_lfvector(dFdXmV, data->dFdX, data->V);
+  /* The spring blocks are added in the same order every step unless springs change,
+   * so the row index can usually be reused. */
+  if (data->block_rows_dirty || data->block_rows.num_blocks != (unsigned int)data->num_blocks) {
+    block_row_index_build(&data->block_rows, data->A, data->num_blocks);
+    data->block_rows_dirty = false;
+  }
+
+  mul_bfmatrix_lfvector_rows(dFdXmV, data->dFdX, &data->block_rows, data->V);
 
   add_lfvectorS_lfvectorS(data->B, data->F, dt, dFdXmV, (dt * dt), numverts);
 
@@ -1171,7 +1412,7 @@ bool SIM_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 #  endif
 
   /* Conjugate gradient algorithm to solve Ax=b. */
-  cg_filtered(data->dV, data->A, data->B, data->z, data->S, result);
+  cg_filtered(data->dV, data->A, &data->block_rows, data->B, data->z, data->S, result);
 
   // cg_filtered_pre(id->dV, id->A, id->B, id->z, id->S, id->P, id->Pinv, id->bigI);
 
@@ -1291,6 +1532,10 @@ static int SIM_mass_spring_add_block(Implicit_Data *data, int v1, int v2)
   BLI_assert(s < data->M[0].vcount + data->M[0].scount);
   ++data->num_blocks;
 
+  if (data->M[s].r != (unsigned int)v1 || data->M[s].c != (unsigned int)v2) {
+    data->block_rows_dirty = true;
+  }
+
   /* tfm and S don't have spring entries (diagonal blocks only) */
   init_fmatrix(data->bigI + s, v1, v2);
   init_fmatrix(data->M + s, v1, v2);